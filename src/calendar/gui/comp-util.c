@@ -947,15 +947,6 @@ typedef struct _AsyncContext {
 	gboolean do_copy;
 } AsyncContext;
 
-struct ForeachTzidData
-{
-	ECalClient *source_client;
-	ECalClient *destination_client;
-	GCancellable *cancellable;
-	GError **error;
-	gboolean success;
-};
-
 static void
 async_context_free (AsyncContext *async_context)
 {
@@ -969,32 +960,61 @@ async_context_free (AsyncContext *async_context)
 }
 
 static void
-add_timezone_to_cal_cb (icalparameter *param,
-                        gpointer data)
+collect_tzids_cb (icalparameter *param,
+		  gpointer user_data)
 {
-	struct ForeachTzidData *ftd = data;
-	icaltimezone *tz = NULL;
+	GHashTable *tzids = user_data;
 	const gchar *tzid;
 
-	g_return_if_fail (ftd != NULL);
-	g_return_if_fail (ftd->source_client != NULL);
-	g_return_if_fail (ftd->destination_client != NULL);
+	tzid = icalparameter_get_tzid (param);
+	if (tzid && *tzid && !g_hash_table_contains (tzids, tzid))
+		g_hash_table_add (tzids, g_strdup (tzid));
+}
 
-	if (!ftd->success)
-		return;
+/* Reads which of the @events already exist in the @client,
+   asking for several of them with one request. */
+static gboolean
+cal_comp_read_existing_uids_sync (ECalClient *client,
+				  GSList *events,
+				  GHashTable *existing_uids,
+				  GCancellable *cancellable,
+				  GError **error)
+{
+	GSList *link = events;
 
-	if (ftd->cancellable && g_cancellable_is_cancelled (ftd->cancellable)) {
-		ftd->success = FALSE;
-		return;
-	}
+	while (link) {
+		GSList *objects = NULL, *olink;
+		GString *sexp;
+		gint ii;
 
-	tzid = icalparameter_get_tzid (param);
-	if (!tzid || !*tzid)
-		return;
+		sexp = g_string_new ("(or");
+
+		for (ii = 0; link && ii < 100; link = g_slist_next (link), ii++) {
+			g_string_append (sexp, " (uid? ");
+			e_sexp_encode_string (sexp, icalcomponent_get_uid (link->data));
+			g_string_append_c (sexp, ')');
+		}
 
-	if (e_cal_client_get_timezone_sync (ftd->source_client, tzid, &tz, ftd->cancellable, NULL) && tz)
-		ftd->success = e_cal_client_add_timezone_sync (
-				ftd->destination_client, tz, ftd->cancellable, ftd->error);
+		g_string_append_c (sexp, ')');
+
+		if (!e_cal_client_get_object_list_sync (client, sexp->str, &objects, cancellable, error)) {
+			g_string_free (sexp, TRUE);
+			return FALSE;
+		}
+
+		g_string_free (sexp, TRUE);
+
+		for (olink = objects; olink; olink = g_slist_next (olink)) {
+			const gchar *uid = icalcomponent_get_uid (olink->data);
+
+			if (uid && !g_hash_table_contains (existing_uids, uid))
+				g_hash_table_add (existing_uids, g_strdup (uid));
+		}
+
+		e_cal_client_free_icalcomp_slist (objects);
+	}
+
+	return TRUE;
 }
 
 /* Helper for cal_comp_transfer_item_to() */
@@ -1083,23 +1103,54 @@ cal_comp_transfer_item_to_sync (ECalClient *src_client,
                                 GCancellable *cancellable,
                                 GError **error)
 {
-	icalcomponent *icalcomp;
-	icalcomponent *icalcomp_event, *subcomp;
+	GSList single = { 0, };
+
+	g_return_val_if_fail (icalcomp_vcal != NULL, FALSE);
+
+	single.data = icalcomp_vcal;
+
+	return cal_comp_transfer_items_to_sync (src_client, dest_client, &single, do_copy, cancellable, error);
+}
+
+/**
+ * cal_comp_transfer_items_to_sync:
+ * @src_client: an #ECalClient to transfer the items from
+ * @dest_client: an #ECalClient to transfer the items to
+ * @icalcomps_vcal: a #GSList of icalcomponent-s to transfer
+ * @do_copy: whether to copy (%TRUE) or move (%FALSE) the items
+ * @cancellable: optional #GCancellable object, or %NULL
+ * @error: return location for a #GError, or %NULL
+ *
+ * Copies or moves all the @icalcomps_vcal from the @src_client
+ * to the @dest_client, like cal_comp_transfer_item_to_sync(), only
+ * the items are created, modified and removed with bulk requests and
+ * each used timezone is added to the @dest_client only once.
+ *
+ * Returns: Whether succeeded
+ **/
+gboolean
+cal_comp_transfer_items_to_sync (ECalClient *src_client,
+				 ECalClient *dest_client,
+				 const GSList *icalcomps_vcal,
+				 gboolean do_copy,
+				 GCancellable *cancellable,
+				 GError **error)
+{
 	icalcomponent_kind icalcomp_kind;
-	const gchar *uid;
-	gchar *new_uid = NULL;
-	struct ForeachTzidData ftd;
 	ECalClientSourceType source_type;
-	GHashTable *processed_uids;
+	GHashTable *processed_uids, *existing_uids, *tzids;
+	GHashTableIter iter;
+	gpointer key;
+	GSList *events = NULL, *owned = NULL;
+	GSList *to_create = NULL, *to_modify = NULL, *to_modify_detached = NULL;
+	GSList *remove_ids_all = NULL, *remove_ids_this = NULL;
+	const GSList *link;
+	GSList *elink;
 	gboolean same_client;
-	gboolean success = FALSE;
+	gboolean success = TRUE;
 
 	g_return_val_if_fail (E_IS_CAL_CLIENT (src_client), FALSE);
 	g_return_val_if_fail (E_IS_CAL_CLIENT (dest_client), FALSE);
-	g_return_val_if_fail (icalcomp_vcal != NULL, FALSE);
-
-	icalcomp_event = icalcomponent_get_inner (icalcomp_vcal);
-	g_return_val_if_fail (icalcomp_event != NULL, FALSE);
 
 	source_type = e_cal_client_get_source_type (src_client);
 	switch (source_type) {
@@ -1119,58 +1170,59 @@ cal_comp_transfer_item_to_sync (ECalClient *src_client,
 	same_client = src_client == dest_client || e_source_equal (
 		e_client_get_source (E_CLIENT (src_client)), e_client_get_source (E_CLIENT (dest_client)));
 	processed_uids = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+	existing_uids = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+	tzids = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+
+	/* Pick one component per UID */
+	for (link = icalcomps_vcal; link; link = g_slist_next (link)) {
+		icalcomponent *icalcomp_vcal = link->data, *icalcomp_event;
+
+		icalcomp_event = icalcomponent_get_first_component (icalcomp_vcal, icalcomp_kind);
+		/*
+		 * This check should be removed in the near future.
+		 * We should be able to work properly with multiselection, which means that we always
+		 * will receive a component with subcomponents.
+		 */
+		if (icalcomp_event == NULL)
+			icalcomp_event = icalcomp_vcal;
+		for (;
+		     icalcomp_event;
+		     icalcomp_event = icalcomponent_get_next_component (icalcomp_vcal, icalcomp_kind)) {
+			const gchar *uid = icalcomponent_get_uid (icalcomp_event);
+
+			if (!uid || g_hash_table_contains (processed_uids, uid))
+				continue;
 
-	icalcomp_event = icalcomponent_get_first_component (icalcomp_vcal, icalcomp_kind);
-	/*
-	 * This check should be removed in the near future.
-	 * We should be able to work properly with multiselection, which means that we always
-	 * will receive a component with subcomponents.
-	 */
-	if (icalcomp_event == NULL)
-		icalcomp_event = icalcomp_vcal;
-	for (;
-	     icalcomp_event;
-	     icalcomp_event = icalcomponent_get_next_component (icalcomp_vcal, icalcomp_kind)) {
-		GError *local_error = NULL;
+			g_hash_table_add (processed_uids, g_strdup (uid));
+			events = g_slist_prepend (events, icalcomp_event);
+		}
+	}
 
-		uid = icalcomponent_get_uid (icalcomp_event);
+	events = g_slist_reverse (events);
 
-		if (g_hash_table_lookup (processed_uids, uid))
-			continue;
+	if (!do_copy || !same_client)
+		success = cal_comp_read_existing_uids_sync (dest_client, events, existing_uids, cancellable, error);
 
-		if (do_copy && same_client)
-			success = FALSE;
-		else
-			success = e_cal_client_get_object_sync (dest_client, uid, NULL, &icalcomp, cancellable, &local_error);
-		if (success) {
-			success = e_cal_client_modify_object_sync (
-				dest_client, icalcomp_event, E_CAL_OBJ_MOD_ALL, cancellable, error);
-
-			icalcomponent_free (icalcomp);
-			if (!success)
-				goto exit;
+	for (elink = events; elink && success; elink = g_slist_next (elink)) {
+		icalcomponent *icalcomp_event = elink->data, *icalcomp, *subcomp;
+		const gchar *uid = icalcomponent_get_uid (icalcomp_event);
 
-			if (!do_copy) {
-				ECalObjModType mod_type = E_CAL_OBJ_MOD_THIS;
+		if (!do_copy) {
+			ECalComponentId *id;
 
-				/* Remove the item from the source calendar. */
-				if (e_cal_util_component_is_instance (icalcomp_event) ||
-				    e_cal_util_component_has_recurrences (icalcomp_event))
-					mod_type = E_CAL_OBJ_MOD_ALL;
+			id = e_cal_component_id_new (uid, NULL);
 
-				success = e_cal_client_remove_object_sync (
-						src_client, uid, NULL, mod_type, cancellable, error);
-				if (!success)
-					goto exit;
-			}
+			/* Remove the item from the source calendar. */
+			if (e_cal_util_component_is_instance (icalcomp_event) ||
+			    e_cal_util_component_has_recurrences (icalcomp_event))
+				remove_ids_all = g_slist_prepend (remove_ids_all, id);
+			else
+				remove_ids_this = g_slist_prepend (remove_ids_this, id);
+		}
 
+		if (g_hash_table_contains (existing_uids, uid)) {
+			to_modify = g_slist_prepend (to_modify, icalcomp_event);
 			continue;
-		} else if (local_error != NULL && !g_error_matches (
-					local_error, E_CAL_CLIENT_ERROR, E_CAL_CLIENT_ERROR_OBJECT_NOT_FOUND)) {
-			g_propagate_error (error, local_error);
-			goto exit;
-		} else {
-			g_clear_error (&local_error);
 		}
 
 		if (e_cal_util_component_is_instance (icalcomp_event)) {
@@ -1179,7 +1231,7 @@ cal_comp_transfer_item_to_sync (ECalClient *src_client,
 
 			success = e_cal_client_get_objects_for_uid_sync (src_client, uid, &ecalcomps, cancellable, error);
 			if (!success)
-				goto exit;
+				break;
 
 			if (ecalcomps && !ecalcomps->next) {
 				/* only one component, no need for a vCalendar list */
@@ -1201,115 +1253,108 @@ cal_comp_transfer_item_to_sync (ECalClient *src_client,
 			icalcomp = icalcomponent_new_clone (icalcomp_event);
 		}
 
-		if (do_copy) {
-			/* Change the UID to avoid problems with duplicated UID */
-			new_uid = e_util_generate_uid ();
-			if (icalcomponent_isa (icalcomp) == ICAL_VCALENDAR_COMPONENT) {
-				/* in case of a vCalendar, the component might have detached instances,
-				 * thus change the UID on all of the subcomponents of it */
-				for (subcomp = icalcomponent_get_first_component (icalcomp, icalcomp_kind);
-				     subcomp;
-				     subcomp = icalcomponent_get_next_component (icalcomp, icalcomp_kind)) {
-					icalcomponent_set_uid (subcomp, new_uid);
-				}
-			} else {
-				icalcomponent_set_uid (icalcomp, new_uid);
-			}
-			g_free (new_uid);
-			new_uid = NULL;
-		}
-
-		ftd.source_client = src_client;
-		ftd.destination_client = dest_client;
-		ftd.cancellable = cancellable;
-		ftd.error = error;
-		ftd.success = TRUE;
-
-		if (icalcomponent_isa (icalcomp) == ICAL_VCALENDAR_COMPONENT) {
-			/* in case of a vCalendar, the component might have detached instances,
-			 * thus check timezones on all of the subcomponents of it */
-			for (subcomp = icalcomponent_get_first_component (icalcomp, icalcomp_kind);
-			     subcomp && ftd.success;
-			     subcomp = icalcomponent_get_next_component (icalcomp, icalcomp_kind)) {
-				icalcomponent_foreach_tzid (subcomp, add_timezone_to_cal_cb, &ftd);
-			}
-		} else {
-			icalcomponent_foreach_tzid (icalcomp, add_timezone_to_cal_cb, &ftd);
-		}
-
-		if (!ftd.success) {
-			success = FALSE;
-			goto exit;
-		}
+		owned = g_slist_prepend (owned, icalcomp);
 
 		if (icalcomponent_isa (icalcomp) == ICAL_VCALENDAR_COMPONENT) {
+			gchar *new_uid = do_copy ? e_util_generate_uid () : NULL;
 			gboolean did_add = FALSE;
 
 			/* in case of a vCalendar, the component might have detached instances,
-			 * thus add the master object first, and then all of the subcomponents of it */
+			 * thus change the UID on all of the subcomponents of it and check their
+			 * timezones; the master object is created first, and then all of the
+			 * detached instances are stored into it */
 			for (subcomp = icalcomponent_get_first_component (icalcomp, icalcomp_kind);
-			     subcomp && !did_add;
+			     subcomp;
 			     subcomp = icalcomponent_get_next_component (icalcomp, icalcomp_kind)) {
-				if (icaltime_is_null_time (icalcomponent_get_recurrenceid (subcomp))) {
+				if (new_uid)
+					icalcomponent_set_uid (subcomp, new_uid);
+
+				icalcomponent_foreach_tzid (subcomp, collect_tzids_cb, tzids);
+
+				if (!did_add && icaltime_is_null_time (icalcomponent_get_recurrenceid (subcomp))) {
 					did_add = TRUE;
-					success = e_cal_client_create_object_sync (
-						dest_client, subcomp,
-						&new_uid, cancellable, error);
-					g_free (new_uid);
+					to_create = g_slist_prepend (to_create, subcomp);
 				}
 			}
 
-			if (!success) {
-				icalcomponent_free (icalcomp);
-				goto exit;
-			}
-
-			/* deal with detached instances */
 			for (subcomp = icalcomponent_get_first_component (icalcomp, icalcomp_kind);
-			     subcomp && success;
+			     subcomp;
 			     subcomp = icalcomponent_get_next_component (icalcomp, icalcomp_kind)) {
 				if (!icaltime_is_null_time (icalcomponent_get_recurrenceid (subcomp))) {
 					if (did_add) {
-						success = e_cal_client_modify_object_sync (
-							dest_client, subcomp,
-							E_CAL_OBJ_MOD_THIS, cancellable, error);
+						to_modify_detached = g_slist_prepend (to_modify_detached, subcomp);
 					} else {
 						/* just in case there are only detached instances and no master object */
 						did_add = TRUE;
-						success = e_cal_client_create_object_sync (
-							dest_client, subcomp,
-							&new_uid, cancellable, error);
-						g_free (new_uid);
+						to_create = g_slist_prepend (to_create, subcomp);
 					}
 				}
 			}
-		} else {
-			success = e_cal_client_create_object_sync (dest_client, icalcomp, &new_uid, cancellable, error);
+
 			g_free (new_uid);
-		}
+		} else {
+			if (do_copy) {
+				/* Change the UID to avoid problems with duplicated UID */
+				gchar *new_uid = e_util_generate_uid ();
+				icalcomponent_set_uid (icalcomp, new_uid);
+				g_free (new_uid);
+			}
 
-		icalcomponent_free (icalcomp);
-		if (!success)
-			goto exit;
+			icalcomponent_foreach_tzid (icalcomp, collect_tzids_cb, tzids);
+			to_create = g_slist_prepend (to_create, icalcomp);
+		}
+	}
 
-		if (!do_copy) {
-			ECalObjModType mod_type = E_CAL_OBJ_MOD_THIS;
+	to_create = g_slist_reverse (to_create);
+	to_modify = g_slist_reverse (to_modify);
+	to_modify_detached = g_slist_reverse (to_modify_detached);
+	remove_ids_all = g_slist_reverse (remove_ids_all);
+	remove_ids_this = g_slist_reverse (remove_ids_this);
 
-			/* Remove the item from the source calendar. */
-			if (e_cal_util_component_is_instance (icalcomp_event) ||
-			    e_cal_util_component_has_recurrences (icalcomp_event))
-				mod_type = E_CAL_OBJ_MOD_ALL;
+	/* Each timezone is added only once for all the components */
+	g_hash_table_iter_init (&iter, tzids);
+	while (success && g_hash_table_iter_next (&iter, &key, NULL)) {
+		icaltimezone *tz = NULL;
 
-			success = e_cal_client_remove_object_sync (src_client, uid, NULL, mod_type, cancellable, error);
-			if (!success)
-				goto exit;
+		if (g_cancellable_set_error_if_cancelled (cancellable, error)) {
+			success = FALSE;
+			break;
 		}
 
-		g_hash_table_insert (processed_uids, g_strdup (uid), GINT_TO_POINTER (1));
+		if (e_cal_client_get_timezone_sync (src_client, key, &tz, cancellable, NULL) && tz)
+			success = e_cal_client_add_timezone_sync (dest_client, tz, cancellable, error);
 	}
 
- exit:
+	if (success && to_create) {
+		GSList *new_uids = NULL;
+
+		success = e_cal_client_create_objects_sync (dest_client, to_create, &new_uids, cancellable, error);
+
+		e_client_util_free_string_slist (new_uids);
+	}
+
+	if (success && to_modify)
+		success = e_cal_client_modify_objects_sync (dest_client, to_modify, E_CAL_OBJ_MOD_ALL, cancellable, error);
+
+	if (success && to_modify_detached)
+		success = e_cal_client_modify_objects_sync (dest_client, to_modify_detached, E_CAL_OBJ_MOD_THIS, cancellable, error);
+
+	if (success && remove_ids_all)
+		success = e_cal_client_remove_objects_sync (src_client, remove_ids_all, E_CAL_OBJ_MOD_ALL, cancellable, error);
+
+	if (success && remove_ids_this)
+		success = e_cal_client_remove_objects_sync (src_client, remove_ids_this, E_CAL_OBJ_MOD_THIS, cancellable, error);
+
+	g_slist_free_full (remove_ids_all, (GDestroyNotify) e_cal_component_free_id);
+	g_slist_free_full (remove_ids_this, (GDestroyNotify) e_cal_component_free_id);
+	g_slist_free (to_create);
+	g_slist_free (to_modify);
+	g_slist_free (to_modify_detached);
+	g_slist_free_full (owned, (GDestroyNotify) icalcomponent_free);
+	g_slist_free (events);
 	g_hash_table_destroy (processed_uids);
+	g_hash_table_destroy (existing_uids);
+	g_hash_table_destroy (tzids);
 
 	return success;
 }
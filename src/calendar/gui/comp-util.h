@@ -122,6 +122,12 @@ gboolean cal_comp_transfer_item_to_sync		(ECalClient *src_client,
 						 gboolean do_copy,
 						 GCancellable *cancellable,
 						 GError **error);
+gboolean cal_comp_transfer_items_to_sync		(ECalClient *src_client,
+						 ECalClient *dest_client,
+						 const GSList *icalcomps_vcal,
+						 gboolean do_copy,
+						 GCancellable *cancellable,
+						 GError **error);
 void		cal_comp_util_update_tzid_parameter
 						(icalproperty *prop,
 						 const struct icaltimetype tt);
@@ -42,8 +42,18 @@ struct _ECalModelTasksPrivate {
 	gchar *color_due_today;
 	gboolean highlight_overdue;
 	gchar *color_overdue;
+
+	/* Times when a cached due status changes, sorted by the time */
+	GSequence *due_transitions; /* DueTransition * */
+	GHashTable *due_transitions_index; /* ECalModelComponent * ~> GSequenceIter * in due_transitions */
+	guint due_transitions_timeout_id;
 };
 
+typedef struct _DueTransition {
+	time_t when;
+	gconstpointer comp_data; /* ECalModelComponent *, only compared, never dereferenced */
+} DueTransition;
+
 enum {
 	PROP_0,
 	PROP_HIGHLIGHT_DUE_TODAY,
@@ -318,12 +328,132 @@ typedef enum {
 	E_CAL_MODEL_TASKS_DUE_COMPLETE
 } ECalModelTasksDueStatus;
 
+static gboolean
+cal_model_tasks_due_transitions_timeout_cb (gpointer user_data)
+{
+	ECalModelTasks *model = user_data;
+
+	model->priv->due_transitions_timeout_id = 0;
+
+	e_cal_model_tasks_update_due_tasks (model);
+
+	return FALSE;
+}
+
+/* Plans a wake up for the first time in the transition queue */
+static void
+cal_model_tasks_schedule_due_transitions (ECalModelTasks *model)
+{
+	GSequenceIter *iter;
+	DueTransition *transition;
+	time_t now;
+	guint delay;
+
+	if (model->priv->due_transitions_timeout_id) {
+		g_source_remove (model->priv->due_transitions_timeout_id);
+		model->priv->due_transitions_timeout_id = 0;
+	}
+
+	iter = g_sequence_get_begin_iter (model->priv->due_transitions);
+	if (g_sequence_iter_is_end (iter))
+		return;
+
+	transition = g_sequence_get (iter);
+	now = time (NULL);
+
+	if (transition->when <= now)
+		delay = 0;
+	else if (transition->when - now > 24 * 60 * 60)
+		delay = 24 * 60 * 60;
+	else
+		delay = transition->when - now;
+
+	/* One more second, thus the transition time is passed */
+	model->priv->due_transitions_timeout_id = e_named_timeout_add_seconds (
+		delay + 1, cal_model_tasks_due_transitions_timeout_cb, model);
+}
+
+static gint
+due_transition_compare (gconstpointer ptr1,
+                        gconstpointer ptr2,
+                        gpointer user_data)
+{
+	const DueTransition *transition1 = ptr1, *transition2 = ptr2;
+
+	if (transition1->when == transition2->when)
+		return 0;
+
+	return transition1->when < transition2->when ? -1 : 1;
+}
+
+static void
+cal_model_tasks_remove_due_transition (ECalModelTasks *model,
+                                       ECalModelComponent *comp_data)
+{
+	GSequenceIter *iter;
+
+	iter = g_hash_table_lookup (model->priv->due_transitions_index, comp_data);
+	if (!iter)
+		return;
+
+	g_hash_table_remove (model->priv->due_transitions_index, comp_data);
+	g_sequence_remove (iter);
+}
+
+/* Each component has at most one transition, the one of its current due status */
+static void
+cal_model_tasks_add_due_transition (ECalModelTasks *model,
+                                    ECalModelComponent *comp_data,
+                                    time_t when)
+{
+	DueTransition *transition;
+	GSequenceIter *iter;
+
+	cal_model_tasks_remove_due_transition (model, comp_data);
+
+	transition = g_slice_new (DueTransition);
+	transition->when = when;
+	transition->comp_data = comp_data;
+
+	iter = g_sequence_insert_sorted (model->priv->due_transitions, transition, due_transition_compare, NULL);
+	g_hash_table_insert (model->priv->due_transitions_index, comp_data, iter);
+
+	if (g_sequence_iter_is_begin (iter))
+		cal_model_tasks_schedule_due_transitions (model);
+}
+
+static void
+due_transition_free (gpointer ptr)
+{
+	g_slice_free (DueTransition, ptr);
+}
+
+static time_t
+get_day_start (struct icaltimetype tt,
+               gint add_days,
+               icaltimezone *zone)
+{
+	tt.is_date = 0;
+	tt.hour = 0;
+	tt.minute = 0;
+	tt.second = 0;
+
+	icaltime_adjust (&tt, add_days, 0, 0, 0);
+
+	return icaltime_as_timet_with_zone (tt, zone);
+}
+
+/* Computes the due status of the component, and the time when
+ * it changes next, or 0 when it cannot change by time. */
 static ECalModelTasksDueStatus
-get_due_status (ECalModelTasks *model,
-                ECalModelComponent *comp_data)
+compute_due_status (ECalModelTasks *model,
+                    ECalModelComponent *comp_data,
+                    time_t *out_until)
 {
 	icalproperty *prop;
 
+	*out_until = 0;
+
 	/* First, do we have a due date? */
 	prop = icalcomponent_get_first_property (comp_data->icalcomp, ICAL_DUE_PROPERTY);
 	if (!prop)
@@ -341,15 +471,20 @@ get_due_status (ECalModelTasks *model,
 		if (due_tt.is_date) {
 			gint cmp;
 
-			now_tt = icaltime_current_time_with_zone (e_cal_model_get_timezone (E_CAL_MODEL (model)));
+			zone = e_cal_model_get_timezone (E_CAL_MODEL (model));
+			now_tt = icaltime_current_time_with_zone (zone);
 			cmp = icaltime_compare_date_only (due_tt, now_tt);
 
 			if (cmp < 0)
 				return E_CAL_MODEL_TASKS_DUE_OVERDUE;
-			else if (cmp == 0)
+
+			if (cmp == 0) {
+				*out_until = get_day_start (due_tt, 1, zone);
 				return E_CAL_MODEL_TASKS_DUE_TODAY;
-			else
-				return E_CAL_MODEL_TASKS_DUE_FUTURE;
+			}
+
+			*out_until = get_day_start (due_tt, 0, zone);
+			return E_CAL_MODEL_TASKS_DUE_FUTURE;
 		} else {
 			icalparameter *param;
 			const gchar *tzid;
@@ -368,15 +503,44 @@ get_due_status (ECalModelTasks *model,
 
 			if (icaltime_compare (due_tt, now_tt) <= 0)
 				return E_CAL_MODEL_TASKS_DUE_OVERDUE;
-			else
-				if (icaltime_compare_date_only (due_tt, now_tt) == 0)
-					return E_CAL_MODEL_TASKS_DUE_TODAY;
-				else
-					return E_CAL_MODEL_TASKS_DUE_FUTURE;
+
+			if (icaltime_compare_date_only (due_tt, now_tt) == 0) {
+				*out_until = icaltime_as_timet_with_zone (due_tt, zone);
+				return E_CAL_MODEL_TASKS_DUE_TODAY;
+			}
+
+			*out_until = get_day_start (due_tt, 0, zone);
+			return E_CAL_MODEL_TASKS_DUE_FUTURE;
 		}
 	}
 }
 
+static ECalModelTasksDueStatus
+get_due_status (ECalModelTasks *model,
+                ECalModelComponent *comp_data)
+{
+	ECalModelTasksDueStatus status;
+	time_t until = 0;
+
+	/* The status is computed once and reused until its transition time */
+	if (comp_data->due_status != -1 && (!comp_data->due_status_until ||
+	    time (NULL) < comp_data->due_status_until))
+		return comp_data->due_status;
+
+	status = compute_due_status (model, comp_data, &until);
+
+	comp_data->due_status = status;
+	comp_data->due_status_until = until;
+
+	/* Replaces the transition of the previous status, like when the component changed */
+	if (until)
+		cal_model_tasks_add_due_transition (model, comp_data, until);
+	else
+		cal_model_tasks_remove_due_transition (model, comp_data);
+
+	return status;
+}
+
 static gboolean
 is_overdue (ECalModelTasks *model,
             ECalModelComponent *comp_data)
@@ -724,10 +888,26 @@ cal_model_tasks_finalize (GObject *object)
 	g_free (priv->color_due_today);
 	g_free (priv->color_overdue);
 
+	if (priv->due_transitions_timeout_id)
+		g_source_remove (priv->due_transitions_timeout_id);
+	g_hash_table_destroy (priv->due_transitions_index);
+	g_sequence_free (priv->due_transitions);
+
 	/* Chain up to parent's finalize() method. */
 	G_OBJECT_CLASS (e_cal_model_tasks_parent_class)->finalize (object);
 }
 
+static void
+cal_model_tasks_comps_deleted (ECalModel *model,
+                               gpointer list)
+{
+	ECalModelTasks *model_tasks = E_CAL_MODEL_TASKS (model);
+	GSList *link;
+
+	for (link = list; link; link = g_slist_next (link))
+		cal_model_tasks_remove_due_transition (model_tasks, link->data);
+}
+
 static const gchar *
 cal_model_tasks_get_color_for_component (ECalModel *model,
                                          ECalModelComponent *comp_data)
@@ -884,6 +1064,8 @@ cal_model_tasks_set_value_at (ETableModel *etm,
 	if (!comp_data)
 		return;
 
+	comp_data->due_status = -1;
+
 	switch (col) {
 	case E_CAL_MODEL_TASKS_FIELD_COMPLETED :
 		set_completed (model, comp_data, value);
@@ -1102,6 +1284,23 @@ cal_model_tasks_value_to_string (ETableModel *etm,
 	return g_strdup ("");
 }
 
+static void
+cal_model_tasks_timezone_changed_cb (ECalModel *model)
+{
+	gint row, row_count;
+
+	/* Due dates without time are compared in the model timezone */
+	row_count = e_table_model_row_count (E_TABLE_MODEL (model));
+
+	for (row = 0; row < row_count; row++) {
+		ECalModelComponent *comp_data;
+
+		comp_data = e_cal_model_get_component_at (model, row);
+		if (comp_data)
+			comp_data->due_status = -1;
+	}
+}
+
 static void
 e_cal_model_tasks_class_init (ECalModelTasksClass *class)
 {
@@ -1119,6 +1318,7 @@ e_cal_model_tasks_class_init (ECalModelTasksClass *class)
 	cal_model_class->get_color_for_component = cal_model_tasks_get_color_for_component;
 	cal_model_class->store_values_from_model = cal_model_tasks_store_values_from_model;
 	cal_model_class->fill_component_from_values = cal_model_tasks_fill_component_from_values;
+	cal_model_class->comps_deleted = cal_model_tasks_comps_deleted;
 
 	g_object_class_install_property (
 		object_class,
@@ -1187,9 +1387,15 @@ e_cal_model_tasks_init (ECalModelTasks *model)
 
 	model->priv->highlight_due_today = TRUE;
 	model->priv->highlight_overdue = TRUE;
+	model->priv->due_transitions = g_sequence_new (due_transition_free);
+	model->priv->due_transitions_index = g_hash_table_new (g_direct_hash, g_direct_equal);
 
 	e_cal_model_set_component_kind (
 		E_CAL_MODEL (model), ICAL_VTODO_COMPONENT);
+
+	g_signal_connect (
+		model, "notify::timezone",
+		G_CALLBACK (cal_model_tasks_timezone_changed_cb), NULL);
 }
 
 ECalModel *
@@ -1319,6 +1525,7 @@ e_cal_model_tasks_mark_comp_complete (ECalModelTasks *model,
 	/*e_table_model_pre_change (E_TABLE_MODEL (model));*/
 
 	ensure_task_complete (comp_data, -1);
+	comp_data->due_status = -1;
 
 	/*e_table_model_row_changed (E_TABLE_MODEL (model), model_row);*/
 
@@ -1365,30 +1572,68 @@ e_cal_model_tasks_mark_comp_incomplete (ECalModelTasks *model,
 		icalproperty_free (prop1);
 	}
 
+	comp_data->due_status = -1;
+
 	/*e_table_model_row_changed (E_TABLE_MODEL (model), model_row);*/
 
 	e_cal_model_modify_component (E_CAL_MODEL (model), comp_data, E_CAL_OBJ_MOD_ALL);
 }
 
+/**
+ * e_cal_model_tasks_update_due_tasks:
+ * @model: an #ECalModelTasks
+ *
+ * Notifies about changes of rows, whose due status changed by time
+ * since the last call. This is also done automatically when the first
+ * due status change is reached.
+ **/
 void
 e_cal_model_tasks_update_due_tasks (ECalModelTasks *model)
 {
-	gint row, row_count;
-	ECalModelComponent *comp_data;
-	ECalModelTasksDueStatus status;
+	GSequenceIter *iter;
+	GHashTable *changed;
+	time_t now;
 
 	g_return_if_fail (E_IS_CAL_MODEL_TASKS (model));
 
-	row_count = e_table_model_row_count (E_TABLE_MODEL (model));
+	changed = g_hash_table_new (g_direct_hash, g_direct_equal);
+	now = time (NULL);
+
+	iter = g_sequence_get_begin_iter (model->priv->due_transitions);
+	while (!g_sequence_iter_is_end (iter)) {
+		DueTransition *transition = g_sequence_get (iter);
+
+		if (transition->when > now)
+			break;
+
+		g_hash_table_add (changed, (gpointer) transition->comp_data);
+
+		g_hash_table_remove (model->priv->due_transitions_index, transition->comp_data);
+		g_sequence_remove (iter);
+		iter = g_sequence_get_begin_iter (model->priv->due_transitions);
+	}
 
-	for (row = 0; row < row_count; row++)
-	{
-		comp_data = e_cal_model_get_component_at (E_CAL_MODEL (model), row);
-		status = get_due_status (E_CAL_MODEL_TASKS (model), comp_data);
-		if ((status == E_CAL_MODEL_TASKS_DUE_TODAY) || (status == E_CAL_MODEL_TASKS_DUE_OVERDUE))
-		{
-			e_table_model_pre_change (E_TABLE_MODEL (model));
-			e_table_model_row_changed (E_TABLE_MODEL (model), row);
+	if (g_hash_table_size (changed) > 0) {
+		gint row, row_count;
+		guint n_found = 0;
+
+		row_count = e_table_model_row_count (E_TABLE_MODEL (model));
+
+		/* Stop as soon as all the changed rows are found */
+		for (row = 0; row < row_count && n_found < g_hash_table_size (changed); row++) {
+			ECalModelComponent *comp_data;
+
+			comp_data = e_cal_model_get_component_at (E_CAL_MODEL (model), row);
+			if (comp_data && g_hash_table_contains (changed, comp_data)) {
+				n_found++;
+
+				e_table_model_pre_change (E_TABLE_MODEL (model));
+				e_table_model_row_changed (E_TABLE_MODEL (model), row);
+			}
 		}
 	}
+
+	g_hash_table_destroy (changed);
+
+	cal_model_tasks_schedule_due_transitions (model);
 }
@@ -228,6 +228,9 @@ e_cal_model_component_set_icalcomponent (ECalModelComponent *comp_data,
 
 	#undef free_ptr
 
+	comp_data->due_status = -1;
+	comp_data->due_status_until = 0;
+
 	if (comp_data->icalcomp && model)
 		e_cal_model_set_instance_times (comp_data, model->priv->zone);
 }
@@ -265,6 +268,8 @@ e_cal_model_component_init (ECalModelComponent *comp)
 {
 	comp->priv = E_CAL_MODEL_COMPONENT_GET_PRIVATE (comp);
 	comp->is_new_component = FALSE;
+	comp->due_status = -1;
+	comp->due_status_until = 0;
 }
 
 static gpointer
@@ -119,6 +119,11 @@ struct _ECalModelComponent {
 	ECellDateEditValue *lastmodified;
 	gchar *color;
 
+	/* Due status of a task, -1 when not known yet, and the time
+	 * when it changes next, 0 when it does not change by time */
+	gint due_status;
+	time_t due_status_until;
+
 	ECalModelComponentPrivate *priv;
 };
 
@@ -37,6 +37,9 @@
 
 #include "e-cal-ops.h"
 
+/* How many components are sent to the server with one request */
+#define BATCH_SIZE 100
+
 static void
 cal_ops_manage_send_component (ECalModel *model,
 			       ECalClient *client,
@@ -533,29 +536,47 @@ e_cal_ops_delete_ecalmodel_components (ECalModel *model,
 	g_free (description);
 }
 
+/* Creates clones of the @icalcomps with new UIDs, sending them in batches;
+   the @out_any_created is set to TRUE once any batch is created */
 static gboolean
-cal_ops_create_comp_with_new_uid_sync (ECalClient *cal_client,
-				       icalcomponent *icalcomp,
-				       GCancellable *cancellable,
-				       GError **error)
+cal_ops_create_comps_with_new_uid_sync (ECalClient *cal_client,
+					GSList *icalcomps,
+					gboolean *out_any_created,
+					GCancellable *cancellable,
+					GError **error)
 {
-	icalcomponent *clone;
-	gchar *uid;
-	gboolean success;
+	GSList *link = icalcomps;
+	gboolean success = TRUE;
 
 	g_return_val_if_fail (E_IS_CAL_CLIENT (cal_client), FALSE);
-	g_return_val_if_fail (icalcomp != NULL, FALSE);
 
+	while (link && success) {
+		GSList *clones = NULL, *new_uids = NULL;
+		gint ii;
 
-	clone = icalcomponent_new_clone (icalcomp);
+		for (ii = 0; link && ii < BATCH_SIZE; link = g_slist_next (link), ii++) {
+			icalcomponent *clone;
+			gchar *uid;
 
-	uid = e_util_generate_uid ();
-	icalcomponent_set_uid (clone, uid);
-	g_free (uid);
+			clone = icalcomponent_new_clone (link->data);
+
+			uid = e_util_generate_uid ();
+			icalcomponent_set_uid (clone, uid);
+			g_free (uid);
+
+			clones = g_slist_prepend (clones, clone);
+		}
 
-	success = e_cal_client_create_object_sync (cal_client, clone, NULL, cancellable, error);
+		clones = g_slist_reverse (clones);
 
-	icalcomponent_free (clone);
+		success = e_cal_client_create_objects_sync (cal_client, clones, &new_uids, cancellable, error);
+
+		if (success)
+			*out_any_created = TRUE;
+
+		e_client_util_free_string_slist (new_uids);
+		g_slist_free_full (clones, (GDestroyNotify) icalcomponent_free);
+	}
 
 	return success;
 }
@@ -633,11 +654,23 @@ cal_ops_update_components_thread (EAlertSinkThreadJobData *job_data,
 	if (icalcomponent_isa (pcd->icalcomp) == ICAL_VCALENDAR_COMPONENT &&
 	    icalcomponent_get_first_component (pcd->icalcomp, pcd->kind) != NULL) {
 		icalcomponent *subcomp;
+		GHashTable *added_tzids;
+		GSList *subcomps = NULL;
+
+		added_tzids = g_hash_table_new (g_str_hash, g_str_equal);
 
 		for (subcomp = icalcomponent_get_first_component (pcd->icalcomp, ICAL_VTIMEZONE_COMPONENT);
 		     subcomp && !g_cancellable_is_cancelled (cancellable);
 		     subcomp = icalcomponent_get_next_component (pcd->icalcomp, ICAL_VTIMEZONE_COMPONENT)) {
 			icaltimezone *zone;
+			icalproperty *prop;
+			const gchar *tzid;
+
+			/* The same timezone can be included multiple times */
+			prop = icalcomponent_get_first_property (subcomp, ICAL_TZID_PROPERTY);
+			tzid = prop ? icalproperty_get_tzid (prop) : NULL;
+			if (tzid && g_hash_table_contains (added_tzids, tzid))
+				continue;
 
 			zone = icaltimezone_new ();
 			icaltimezone_set_component (zone, subcomp);
@@ -648,24 +681,36 @@ cal_ops_update_components_thread (EAlertSinkThreadJobData *job_data,
 			}
 
 			icaltimezone_free (zone, 1);
+
+			if (tzid)
+				g_hash_table_add (added_tzids, (gpointer) tzid);
 		}
 
+		g_hash_table_destroy (added_tzids);
+
 		for (subcomp = icalcomponent_get_first_component (pcd->icalcomp, pcd->kind);
-		     subcomp && !g_cancellable_is_cancelled (cancellable) && success;
+		     subcomp;
 		     subcomp = icalcomponent_get_next_component (pcd->icalcomp, pcd->kind)) {
-			if (!cal_ops_create_comp_with_new_uid_sync (cal_client, subcomp, cancellable, error)) {
-				success = FALSE;
-				break;
-			}
+			subcomps = g_slist_prepend (subcomps, subcomp);
+		}
+
+		subcomps = g_slist_reverse (subcomps);
 
-			any_copied = TRUE;
+		if (success && subcomps && !g_cancellable_is_cancelled (cancellable)) {
+			success = cal_ops_create_comps_with_new_uid_sync (cal_client, subcomps, &any_copied, cancellable, error);
 		}
+
+		g_slist_free (subcomps);
 	} else if (icalcomponent_isa (pcd->icalcomp) == pcd->kind) {
-		success = cal_ops_create_comp_with_new_uid_sync (cal_client, pcd->icalcomp, cancellable, error);
-		any_copied = success;
+		GSList single = { 0, };
+
+		single.data = pcd->icalcomp;
+
+		success = cal_ops_create_comps_with_new_uid_sync (cal_client, &single, &any_copied, cancellable, error);
 	}
 
-	pcd->success = success && any_copied;
+	/* Also when a later batch failed, the earlier batches are created */
+	pcd->success = any_copied;
 
 	g_object_unref (client);
 }
@@ -900,25 +945,144 @@ purge_components_data_free (gpointer ptr)
 }
 
 struct purge_data {
-	GList *clients;
 	gboolean remove;
 	time_t older_than;
+	icaltimezone *default_zone;
 };
 
 static gboolean
-ca_ops_purge_check_instance_cb (ECalComponent *comp,
-				time_t instance_start,
-				time_t instance_end,
-				gpointer data)
+ca_ops_purge_check_instance_cb (icalcomponent *icalcomp,
+				struct icaltimetype instance_start,
+				struct icaltimetype instance_end,
+				gpointer user_data,
+				GCancellable *cancellable,
+				GError **error)
 {
-	struct purge_data *pd = data;
+	struct purge_data *pd = user_data;
+	icaltimezone *zone;
+
+	zone = (icaltimezone *) instance_end.zone;
+	if (!zone)
+		zone = pd->default_zone;
 
-	if (instance_end >= pd->older_than)
+	if (icaltime_as_timet_with_zone (instance_end, zone) >= pd->older_than)
 		pd->remove = FALSE;
 
 	return pd->remove;
 }
 
+/* Checks all instances of the @icalcomp against the @pd, stopping
+   on the first one, which ends after the purge threshold. */
+static void
+cal_ops_purge_check_component (ECalClient *client,
+			       icalcomponent *icalcomp,
+			       struct purge_data *pd,
+			       GCancellable *cancellable)
+{
+	e_cal_recur_generate_instances_sync (icalcomp,
+		icaltime_from_timet_with_zone (pd->older_than, FALSE, icaltimezone_get_utc_timezone ()),
+		icaltime_from_timet_with_zone (G_MAXINT32, FALSE, icaltimezone_get_utc_timezone ()),
+		ca_ops_purge_check_instance_cb, pd,
+		e_cal_client_tzlookup_cb, client,
+		pd->default_zone, cancellable, NULL);
+}
+
+/* Returns whether the whole series of the @uid can be purged, which is
+   when neither the master component nor any of its detached instances
+   has an occurrence ending after the purge threshold. The detached
+   instances can be moved elsewhere than the master's recurrence rules
+   say, thus they are checked on their own. */
+static gboolean
+cal_ops_purge_can_remove_series_sync (ECalClient *client,
+				      const gchar *uid,
+				      struct purge_data *pd,
+				      GCancellable *cancellable)
+{
+	GSList *comps = NULL, *link;
+
+	/* Rather keep the series when it cannot be checked */
+	if (!e_cal_client_get_objects_for_uid_sync (client, uid, &comps, cancellable, NULL))
+		return FALSE;
+
+	pd->remove = comps != NULL;
+
+	for (link = comps; link && pd->remove; link = g_slist_next (link)) {
+		ECalComponent *comp = link->data;
+
+		cal_ops_purge_check_component (client, e_cal_component_get_icalcomponent (comp), pd, cancellable);
+	}
+
+	g_slist_free_full (comps, g_object_unref);
+
+	return pd->remove;
+}
+
+/* Adds an ECalComponentId for the @uid and @rid into @pids, unless
+   the @uid is already part of @uids, in which case the @rid is ignored,
+   because all the ids are removed with the same modifier. */
+static void
+cal_ops_add_component_id (GSList **pids,
+			  GHashTable *uids,
+			  const gchar *uid,
+			  const gchar *rid)
+{
+	if (!uid || g_hash_table_contains (uids, uid))
+		return;
+
+	g_hash_table_add (uids, g_strdup (uid));
+	*pids = g_slist_prepend (*pids, e_cal_component_id_new (uid, rid));
+}
+
+/* Removes the ECalComponentId-s from @ids in batches, updating
+   the @inout_removed counter and the progress after each of them. */
+static gboolean
+cal_ops_remove_components_batched_sync (ECalClient *client,
+					GSList *ids,
+					ECalObjModType mod,
+					gint *inout_removed,
+					gint total,
+					GCancellable *cancellable,
+					GError **error)
+{
+	GSList *link = ids;
+
+	while (link) {
+		GSList *batch = link, *last = link;
+		gboolean success;
+		gint ii;
+
+		for (ii = 1; ii < BATCH_SIZE && last->next; ii++)
+			last = last->next;
+
+		link = last->next;
+		last->next = NULL;
+
+		success = e_cal_client_remove_objects_sync (client, batch, mod, cancellable, error);
+
+		last->next = link;
+
+		if (!success)
+			return FALSE;
+
+		*inout_removed += ii;
+
+		if (total > 0)
+			camel_operation_progress (cancellable, 100 * (*inout_removed) / total);
+	}
+
+	return TRUE;
+}
+
+static void
+cal_ops_prefix_removed_error (GError **error,
+			      gint removed,
+			      gint total)
+{
+	if (removed > 0)
+		g_prefix_error (error, ngettext ("Removed %d of %d component before the failure: ",
+			"Removed %d of %d components before the failure: ", total), removed, total);
+}
+
 static void
 cal_ops_purge_components_thread (EAlertSinkThreadJobData *job_data,
 				 gpointer user_data,
@@ -950,10 +1114,11 @@ cal_ops_purge_components_thread (EAlertSinkThreadJobData *job_data,
 
 	for (clink = pcd->clients; clink && !g_cancellable_is_cancelled (cancellable); clink = g_list_next (clink)) {
 		ECalClient *client = clink->data;
-		GSList *objects, *olink;
-		gint nobjects, ii, last_percent = 0;
+		GSList *objects, *olink, *ids_all = NULL, *ids_this = NULL;
+		GHashTable *uids, *series; /* gchar *uid ~> GINT_TO_POINTER (can remove + 1) */
+		gint nobjects, nremoved;
 		gchar *display_name;
-		gboolean success = TRUE;
+		gboolean check_recurrences, success = TRUE;
 
 		if (!client || e_client_is_readonly (E_CLIENT (client)))
 			continue;
@@ -1016,23 +1181,43 @@ cal_ops_purge_components_thread (EAlertSinkThreadJobData *job_data,
 
 		g_free (display_name);
 		pushed_message = TRUE;
-		nobjects = g_slist_length (objects);
 
-		for (olink = objects, ii = 0; olink; olink = g_slist_next (olink), ii++) {
+		/* Decide locally what to remove, then remove it in batches */
+		uids = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+		series = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+		check_recurrences = !e_cal_client_check_recurrences_no_master (client);
+
+		for (olink = objects; olink && !g_cancellable_is_cancelled (cancellable); olink = g_slist_next (olink)) {
 			icalcomponent *icalcomp = olink->data;
 			gboolean remove = TRUE;
-			gint percent = 100 * (ii + 1) / nobjects;
 
-			if (!e_cal_client_check_recurrences_no_master (client)) {
+			if (check_recurrences) {
 				struct purge_data pd;
 
 				pd.remove = TRUE;
 				pd.older_than = pcd->older_than;
+				pd.default_zone = zone ? zone : icaltimezone_get_utc_timezone ();
 
-				e_cal_client_generate_instances_for_object_sync (client, icalcomp,
-					pcd->older_than, G_MAXINT32, ca_ops_purge_check_instance_cb, &pd);
+				if (e_cal_util_component_is_instance (icalcomp) ||
+				    e_cal_util_component_has_recurrences (icalcomp)) {
+					const gchar *uid = icalcomponent_get_uid (icalcomp);
+					gpointer value;
+
+					/* The series is checked as a whole, once per UID */
+					value = uid ? g_hash_table_lookup (series, uid) : NULL;
+					if (value) {
+						remove = GPOINTER_TO_INT (value) - 1;
+					} else if (uid) {
+						remove = cal_ops_purge_can_remove_series_sync (client, uid, &pd, cancellable);
+						g_hash_table_insert (series, g_strdup (uid), GINT_TO_POINTER (remove + 1));
+					} else {
+						remove = FALSE;
+					}
+				} else {
+					cal_ops_purge_check_component (client, icalcomp, &pd, cancellable);
 
-				remove = pd.remove;
+					remove = pd.remove;
+				}
 			}
 
 			if (remove) {
@@ -1048,23 +1233,39 @@ cal_ops_purge_components_thread (EAlertSinkThreadJobData *job_data,
 					if (!icaltime_is_null_time (recur_id))
 						rid = icaltime_as_ical_string_r (recur_id);
 
-					success = e_cal_client_remove_object_sync (client, uid, rid, E_CAL_OBJ_MOD_ALL, cancellable, error);
+					cal_ops_add_component_id (&ids_all, uids, uid, rid);
 
 					g_free (rid);
 				} else {
-					success = e_cal_client_remove_object_sync (client, uid, NULL, E_CAL_OBJ_MOD_THIS, cancellable, error);
+					cal_ops_add_component_id (&ids_this, uids, uid, NULL);
 				}
-
-				if (!success)
-					break;
 			}
+		}
 
-			if (percent != last_percent) {
-				camel_operation_progress (cancellable, percent);
-				last_percent = percent;
-			}
+		g_hash_table_destroy (uids);
+		g_hash_table_destroy (series);
+
+		nremoved = 0;
+		nobjects = g_slist_length (ids_all) + g_slist_length (ids_this);
+
+		if (!g_cancellable_set_error_if_cancelled (cancellable, error)) {
+			ids_all = g_slist_reverse (ids_all);
+			ids_this = g_slist_reverse (ids_this);
+
+			success = cal_ops_remove_components_batched_sync (client, ids_all, E_CAL_OBJ_MOD_ALL,
+					&nremoved, nobjects, cancellable, error) &&
+				cal_ops_remove_components_batched_sync (client, ids_this, E_CAL_OBJ_MOD_THIS,
+					&nremoved, nobjects, cancellable, error);
+
+			if (!success)
+				cal_ops_prefix_removed_error (error, nremoved, nobjects);
+		} else {
+			success = FALSE;
 		}
 
+		g_slist_free_full (ids_all, (GDestroyNotify) e_cal_component_free_id);
+		g_slist_free_full (ids_this, (GDestroyNotify) e_cal_component_free_id);
+
 		g_slist_foreach (objects, (GFunc) icalcomponent_free, NULL);
 		g_slist_free (objects);
 
@@ -1153,7 +1354,10 @@ cal_ops_delete_completed_thread (EAlertSinkThreadJobData *job_data,
 
 	for (link = clients; link; link = g_list_next (link)) {
 		ECalClient *client = link->data;
-		GSList *objects = NULL, *olink;
+		GSList *objects = NULL, *olink, *ids = NULL;
+		GHashTable *uids;
+		gint nobjects, nremoved;
+		gboolean success;
 
 		if (!client ||
 		    e_client_is_readonly (E_CLIENT (client)))
@@ -1165,24 +1369,34 @@ cal_ops_delete_completed_thread (EAlertSinkThreadJobData *job_data,
 			break;
 		}
 
+		uids = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+
 		for (olink = objects; olink != NULL; olink = g_slist_next (olink)) {
 			icalcomponent *icalcomp = olink->data;
-			const gchar *uid;
-
-			uid = icalcomponent_get_uid (icalcomp);
 
-			if (!e_cal_client_remove_object_sync (client, uid, NULL, E_CAL_OBJ_MOD_THIS, cancellable, error)) {
-				ESource *source = e_client_get_source (E_CLIENT (client));
-				e_alert_sink_thread_job_set_alert_arg_0 (job_data, e_source_get_display_name (source));
-				break;
-			}
+			cal_ops_add_component_id (&ids, uids, icalcomponent_get_uid (icalcomp), NULL);
 		}
 
+		g_hash_table_destroy (uids);
 		e_cal_client_free_icalcomp_slist (objects);
 
-		/* did not process all objects => an error occurred */
-		if (olink != NULL)
+		ids = g_slist_reverse (ids);
+		nobjects = g_slist_length (ids);
+		nremoved = 0;
+
+		success = cal_ops_remove_components_batched_sync (client, ids, E_CAL_OBJ_MOD_THIS,
+			&nremoved, nobjects, cancellable, error);
+
+		g_slist_free_full (ids, (GDestroyNotify) e_cal_component_free_id);
+
+		camel_operation_progress (cancellable, 0);
+
+		if (!success) {
+			ESource *source = e_client_get_source (E_CLIENT (client));
+			e_alert_sink_thread_job_set_alert_arg_0 (job_data, e_source_get_display_name (source));
+			cal_ops_prefix_removed_error (error, nremoved, nobjects);
 			break;
+		}
 	}
 }
 
@@ -1933,7 +2147,7 @@ transfer_components_thread (EAlertSinkThreadJobData *job_data,
 	EClientCache *client_cache;
 	GHashTableIter iter;
 	gpointer key, value;
-	gint nobjects, ii = 0, last_percent = 0;
+	gint nobjects, ii = 0;
 	GSList *link;
 	gboolean success = TRUE;
 
@@ -1982,22 +2196,34 @@ transfer_components_thread (EAlertSinkThreadJobData *job_data,
 
 		from_cal_client = E_CAL_CLIENT (from_client);
 
-		for (link = icalcomps; link && !g_cancellable_is_cancelled (cancellable); link = g_slist_next (link), ii++) {
-			gint percent = 100 * (ii + 1) / nobjects;
-			icalcomponent *icalcomp = link->data;
+		/* Transfer the components in batches, to have bulk server requests,
+		   while still being able to show progress and cancel in between */
+		for (link = icalcomps; link && success && !g_cancellable_is_cancelled (cancellable);) {
+			GSList *batch = link, *last = link;
+			gint nbatch;
 
-			if (!cal_comp_transfer_item_to_sync (from_cal_client, to_cal_client, icalcomp, !tcd->is_move, cancellable, error)) {
-				success = FALSE;
-				break;
-			}
+			for (nbatch = 1; nbatch < BATCH_SIZE && last->next; nbatch++)
+				last = last->next;
+
+			link = last->next;
+			last->next = NULL;
 
-			if (percent != last_percent) {
-				camel_operation_progress (cancellable, percent);
-				last_percent = percent;
+			success = cal_comp_transfer_items_to_sync (from_cal_client, to_cal_client, batch, !tcd->is_move, cancellable, error);
+
+			last->next = link;
+
+			if (success) {
+				ii += nbatch;
+
+				if (nobjects > 0)
+					camel_operation_progress (cancellable, 100 * ii / nobjects);
 			}
 		}
 
 		g_clear_object (&from_client);
+
+		if (!success)
+			goto out;
 	}
 
 	if (success && ii > 0)
@@ -81,6 +81,10 @@
  * we get from the server. */
 #define E_DAY_VIEW_LAYOUT_TIMEOUT	100
 
+/* How many components, outside of the visible part of the view,
+ * are added in one idle callback after the view is updated. */
+#define E_DAY_VIEW_UPDATE_CHUNK_SIZE	250
+
 /* How many rows can be shown at a top_canvas; there will be always + 2 for
  * caption item and DnD space */
 #define E_DAY_VIEW_MAX_ROWS_AT_TOP     6
@@ -172,6 +176,12 @@ struct _EDayViewPrivate {
 	GdkDragContext *drag_context;
 
 	gboolean draw_flat_events;
+
+	/* Components outside of the visible part of the view, which are
+	 * waiting to be added by the 'pending_comps_idle_id' callback. */
+	GQueue pending_comps; /* ECalModelComponent * */
+	GHashTable *pending_comps_index; /* ECalModelComponent * ~> GList * link in pending_comps */
+	guint pending_comps_idle_id;
 };
 
 typedef struct {
@@ -202,6 +212,7 @@ static gboolean e_day_view_get_extreme_event (EDayView *day_view,
 static gboolean e_day_view_do_key_press (GtkWidget *widget,
 					 GdkEventKey *event);
 static void e_day_view_update_query (EDayView *day_view);
+static void day_view_cancel_pending_comps (EDayView *day_view);
 static void e_day_view_goto_start_of_work_day (EDayView *day_view);
 static void e_day_view_goto_end_of_work_day (EDayView *day_view);
 static void e_day_view_change_duration_to_start_of_work_day (EDayView *day_view);
@@ -2671,6 +2682,136 @@ process_component (EDayView *day_view,
 	g_free (rid);
 }
 
+static void
+day_view_cancel_pending_comps (EDayView *day_view)
+{
+	if (day_view->priv->pending_comps_idle_id) {
+		g_source_remove (day_view->priv->pending_comps_idle_id);
+		day_view->priv->pending_comps_idle_id = 0;
+	}
+
+	while (!g_queue_is_empty (&day_view->priv->pending_comps))
+		g_object_unref (g_queue_pop_head (&day_view->priv->pending_comps));
+
+	g_clear_pointer (&day_view->priv->pending_comps_index, g_hash_table_destroy);
+}
+
+static void
+day_view_add_pending_comp (EDayView *day_view,
+			   ECalModelComponent *comp_data)
+{
+	if (!day_view->priv->pending_comps_index)
+		day_view->priv->pending_comps_index = g_hash_table_new (g_direct_hash, g_direct_equal);
+
+	g_queue_push_tail (&day_view->priv->pending_comps, g_object_ref (comp_data));
+	g_hash_table_insert (day_view->priv->pending_comps_index, comp_data, day_view->priv->pending_comps.tail);
+}
+
+/* Returns whether the 'comp_data' had been waiting to be added */
+static gboolean
+day_view_remove_pending_comp (EDayView *day_view,
+			      ECalModelComponent *comp_data)
+{
+	GList *link;
+
+	if (!day_view->priv->pending_comps_index)
+		return FALSE;
+
+	link = g_hash_table_lookup (day_view->priv->pending_comps_index, comp_data);
+	if (!link)
+		return FALSE;
+
+	g_hash_table_remove (day_view->priv->pending_comps_index, comp_data);
+	g_queue_delete_link (&day_view->priv->pending_comps, link);
+
+	g_object_unref (comp_data);
+
+	return TRUE;
+}
+
+static gboolean
+day_view_process_pending_comps_cb (gpointer user_data)
+{
+	EDayView *day_view = user_data;
+	gint ii;
+
+	for (ii = 0; ii < E_DAY_VIEW_UPDATE_CHUNK_SIZE && !g_queue_is_empty (&day_view->priv->pending_comps); ii++) {
+		ECalModelComponent *comp_data;
+
+		comp_data = g_queue_pop_head (&day_view->priv->pending_comps);
+		g_hash_table_remove (day_view->priv->pending_comps_index, comp_data);
+		process_component (day_view, comp_data);
+		g_object_unref (comp_data);
+	}
+
+	e_day_view_queue_layout (day_view);
+
+	if (g_queue_is_empty (&day_view->priv->pending_comps)) {
+		g_clear_pointer (&day_view->priv->pending_comps_index, g_hash_table_destroy);
+		day_view->priv->pending_comps_idle_id = 0;
+		return FALSE;
+	}
+
+	return TRUE;
+}
+
+/* Calculates the time range of the rows currently scrolled into the view
+ * of the main canvas, as minutes from the start of a day. */
+static void
+day_view_get_visible_minutes (EDayView *day_view,
+			      gint *out_start_minute,
+			      gint *out_end_minute)
+{
+	GtkAdjustment *adjustment;
+	gdouble value, page_size;
+	gint first_row, last_row, time_divisions;
+
+	adjustment = gtk_scrollable_get_vadjustment (GTK_SCROLLABLE (day_view->main_canvas));
+	value = gtk_adjustment_get_value (adjustment);
+	page_size = gtk_adjustment_get_page_size (adjustment);
+
+	if (day_view->row_height <= 0 || page_size <= 0) {
+		first_row = 0;
+		last_row = day_view->rows;
+	} else {
+		first_row = value / day_view->row_height;
+		last_row = (value + page_size) / day_view->row_height + 1;
+	}
+
+	time_divisions = e_calendar_view_get_time_divisions (E_CALENDAR_VIEW (day_view));
+
+	*out_start_minute = day_view->first_hour_shown * 60 + day_view->first_minute_shown + first_row * time_divisions;
+	*out_end_minute = day_view->first_hour_shown * 60 + day_view->first_minute_shown + last_row * time_divisions;
+}
+
+static gboolean
+day_view_is_comp_visible (EDayView *day_view,
+			  ECalModelComponent *comp_data,
+			  gint days_shown,
+			  gint start_minute,
+			  gint end_minute)
+{
+	gint day;
+
+	/* Long events are shown in the top canvas, which is always visible */
+	if (comp_data->instance_end - comp_data->instance_start >= 24 * 60 * 60 ||
+	    icaltime_is_date (icalcomponent_get_dtstart (comp_data->icalcomp)))
+		return TRUE;
+
+	for (day = 0; day < days_shown; day++) {
+		time_t visible_start, visible_end;
+
+		visible_start = day_view->day_starts[day] + start_minute * 60;
+		visible_end = day_view->day_starts[day] + end_minute * 60;
+
+		if (comp_data->instance_start < visible_end &&
+		    comp_data->instance_end >= visible_start)
+			return TRUE;
+	}
+
+	return FALSE;
+}
+
 static void
 update_row (EDayView *day_view,
 	    gint row,
@@ -2691,6 +2832,8 @@ update_row (EDayView *day_view,
 	comp_data = e_cal_model_get_component_at (model, row);
 	g_return_if_fail (comp_data != NULL);
 
+	day_view_remove_pending_comp (day_view, comp_data);
+
 	uid = icalcomponent_get_uid (comp_data->icalcomp);
 	if (e_cal_util_component_is_instance (comp_data->icalcomp)) {
 		icalproperty *prop;
@@ -2772,6 +2915,7 @@ model_rows_inserted_cb (ETableModel *etm,
 			g_warning ("comp_data is NULL\n");
 			continue;
 		}
+		day_view_remove_pending_comp (day_view, comp_data);
 		process_component (day_view, comp_data);
 	}
 
@@ -2803,6 +2947,9 @@ model_comps_deleted_cb (ETableModel *etm,
 		const gchar *uid = NULL;
 		gchar *rid = NULL;
 
+		if (day_view_remove_pending_comp (day_view, comp_data))
+			continue;
+
 		uid = icalcomponent_get_uid (comp_data->icalcomp);
 		if (e_cal_util_component_is_instance (comp_data->icalcomp)) {
 			icalproperty *prop;
@@ -4877,7 +5024,9 @@ e_day_view_show_popup_menu (EDayView *day_view,
 static void
 e_day_view_update_query (EDayView *day_view)
 {
-	gint rows, r;
+	ECalModel *model;
+	gint rows, r, days_shown;
+	gint start_minute, end_minute;
 
 	if (!E_CALENDAR_VIEW (day_view)->in_focus) {
 		e_day_view_free_events (day_view);
@@ -4895,13 +5044,30 @@ e_day_view_update_query (EDayView *day_view)
 	e_day_view_free_events (day_view);
 	e_day_view_queue_layout (day_view);
 
-	rows = e_table_model_row_count (E_TABLE_MODEL (e_calendar_view_get_model (E_CALENDAR_VIEW (day_view))));
+	/* Add the events in the scrolled-to part of the view first and
+	 * the rest of them in chunks from an idle callback, thus the view
+	 * is usable without waiting for all of the components. */
+	day_view_get_visible_minutes (day_view, &start_minute, &end_minute);
+	days_shown = e_day_view_get_days_shown (day_view);
+
+	model = e_calendar_view_get_model (E_CALENDAR_VIEW (day_view));
+	rows = e_table_model_row_count (E_TABLE_MODEL (model));
 	for (r = 0; r < rows; r++) {
 		ECalModelComponent *comp_data;
 
-		comp_data = e_cal_model_get_component_at (e_calendar_view_get_model (E_CALENDAR_VIEW (day_view)), r);
+		comp_data = e_cal_model_get_component_at (model, r);
 		g_return_if_fail (comp_data != NULL);
-		process_component (day_view, comp_data);
+
+		if (day_view_is_comp_visible (day_view, comp_data, days_shown, start_minute, end_minute))
+			process_component (day_view, comp_data);
+		else
+			day_view_add_pending_comp (day_view, comp_data);
+	}
+
+	if (!g_queue_is_empty (&day_view->priv->pending_comps)) {
+		day_view->priv->pending_comps_idle_id = g_idle_add_full (
+			G_PRIORITY_DEFAULT_IDLE,
+			day_view_process_pending_comps_cb, day_view, NULL);
 	}
 }
 
@@ -5704,6 +5870,8 @@ e_day_view_free_events (EDayView *day_view)
 
 	g_clear_object (&day_view->priv->drag_context);
 
+	day_view_cancel_pending_comps (day_view);
+
 	e_day_view_free_event_array (day_view, day_view->long_events);
 
 	for (day = 0; day < E_DAY_VIEW_MAX_DAYS; day++)
@@ -63,6 +63,9 @@ struct _EMeetingStorePrivate {
 
 	guint num_threads;
 	guint num_queries;
+
+	/* Free/busy data already received; guarded by the mutex */
+	GHashTable *fb_cache; /* gchar *key ~> gchar *iCalendar string */
 };
 
 #define BUF_SIZE 1024
@@ -733,6 +736,7 @@ meeting_store_finalize (GObject *object)
 			g_ptr_array_index (priv->refresh_queue, 0));
 	g_ptr_array_free (priv->refresh_queue, TRUE);
 	g_hash_table_destroy (priv->refresh_data);
+	g_hash_table_destroy (priv->fb_cache);
 
 	if (priv->refresh_idle_id)
 		g_source_remove (priv->refresh_idle_id);
@@ -819,6 +823,8 @@ e_meeting_store_init (EMeetingStore *store)
 	store->priv->refresh_queue = g_ptr_array_new ();
 	store->priv->refresh_data = g_hash_table_new_full (
 		g_str_hash, g_str_equal, g_free, NULL);
+	store->priv->fb_cache = g_hash_table_new_full (
+		g_str_hash, g_str_equal, g_free, g_free);
 
 	g_mutex_init (&store->priv->mutex);
 
@@ -860,6 +866,8 @@ e_meeting_store_set_client (EMeetingStore *store,
 
 	store->priv->client = client;
 
+	e_meeting_store_clear_free_busy_cache (store);
+
 	g_object_notify (G_OBJECT (store), "client");
 }
 
@@ -927,6 +935,8 @@ e_meeting_store_set_free_busy_template (EMeetingStore *store,
 	g_free (store->priv->fb_uri);
 	store->priv->fb_uri = g_strdup (free_busy_template);
 
+	e_meeting_store_clear_free_busy_cache (store);
+
 	g_object_notify (G_OBJECT (store), "free-busy-template");
 }
 
@@ -949,6 +959,8 @@ e_meeting_store_set_timezone (EMeetingStore *store,
 
 	store->priv->zone = timezone;
 
+	e_meeting_store_clear_free_busy_cache (store);
+
 	g_object_notify (G_OBJECT (store), "timezone");
 }
 
@@ -1455,6 +1467,16 @@ process_free_busy_comp (EMeetingAttendee *attendee,
 	}
 }
 
+static gchar *
+free_busy_cache_key (EMeetingStoreQueueData *qdata)
+{
+	return g_strdup_printf (
+		"%s\n%u %02d:%02d\n%u %02d:%02d",
+		itip_strip_mailto (e_meeting_attendee_get_address (qdata->attendee)),
+		g_date_get_julian (&qdata->start.date), qdata->start.hour, qdata->start.minute,
+		g_date_get_julian (&qdata->end.date), qdata->end.hour, qdata->end.minute);
+}
+
 static void
 process_free_busy (EMeetingStoreQueueData *qdata,
                    gchar *text)
@@ -1473,6 +1495,10 @@ process_free_busy (EMeetingStoreQueueData *qdata,
 		return;
 	}
 
+	g_mutex_lock (&priv->mutex);
+	g_hash_table_insert (priv->fb_cache, free_busy_cache_key (qdata), g_strdup (text));
+	g_mutex_unlock (&priv->mutex);
+
 	kind = icalcomponent_isa (main_comp);
 	if (kind == ICAL_VCALENDAR_COMPONENT) {
 		icalcompiter iter;
@@ -1531,8 +1557,13 @@ typedef struct {
 	ECalClient *client;
 	time_t startt;
 	time_t endt;
-	GSList *users;
-	GSList *fb_data;
+	GSList *users; /* gchar *, email */
+	GSList *queue_data; /* EMeetingStoreQueueData * */
+	gchar *fb_uri;
+	EMeetingStore *store;
+} FreeBusyBatchData;
+
+typedef struct {
 	gchar *fb_uri;
 	gchar *email;
 	EMeetingAttendee *attendee;
@@ -1543,47 +1574,19 @@ typedef struct {
 #define USER_SUB   "%u"
 #define DOMAIN_SUB "%d"
 
-static gboolean
+static gpointer
 freebusy_async (gpointer data)
 {
 	FreeBusyAsyncData *fbd = data;
 	EMeetingAttendee *attendee = fbd->attendee;
 	gchar *default_fb_uri = NULL;
 	gchar *fburi = NULL;
-	static GMutex mutex;
 	EMeetingStorePrivate *priv = fbd->store->priv;
 
-	if (fbd->client) {
-		/* FIXME This a workaround for getting all the free busy
-		 *       information for the users.  We should be able to
-		 *       get free busy asynchronously. */
-		g_mutex_lock (&mutex);
-		priv->num_queries++;
-		e_cal_client_get_free_busy_sync (
-			fbd->client, fbd->startt,
-			fbd->endt, fbd->users, &fbd->fb_data, NULL, NULL);
-		priv->num_queries--;
-		g_mutex_unlock (&mutex);
-
-		g_slist_foreach (fbd->users, (GFunc) g_free, NULL);
-		g_slist_free (fbd->users);
-
-		if (fbd->fb_data != NULL) {
-			ECalComponent *comp = fbd->fb_data->data;
-			gchar *comp_str;
-
-			comp_str = e_cal_component_get_as_string (comp);
-			process_free_busy (fbd->qdata, comp_str);
-			g_free (comp_str);
-
-			return TRUE;
-		}
-	}
-
 	/* Look for fburl's of attendee with no free busy info on server */
 	if (!e_meeting_attendee_is_set_address (attendee)) {
 		process_callbacks (fbd->qdata);
-		return TRUE;
+		goto exit;
 	}
 
 	/* Check for free busy info on the default server */
@@ -1596,7 +1599,9 @@ freebusy_async (gpointer data)
 	}
 
 	if (fburi) {
+		g_mutex_lock (&priv->mutex);
 		priv->num_queries++;
+		g_mutex_unlock (&priv->mutex);
 		start_async_read (fburi, fbd->qdata);
 		g_free (fburi);
 	} else if (default_fb_uri != NULL && !g_str_equal (default_fb_uri, "")) {
@@ -1609,120 +1614,305 @@ freebusy_async (gpointer data)
 		g_free (default_fb_uri);
 		default_fb_uri = replace_string (tmp_fb_uri, DOMAIN_SUB, split_email[1]);
 
+		g_mutex_lock (&priv->mutex);
 		priv->num_queries++;
+		g_mutex_unlock (&priv->mutex);
 		start_async_read (default_fb_uri, fbd->qdata);
 		g_free (tmp_fb_uri);
 		g_strfreev (split_email);
 		g_free (default_fb_uri);
 	} else {
+		g_free (default_fb_uri);
 		process_callbacks (fbd->qdata);
 	}
 
-	return TRUE;
+ exit:
+	g_free (fbd->fb_uri);
+	g_free (fbd->email);
+	g_free (fbd);
+
+	return NULL;
 }
 
 #undef USER_SUB
 #undef DOMAIN_SUB
 
+/* Looks up the free/busy information of the attendee in the URL sources,
+ * in a dedicated thread, thus the lookups for more attendees can run
+ * concurrently. */
+static void
+freebusy_start_url_lookup (EMeetingStore *store,
+                           EMeetingStoreQueueData *qdata,
+                           const gchar *fb_uri)
+{
+	FreeBusyAsyncData *fbd;
+	GThread *thread;
+	GError *error = NULL;
+
+	fbd = g_new0 (FreeBusyAsyncData, 1);
+	fbd->attendee = qdata->attendee;
+	fbd->qdata = qdata;
+	fbd->fb_uri = g_strdup (fb_uri);
+	fbd->store = store;
+	fbd->email = g_strdup (itip_strip_mailto (
+		e_meeting_attendee_get_address (qdata->attendee)));
+
+	thread = g_thread_try_new (NULL, freebusy_async, fbd, &error);
+	if (!thread) {
+		g_warning ("%s: Failed to create thread: %s", G_STRFUNC, error ? error->message : "Unknown error");
+		g_clear_error (&error);
+
+		g_free (fbd->fb_uri);
+		g_free (fbd->email);
+		g_free (fbd);
+
+		process_callbacks (qdata);
+		return;
+	}
+
+	g_thread_unref (thread);
+}
+
+static gboolean
+free_busy_comp_matches_user (icalcomponent *icalcomp,
+                             const gchar *email)
+{
+	icalproperty *prop;
+
+	for (prop = icalcomponent_get_first_property (icalcomp, ICAL_ORGANIZER_PROPERTY);
+	     prop;
+	     prop = icalcomponent_get_next_property (icalcomp, ICAL_ORGANIZER_PROPERTY)) {
+		const gchar *value = icalproperty_get_organizer (prop);
+
+		if (value && g_ascii_strcasecmp (itip_strip_mailto (value), email) == 0)
+			return TRUE;
+	}
+
+	for (prop = icalcomponent_get_first_property (icalcomp, ICAL_ATTENDEE_PROPERTY);
+	     prop;
+	     prop = icalcomponent_get_next_property (icalcomp, ICAL_ATTENDEE_PROPERTY)) {
+		const gchar *value = icalproperty_get_attendee (prop);
+
+		if (value && g_ascii_strcasecmp (itip_strip_mailto (value), email) == 0)
+			return TRUE;
+	}
+
+	return FALSE;
+}
+
+static ECalComponent *
+find_free_busy_for_user (GSList *fb_data,
+                         const gchar *email)
+{
+	GSList *link;
+
+	for (link = fb_data; link; link = g_slist_next (link)) {
+		ECalComponent *comp = link->data;
+
+		if (comp && free_busy_comp_matches_user (e_cal_component_get_icalcomponent (comp), email))
+			return comp;
+	}
+
+	return NULL;
+}
+
+/* Asks the client for free/busy information of all the users in the batch
+ * at once, then distributes the result between the attendees. Those
+ * without any information are looked up in the URL sources. */
+static gpointer
+freebusy_batch_async (gpointer data)
+{
+	FreeBusyBatchData *fbb = data;
+	EMeetingStorePrivate *priv = fbb->store->priv;
+	GSList *fb_data = NULL, *link;
+
+	g_mutex_lock (&priv->mutex);
+	priv->num_queries++;
+	g_mutex_unlock (&priv->mutex);
+
+	e_cal_client_get_free_busy_sync (
+		fbb->client, fbb->startt,
+		fbb->endt, fbb->users, &fb_data, NULL, NULL);
+
+	g_mutex_lock (&priv->mutex);
+	priv->num_queries--;
+	g_mutex_unlock (&priv->mutex);
+
+	for (link = fbb->queue_data; link; link = g_slist_next (link)) {
+		EMeetingStoreQueueData *qdata = link->data;
+		ECalComponent *comp;
+
+		comp = find_free_busy_for_user (fb_data, itip_strip_mailto (
+			e_meeting_attendee_get_address (qdata->attendee)));
+
+		/* The user cannot be recognized, but there is only one */
+		if (!comp && fb_data && !fbb->queue_data->next)
+			comp = fb_data->data;
+
+		if (comp) {
+			gchar *comp_str;
+
+			comp_str = e_cal_component_get_as_string (comp);
+			process_free_busy (qdata, comp_str);
+			g_free (comp_str);
+		} else {
+			freebusy_start_url_lookup (fbb->store, qdata, fbb->fb_uri);
+		}
+	}
+
+	g_slist_free_full (fb_data, g_object_unref);
+	g_slist_free_full (fbb->users, g_free);
+	g_slist_free (fbb->queue_data);
+	g_object_unref (fbb->client);
+	g_free (fbb->fb_uri);
+	g_free (fbb);
+
+	return NULL;
+}
+
+static time_t
+meeting_time_to_timet (EMeetingTime *mtime,
+                       icaltimezone *zone)
+{
+	struct icaltimetype itt;
+
+	itt = icaltime_null_time ();
+	itt.year = g_date_get_year (&mtime->date);
+	itt.month = g_date_get_month (&mtime->date);
+	itt.day = g_date_get_day (&mtime->date);
+	itt.hour = mtime->hour;
+	itt.minute = mtime->minute;
+
+	return icaltime_as_timet_with_zone (itt, zone);
+}
+
 static gboolean
 refresh_busy_periods (gpointer data)
 {
 	EMeetingStore *store = E_MEETING_STORE (data);
 	EMeetingStorePrivate *priv;
-	EMeetingAttendee *attendee = NULL;
-	EMeetingStoreQueueData *qdata = NULL;
+	GSList *queue_data = NULL, *batches = NULL, *link;
 	gint i;
-	GThread *thread;
-	GError *error = NULL;
-	FreeBusyAsyncData *fbd;
 
 	priv = store->priv;
 
-	/* Check to see if there are any remaining attendees in the queue */
+	/* Pick all the attendees in the queue, which are not being refreshed */
 	for (i = 0; i < priv->refresh_queue->len; i++) {
+		EMeetingAttendee *attendee;
+		EMeetingStoreQueueData *qdata;
+
 		attendee = g_ptr_array_index (priv->refresh_queue, i);
 		g_return_val_if_fail (attendee != NULL, FALSE);
 
 		qdata = g_hash_table_lookup (
 			priv->refresh_data, itip_strip_mailto (
 			e_meeting_attendee_get_address (attendee)));
-		if (!qdata)
+		if (!qdata || qdata->refreshing)
 			continue;
 
-		if (!qdata->refreshing)
-			break;
-	}
+		/* Indicate we are trying to refresh it */
+		qdata->refreshing = TRUE;
 
-	/* The everything in the queue is being refreshed */
-	if (i >= priv->refresh_queue->len) {
-		priv->refresh_idle_id = 0;
-		return FALSE;
+		/* We take a ref in case we get destroyed in the gui during a callback */
+		g_object_ref (qdata->store);
+
+		queue_data = g_slist_prepend (queue_data, qdata);
 	}
 
-	/* Indicate we are trying to refresh it */
-	qdata->refreshing = TRUE;
+	priv->refresh_idle_id = 0;
 
-	/* We take a ref in case we get destroyed in the gui during a callback */
-	g_object_ref (qdata->store);
+	g_mutex_lock (&priv->mutex);
+	priv->num_threads += g_slist_length (queue_data);
+	g_mutex_unlock (&priv->mutex);
 
-	fbd = g_new0 (FreeBusyAsyncData, 1);
-	fbd->client = priv->client;
-	fbd->attendee = attendee;
-	fbd->users = NULL;
-	fbd->fb_data = NULL;
-	fbd->qdata = qdata;
-	fbd->fb_uri = priv->fb_uri;
-	fbd->store = store;
-	fbd->email = g_strdup (itip_strip_mailto (
-		e_meeting_attendee_get_address (attendee)));
+	queue_data = g_slist_reverse (queue_data);
 
-	/* Check the server for free busy data */
-	if (priv->client) {
-		struct icaltimetype itt;
-
-		itt = icaltime_null_time ();
-		itt.year = g_date_get_year (&qdata->start.date);
-		itt.month = g_date_get_month (&qdata->start.date);
-		itt.day = g_date_get_day (&qdata->start.date);
-		itt.hour = qdata->start.hour;
-		itt.minute = qdata->start.minute;
-		fbd->startt = icaltime_as_timet_with_zone (itt, priv->zone);
-
-		itt = icaltime_null_time ();
-		itt.year = g_date_get_year (&qdata->end.date);
-		itt.month = g_date_get_month (&qdata->end.date);
-		itt.day = g_date_get_day (&qdata->end.date);
-		itt.hour = qdata->end.hour;
-		itt.minute = qdata->end.minute;
-		fbd->endt = icaltime_as_timet_with_zone (itt, priv->zone);
-		fbd->qdata = qdata;
-
-		fbd->users = g_slist_append (fbd->users, g_strdup (fbd->email));
+	for (link = queue_data; link; link = g_slist_next (link)) {
+		EMeetingStoreQueueData *qdata = link->data;
+		FreeBusyBatchData *fbb = NULL;
+		GSList *blink;
+		gchar *key, *cached;
 
+		key = free_busy_cache_key (qdata);
+		g_mutex_lock (&priv->mutex);
+		cached = g_strdup (g_hash_table_lookup (priv->fb_cache, key));
+		g_mutex_unlock (&priv->mutex);
+		g_free (key);
+
+		/* Already known from earlier */
+		if (cached) {
+			process_free_busy (qdata, cached);
+			g_free (cached);
+			continue;
+		}
+
+		if (!priv->client) {
+			freebusy_start_url_lookup (store, qdata, priv->fb_uri);
+			continue;
+		}
+
+		/* Ask the server for free busy data; the attendees with
+		 * the same time range are asked for in one request */
+		for (blink = batches; blink; blink = g_slist_next (blink)) {
+			EMeetingStoreQueueData *batch_qdata;
+
+			fbb = blink->data;
+			batch_qdata = fbb->queue_data->data;
+
+			if (e_meeting_time_compare_times (&batch_qdata->start, &qdata->start) == 0 &&
+			    e_meeting_time_compare_times (&batch_qdata->end, &qdata->end) == 0)
+				break;
+
+			fbb = NULL;
+		}
+
+		if (!fbb) {
+			fbb = g_new0 (FreeBusyBatchData, 1);
+			fbb->client = g_object_ref (priv->client);
+			fbb->fb_uri = g_strdup (priv->fb_uri);
+			fbb->store = store;
+			fbb->startt = meeting_time_to_timet (&qdata->start, priv->zone);
+			fbb->endt = meeting_time_to_timet (&qdata->end, priv->zone);
+
+			batches = g_slist_prepend (batches, fbb);
+		}
+
+		fbb->queue_data = g_slist_append (fbb->queue_data, qdata);
+		fbb->users = g_slist_append (fbb->users, g_strdup (itip_strip_mailto (
+			e_meeting_attendee_get_address (qdata->attendee))));
 	}
 
-	g_mutex_lock (&store->priv->mutex);
-	store->priv->num_threads++;
-	g_mutex_unlock (&store->priv->mutex);
+	g_slist_free (queue_data);
 
-	thread = g_thread_try_new (NULL, (GThreadFunc) freebusy_async, fbd, &error);
-	if (!thread) {
-		/* do clean up stuff here */
-		g_slist_foreach (fbd->users, (GFunc) g_free, NULL);
-		g_slist_free (fbd->users);
-		g_free (fbd->email);
-		priv->refresh_idle_id = 0;
+	/* Each batch runs in its own thread */
+	for (link = batches; link; link = g_slist_next (link)) {
+		FreeBusyBatchData *fbb = link->data;
+		GThread *thread;
+		GError *error = NULL;
+
+		thread = g_thread_try_new (NULL, freebusy_batch_async, fbb, &error);
+		if (thread) {
+			g_thread_unref (thread);
+		} else {
+			GSList *qlink;
 
-		g_mutex_lock (&store->priv->mutex);
-		store->priv->num_threads--;
-		g_mutex_unlock (&store->priv->mutex);
+			g_warning ("%s: Failed to create thread: %s", G_STRFUNC, error ? error->message : "Unknown error");
+			g_clear_error (&error);
 
-		return FALSE;
+			for (qlink = fbb->queue_data; qlink; qlink = g_slist_next (qlink))
+				process_callbacks (qlink->data);
+
+			g_slist_free_full (fbb->users, g_free);
+			g_slist_free (fbb->queue_data);
+			g_object_unref (fbb->client);
+			g_free (fbb->fb_uri);
+			g_free (fbb);
+		}
 	}
 
-	g_thread_unref (thread);
+	g_slist_free (batches);
 
-	return TRUE;
+	return FALSE;
 }
 
 static void
@@ -2032,7 +2222,10 @@ start_async_read (const gchar *uri,
 	g_return_if_fail (uri != NULL);
 	g_return_if_fail (data != NULL);
 
+	g_mutex_lock (&qdata->store->priv->mutex);
 	qdata->store->priv->num_queries--;
+	g_mutex_unlock (&qdata->store->priv->mutex);
+
 	file = g_file_new_for_uri (uri);
 
 	g_return_if_fail (file != NULL);
@@ -2094,6 +2287,25 @@ e_meeting_store_refresh_busy_periods (EMeetingStore *store,
 	refresh_queue_add (store, row, start, end, call_back, data);
 }
 
+/**
+ * e_meeting_store_clear_free_busy_cache:
+ * @store: an #EMeetingStore
+ *
+ * Forgets all the free/busy information received so far, thus the next
+ * refresh of the busy periods asks the servers again.
+ *
+ * Since: 3.30
+ **/
+void
+e_meeting_store_clear_free_busy_cache (EMeetingStore *store)
+{
+	g_return_if_fail (E_IS_MEETING_STORE (store));
+
+	g_mutex_lock (&store->priv->mutex);
+	g_hash_table_remove_all (store->priv->fb_cache);
+	g_mutex_unlock (&store->priv->mutex);
+}
+
 guint
 e_meeting_store_get_num_queries (EMeetingStore *store)
 {
@@ -148,6 +148,8 @@ void		e_meeting_store_refresh_busy_periods
 						 EMeetingTime *end,
 						 EMeetingStoreRefreshCallback call_back,
 						 gpointer data);
+void		e_meeting_store_clear_free_busy_cache
+						(EMeetingStore *meeting_store);
 
 guint		e_meeting_store_get_num_queries	(EMeetingStore *meeting_store);
 
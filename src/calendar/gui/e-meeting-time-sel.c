@@ -1599,6 +1599,9 @@ e_meeting_time_selector_on_update_free_busy (GtkWidget *button,
 	if (gtk_widget_get_visible (mts->options_menu))
 		gtk_menu_popdown (GTK_MENU (mts->options_menu));
 
+	/* The user asks for the current information explicitly */
+	e_meeting_store_clear_free_busy_cache (mts->model);
+
 	e_meeting_time_selector_refresh_free_busy (mts, 0, TRUE);
 }
 
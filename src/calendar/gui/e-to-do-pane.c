@@ -35,6 +35,13 @@
 #define N_ROOTS 9
 #define MAX_TOOLTIP_DESCRIPTION_LEN 128
 
+/* Batches of changes larger than this are applied with the sorting
+   turned off, thus the rows are sorted only once, after the batch */
+#define UNSORTED_BATCH_THRESHOLD 32
+
+/* Key of the lazily formatted summary, stored on the ECalComponent */
+#define ETDP_SUMMARY_KEY "e-to-do-pane-summary"
+
 struct _EToDoPanePrivate {
 	GWeakRef shell_view_weakref; /* EShellView * */
 	gboolean highlight_overdue;
@@ -51,6 +58,8 @@ struct _EToDoPanePrivate {
 	ECalDataModel *tasks_data_model;
 	GHashTable *component_refs; /* ComponentIdent * ~> GSList * { GtkTreeRowRefenrece * } */
 	GHashTable *client_colors; /* ESource * ~> GdkRGBA * */
+	GHashTable *pending_changes; /* ComponentIdent * ~> PendingChange * */
+	guint freeze_count;
 
 	GCancellable *cancellable;
 
@@ -61,6 +70,7 @@ struct _EToDoPanePrivate {
 	gulong source_changed_id;
 
 	GtkTreeRowReference *roots[N_ROOTS];
+	guint root_date_marks[N_ROOTS];
 };
 
 enum {
@@ -84,7 +94,6 @@ enum {
 	COLUMN_HAS_ICON_NAME,
 	COLUMN_ICON_NAME,
 	COLUMN_SUMMARY,
-	COLUMN_TOOLTIP,
 	COLUMN_SORTKEY,
 	COLUMN_DATE_MARK,
 	COLUMN_CAL_CLIENT,
@@ -161,6 +170,36 @@ component_ident_equal (gconstpointer ptr1,
 		g_strcmp0 (ci1->rid, ci2->rid) == 0;
 }
 
+typedef struct _PendingChange {
+	ECalClient *client;
+	ECalComponent *comp; /* NULL when the component was removed */
+} PendingChange;
+
+static PendingChange *
+pending_change_new (ECalClient *client,
+		    ECalComponent *comp)
+{
+	PendingChange *pc;
+
+	pc = g_slice_new0 (PendingChange);
+	pc->client = g_object_ref (client);
+	pc->comp = comp ? g_object_ref (comp) : NULL;
+
+	return pc;
+}
+
+static void
+pending_change_free (gpointer ptr)
+{
+	PendingChange *pc = ptr;
+
+	if (pc) {
+		g_clear_object (&pc->client);
+		g_clear_object (&pc->comp);
+		g_slice_free (PendingChange, pc);
+	}
+}
+
 static void
 etdp_free_component_refs (gpointer ptr)
 {
@@ -298,6 +337,7 @@ etdp_format_date_time (ECalClient *client,
 	return e_datetime_format_format_tm ("calendar", "table", itt.is_date ? DTFormatKindDate : DTFormatKindDateTime, &tm);
 }
 
+/* Both the out_summary and the out_tooltip can be NULL, when not needed */
 static gboolean
 etdp_get_component_data (EToDoPane *to_do_pane,
 			 ECalClient *client,
@@ -322,8 +362,6 @@ etdp_get_component_data (EToDoPane *to_do_pane,
 	g_return_val_if_fail (E_IS_TO_DO_PANE (to_do_pane), FALSE);
 	g_return_val_if_fail (E_IS_CAL_CLIENT (client), FALSE);
 	g_return_val_if_fail (E_IS_CAL_COMPONENT (comp), FALSE);
-	g_return_val_if_fail (out_summary, FALSE);
-	g_return_val_if_fail (out_tooltip, FALSE);
 	g_return_val_if_fail (out_is_task, FALSE);
 	g_return_val_if_fail (out_is_completed, FALSE);
 	g_return_val_if_fail (out_sort_key, FALSE);
@@ -336,11 +374,13 @@ etdp_get_component_data (EToDoPane *to_do_pane,
 	if (location && !*location)
 		location = NULL;
 
-	tooltip = g_string_sized_new (512);
+	/* The texts are expensive to construct, thus do it only when asked for */
+	tooltip = out_tooltip ? g_string_sized_new (512) : NULL;
 
-	etdp_append_to_string_escaped (tooltip, "<b>%s</b>", icalcomponent_get_summary (icalcomp), NULL);
+	if (tooltip)
+		etdp_append_to_string_escaped (tooltip, "<b>%s</b>", icalcomponent_get_summary (icalcomp), NULL);
 
-	if (location) {
+	if (location && tooltip) {
 		g_string_append (tooltip, "\n");
 		/* Translators: It will display "Location: LocationOfTheAppointment" */
 		etdp_append_to_string_escaped (tooltip, _("Location: %s"), location, NULL);
@@ -361,15 +401,17 @@ etdp_get_component_data (EToDoPane *to_do_pane,
 		e_cal_component_get_completed (comp, &completed);
 
 		if (dtstart.value) {
-			gchar *tmp;
+			if (tooltip) {
+				gchar *tmp;
 
-			tmp = etdp_format_date_time (client, default_zone, dtstart.value, dtstart.tzid);
+				tmp = etdp_format_date_time (client, default_zone, dtstart.value, dtstart.tzid);
 
-			g_string_append (tooltip, "\n");
-			/* Translators: It will display "Start: StartDateAndTime" */
-			etdp_append_to_string_escaped (tooltip, _("Start: %s"), tmp, NULL);
+				g_string_append (tooltip, "\n");
+				/* Translators: It will display "Start: StartDateAndTime" */
+				etdp_append_to_string_escaped (tooltip, _("Start: %s"), tmp, NULL);
 
-			g_free (tmp);
+				g_free (tmp);
+			}
 
 			if (!dt.value) {
 				/* Fill the itt structure in case the task has no Due date */
@@ -381,29 +423,33 @@ etdp_get_component_data (EToDoPane *to_do_pane,
 		}
 
 		if (dt.value) {
-			gchar *tmp;
+			if (tooltip) {
+				gchar *tmp;
 
-			tmp = etdp_format_date_time (client, default_zone, dt.value, dt.tzid);
+				tmp = etdp_format_date_time (client, default_zone, dt.value, dt.tzid);
 
-			g_string_append (tooltip, "\n");
-			/* Translators: It will display "Due: DueDateAndTime" */
-			etdp_append_to_string_escaped (tooltip, _("Due: %s"), tmp, NULL);
+				g_string_append (tooltip, "\n");
+				/* Translators: It will display "Due: DueDateAndTime" */
+				etdp_append_to_string_escaped (tooltip, _("Due: %s"), tmp, NULL);
 
-			g_free (tmp);
+				g_free (tmp);
+			}
 		} else {
 			task_has_due_date = FALSE;
 		}
 
 		if (completed) {
-			gchar *tmp;
+			if (tooltip) {
+				gchar *tmp;
 
-			tmp = etdp_format_date_time (client, default_zone, completed, NULL);
+				tmp = etdp_format_date_time (client, default_zone, completed, NULL);
 
-			g_string_append (tooltip, "\n");
-			/* Translators: It will display "Completed: DateAndTimeWhenCompleted" */
-			etdp_append_to_string_escaped (tooltip, _("Completed: %s"), tmp, NULL);
+				g_string_append (tooltip, "\n");
+				/* Translators: It will display "Completed: DateAndTimeWhenCompleted" */
+				etdp_append_to_string_escaped (tooltip, _("Completed: %s"), tmp, NULL);
 
-			g_free (tmp);
+				g_free (tmp);
+			}
 
 			*out_is_completed = TRUE;
 			e_cal_component_free_icaltimetype (completed);
@@ -419,7 +465,7 @@ etdp_get_component_data (EToDoPane *to_do_pane,
 
 		e_cal_component_get_dtstart (comp, &dt);
 
-		if (dt.value) {
+		if (dt.value && tooltip) {
 			ECalComponentDateTime dtend = { 0 };
 			struct icaltimetype ittstart, ittend;
 			gchar *strstart, *strduration;
@@ -449,9 +495,10 @@ etdp_get_component_data (EToDoPane *to_do_pane,
 		}
 	}
 
-	*out_summary = NULL;
+	if (out_summary)
+		*out_summary = NULL;
 
-	if (dt.value) {
+	if (dt.value && out_summary) {
 		gchar *time_str;
 
 		time_str = etdp_date_time_to_string (&dt, client, default_zone, today_date_mark, *out_is_task,
@@ -464,25 +511,26 @@ etdp_get_component_data (EToDoPane *to_do_pane,
 		}
 
 		g_free (time_str);
+	} else if (dt.value) {
+		itt = *dt.value;
+		etdp_itt_to_zone (&itt, dt.tzid, client, default_zone);
 	}
 
-	if (!*out_summary) {
-		*out_summary = g_markup_printf_escaped ("%s%s%s%s", icalcomponent_get_summary (icalcomp),
-			location ? " (" : "", location ? location : "", location ? ")" : "");
-	}
-
-	if (*out_is_completed) {
-		gchar *tmp = *out_summary;
+	if (out_summary) {
+		gchar *tmp;
 
-		/* With leading space, to have proper row height in GtkTreeView */
-		*out_summary = g_strdup_printf (" <s>%s</s>", *out_summary);
+		if (!*out_summary) {
+			*out_summary = g_markup_printf_escaped ("%s%s%s%s", icalcomponent_get_summary (icalcomp),
+				location ? " (" : "", location ? location : "", location ? ")" : "");
+		}
 
-		g_free (tmp);
-	} else {
-		gchar *tmp = *out_summary;
+		tmp = *out_summary;
 
 		/* With leading space, to have proper row height in GtkTreeView */
-		*out_summary = g_strconcat (" ", *out_summary, NULL);
+		if (*out_is_completed)
+			*out_summary = g_strdup_printf (" <s>%s</s>", tmp);
+		else
+			*out_summary = g_strconcat (" ", tmp, NULL);
 
 		g_free (tmp);
 	}
@@ -512,7 +560,7 @@ etdp_get_component_data (EToDoPane *to_do_pane,
 	if (id)
 		e_cal_component_free_id (id);
 
-	description = icalcomponent_get_description (icalcomp);
+	description = tooltip ? icalcomponent_get_description (icalcomp) : NULL;
 	if (description && *description && g_utf8_validate (description, -1, NULL)) {
 		gchar *tmp = NULL;
 		glong len;
@@ -536,7 +584,9 @@ etdp_get_component_data (EToDoPane *to_do_pane,
 	}
 
 	*out_date_mark = etdp_create_date_mark (&itt);
-	*out_tooltip = g_string_free (tooltip, FALSE);
+
+	if (out_tooltip)
+		*out_tooltip = g_string_free (tooltip, FALSE);
 
 	return TRUE;
 }
@@ -647,13 +697,11 @@ etdp_get_component_root_paths (EToDoPane *to_do_pane,
 	for (ii = 0; ii < N_ROOTS - 1; ii++) {
 		if (gtk_tree_row_reference_valid (to_do_pane->priv->roots[ii])) {
 			GtkTreePath *root_path;
-			GtkTreeIter root_iter;
-			guint root_date_mark = 0;
+			guint root_date_mark;
 
+			root_date_mark = to_do_pane->priv->root_date_marks[ii];
 			root_path = gtk_tree_row_reference_get_path (to_do_pane->priv->roots[ii]);
-			if (root_path && gtk_tree_model_get_iter (model, &root_iter, root_path)) {
-				gtk_tree_model_get (model, &root_iter, COLUMN_DATE_MARK, &root_date_mark, -1);
-
+			if (root_path) {
 				if (start_date_mark < root_date_mark && (end_date_mark > prev_date_mark ||
 				    (start_date_mark == end_date_mark && end_date_mark >= prev_date_mark))) {
 					roots = g_slist_prepend (roots, gtk_tree_path_copy (root_path));
@@ -864,7 +912,7 @@ etdp_add_component (EToDoPane *to_do_pane,
 	GtkTreeIter iter = { 0 };
 	GdkRGBA bgcolor, fgcolor;
 	gboolean bgcolor_set = FALSE, fgcolor_set = FALSE;
-	gchar *summary = NULL, *tooltip = NULL, *sort_key = NULL;
+	gchar *sort_key = NULL;
 	gboolean is_task = FALSE, is_completed = FALSE;
 	const gchar *icon_name;
 	guint date_mark = 0;
@@ -878,12 +926,16 @@ etdp_add_component (EToDoPane *to_do_pane,
 
 	default_zone = e_cal_data_model_get_timezone (to_do_pane->priv->events_data_model);
 
+	/* The summary and the tooltip are formatted only when needed by the view */
 	if (!etdp_get_component_data (to_do_pane, client, comp, default_zone, to_do_pane->priv->last_today,
-		&summary, &tooltip, &is_task, &is_completed, &sort_key, &date_mark)) {
+		NULL, NULL, &is_task, &is_completed, &sort_key, &date_mark)) {
 		e_cal_component_free_id (id);
 		return;
 	}
 
+	/* Drop any previously formatted summary, it can be outdated now */
+	g_object_set_data (G_OBJECT (comp), ETDP_SUMMARY_KEY, NULL);
+
 	model = GTK_TREE_MODEL (to_do_pane->priv->tree_store);
 	ident = component_ident_new (client, id->uid, id->rid);
 
@@ -922,8 +974,6 @@ etdp_add_component (EToDoPane *to_do_pane,
 					COLUMN_FGCOLOR, fgcolor_set ? &fgcolor : NULL,
 					COLUMN_HAS_ICON_NAME, TRUE,
 					COLUMN_ICON_NAME, icon_name,
-					COLUMN_SUMMARY, summary,
-					COLUMN_TOOLTIP, tooltip,
 					COLUMN_SORTKEY, sort_key,
 					COLUMN_DATE_MARK, date_mark,
 					COLUMN_CAL_CLIENT, client,
@@ -939,11 +989,95 @@ etdp_add_component (EToDoPane *to_do_pane,
 
 	component_ident_free (ident);
 	e_cal_component_free_id (id);
-	g_free (summary);
-	g_free (tooltip);
 	g_free (sort_key);
 }
 
+static void
+etdp_remove_component (EToDoPane *to_do_pane,
+		       ECalClient *client,
+		       const gchar *uid,
+		       const gchar *rid)
+{
+	ComponentIdent ident;
+	GSList *link;
+
+	g_return_if_fail (E_IS_TO_DO_PANE (to_do_pane));
+
+	ident.client = client;
+	ident.uid = (gchar *) uid;
+	ident.rid = (gchar *) (rid && *rid ? rid : NULL);
+
+	for (link = g_hash_table_lookup (to_do_pane->priv->component_refs, &ident); link; link = g_slist_next (link)) {
+		GtkTreeRowReference *reference = link->data;
+
+		if (reference && gtk_tree_row_reference_valid (reference)) {
+			GtkTreePath *path;
+			GtkTreeIter iter;
+
+			path = gtk_tree_row_reference_get_path (reference);
+
+			if (path && gtk_tree_model_get_iter (gtk_tree_row_reference_get_model (reference), &iter, path)) {
+				gtk_tree_store_remove (to_do_pane->priv->tree_store, &iter);
+			}
+
+			gtk_tree_path_free (path);
+		}
+	}
+
+	g_hash_table_remove (to_do_pane->priv->component_refs, &ident);
+}
+
+static void
+etdp_queue_change (EToDoPane *to_do_pane,
+		   ECalClient *client,
+		   const gchar *uid,
+		   const gchar *rid,
+		   ECalComponent *comp)
+{
+	g_return_if_fail (E_IS_TO_DO_PANE (to_do_pane));
+	g_return_if_fail (E_IS_CAL_CLIENT (client));
+
+	/* The later change of the same component replaces the earlier one */
+	g_hash_table_insert (to_do_pane->priv->pending_changes,
+		component_ident_new (client, uid, rid),
+		pending_change_new (client, comp));
+}
+
+static void
+etdp_flush_pending_changes (EToDoPane *to_do_pane)
+{
+	GtkTreeSortable *sortable = NULL;
+	GHashTableIter iter;
+	gpointer key, value;
+
+	g_return_if_fail (E_IS_TO_DO_PANE (to_do_pane));
+
+	if (!g_hash_table_size (to_do_pane->priv->pending_changes))
+		return;
+
+	/* Do not re-sort the view after each row, but only once at the end */
+	if (g_hash_table_size (to_do_pane->priv->pending_changes) > UNSORTED_BATCH_THRESHOLD) {
+		sortable = GTK_TREE_SORTABLE (gtk_tree_view_get_model (to_do_pane->priv->tree_view));
+		gtk_tree_sortable_set_sort_column_id (sortable, GTK_TREE_SORTABLE_UNSORTED_SORT_COLUMN_ID, GTK_SORT_ASCENDING);
+	}
+
+	g_hash_table_iter_init (&iter, to_do_pane->priv->pending_changes);
+	while (g_hash_table_iter_next (&iter, &key, &value)) {
+		ComponentIdent *ident = key;
+		PendingChange *pc = value;
+
+		if (pc->comp)
+			etdp_add_component (to_do_pane, pc->client, pc->comp);
+		else
+			etdp_remove_component (to_do_pane, pc->client, ident->uid, ident->rid);
+	}
+
+	g_hash_table_remove_all (to_do_pane->priv->pending_changes);
+
+	if (sortable)
+		gtk_tree_sortable_set_sort_column_id (sortable, COLUMN_SORTKEY, GTK_SORT_ASCENDING);
+}
+
 static void
 etdp_got_client_cb (GObject *source_object,
 		    GAsyncResult *result,
@@ -1064,6 +1198,27 @@ e_to_do_pane_watcher_disappeared_cb (ESourceRegistryWatcher *watcher,
 		e_cal_data_model_remove_client (to_do_pane->priv->tasks_data_model, e_source_get_uid (source));
 }
 
+static void
+etdp_add_or_queue_component (EToDoPane *to_do_pane,
+			     ECalClient *client,
+			     ECalComponent *comp)
+{
+	g_return_if_fail (E_IS_TO_DO_PANE (to_do_pane));
+
+	if (to_do_pane->priv->freeze_count) {
+		ECalComponentId *id;
+
+		id = e_cal_component_get_id (comp);
+		g_return_if_fail (id != NULL);
+
+		etdp_queue_change (to_do_pane, client, id->uid, id->rid, comp);
+
+		e_cal_component_free_id (id);
+	} else {
+		etdp_add_component (to_do_pane, client, comp);
+	}
+}
+
 static void
 etdp_data_subscriber_component_added (ECalDataModelSubscriber *subscriber,
 				      ECalClient *client,
@@ -1071,7 +1226,7 @@ etdp_data_subscriber_component_added (ECalDataModelSubscriber *subscriber,
 {
 	g_return_if_fail (E_IS_TO_DO_PANE (subscriber));
 
-	etdp_add_component (E_TO_DO_PANE (subscriber), client, comp);
+	etdp_add_or_queue_component (E_TO_DO_PANE (subscriber), client, comp);
 }
 
 static void
@@ -1081,7 +1236,7 @@ etdp_data_subscriber_component_modified (ECalDataModelSubscriber *subscriber,
 {
 	g_return_if_fail (E_IS_TO_DO_PANE (subscriber));
 
-	etdp_add_component (E_TO_DO_PANE (subscriber), client, comp);
+	etdp_add_or_queue_component (E_TO_DO_PANE (subscriber), client, comp);
 }
 
 static void
@@ -1091,47 +1246,43 @@ etdp_data_subscriber_component_removed (ECalDataModelSubscriber *subscriber,
 					const gchar *rid)
 {
 	EToDoPane *to_do_pane;
-	ComponentIdent ident;
-	GSList *link;
 
 	g_return_if_fail (E_IS_TO_DO_PANE (subscriber));
 
 	to_do_pane = E_TO_DO_PANE (subscriber);
 
-	ident.client = client;
-	ident.uid = (gchar *) uid;
-	ident.rid = (gchar *) (rid && *rid ? rid : NULL);
-
-	for (link = g_hash_table_lookup (to_do_pane->priv->component_refs, &ident); link; link = g_slist_next (link)) {
-		GtkTreeRowReference *reference = link->data;
-
-		if (reference && gtk_tree_row_reference_valid (reference)) {
-			GtkTreePath *path;
-			GtkTreeIter iter;
-
-			path = gtk_tree_row_reference_get_path (reference);
-
-			if (path && gtk_tree_model_get_iter (gtk_tree_row_reference_get_model (reference), &iter, path)) {
-				gtk_tree_store_remove (to_do_pane->priv->tree_store, &iter);
-			}
-
-			gtk_tree_path_free (path);
-		}
-	}
-
-	g_hash_table_remove (to_do_pane->priv->component_refs, &ident);
+	if (to_do_pane->priv->freeze_count)
+		etdp_queue_change (to_do_pane, client, uid, rid, NULL);
+	else
+		etdp_remove_component (to_do_pane, client, uid, rid);
 }
 
 static void
 etdp_data_subscriber_freeze (ECalDataModelSubscriber *subscriber)
 {
+	EToDoPane *to_do_pane;
+
 	g_return_if_fail (E_IS_TO_DO_PANE (subscriber));
+
+	to_do_pane = E_TO_DO_PANE (subscriber);
+	to_do_pane->priv->freeze_count++;
 }
 
 static void
 etdp_data_subscriber_thaw (ECalDataModelSubscriber *subscriber)
 {
+	EToDoPane *to_do_pane;
+
 	g_return_if_fail (E_IS_TO_DO_PANE (subscriber));
+
+	to_do_pane = E_TO_DO_PANE (subscriber);
+
+	g_return_if_fail (to_do_pane->priv->freeze_count > 0);
+
+	to_do_pane->priv->freeze_count--;
+
+	if (!to_do_pane->priv->freeze_count)
+		etdp_flush_pending_changes (to_do_pane);
 }
 
 static GCancellable *
@@ -1475,6 +1626,8 @@ etdp_check_time_changed (EToDoPane *to_do_pane,
 					COLUMN_DATE_MARK, date_mark,
 					-1);
 
+				to_do_pane->priv->root_date_marks[ii] = date_mark;
+
 				g_free (markup);
 			} else {
 				icaltime_adjust (&itt, 1, 0, 0, 0);
@@ -1619,6 +1772,117 @@ etdp_row_activated_cb (GtkTreeView *tree_view,
 	}
 }
 
+static void
+etdp_summary_cell_data_func (GtkTreeViewColumn *column,
+			     GtkCellRenderer *renderer,
+			     GtkTreeModel *model,
+			     GtkTreeIter *iter,
+			     gpointer user_data)
+{
+	EToDoPane *to_do_pane = user_data;
+	ECalClient *client = NULL;
+	ECalComponent *comp = NULL;
+	gchar *summary = NULL;
+
+	g_return_if_fail (E_IS_TO_DO_PANE (to_do_pane));
+
+	gtk_tree_model_get (model, iter,
+		COLUMN_SUMMARY, &summary,
+		COLUMN_CAL_CLIENT, &client,
+		COLUMN_CAL_COMPONENT, &comp,
+		-1);
+
+	/* The root rows have their summary set, the component rows have it
+	   formatted only when the row is needed by the view for the first time */
+	if (client && comp && !summary) {
+		const gchar *cached;
+
+		cached = g_object_get_data (G_OBJECT (comp), ETDP_SUMMARY_KEY);
+
+		if (cached) {
+			summary = g_strdup (cached);
+		} else {
+			icaltimezone *default_zone;
+			gchar *sort_key = NULL;
+			gboolean is_task = FALSE, is_completed = FALSE;
+			guint date_mark = 0;
+
+			default_zone = e_cal_data_model_get_timezone (to_do_pane->priv->events_data_model);
+
+			if (etdp_get_component_data (to_do_pane, client, comp, default_zone, to_do_pane->priv->last_today,
+				&summary, NULL, &is_task, &is_completed, &sort_key, &date_mark)) {
+				g_object_set_data_full (G_OBJECT (comp), ETDP_SUMMARY_KEY, g_strdup (summary), g_free);
+			}
+
+			g_free (sort_key);
+		}
+	}
+
+	g_object_set (renderer, "markup", summary, NULL);
+
+	g_clear_object (&client);
+	g_clear_object (&comp);
+	g_free (summary);
+}
+
+static gboolean
+etdp_query_tooltip_cb (GtkWidget *widget,
+		       gint x,
+		       gint y,
+		       gboolean keyboard_mode,
+		       GtkTooltip *tooltip,
+		       gpointer user_data)
+{
+	EToDoPane *to_do_pane = user_data;
+	GtkTreeView *tree_view;
+	GtkTreeModel *model = NULL;
+	GtkTreePath *path = NULL;
+	GtkTreeIter iter;
+	ECalClient *client = NULL;
+	ECalComponent *comp = NULL;
+	gchar *text = NULL;
+
+	g_return_val_if_fail (E_IS_TO_DO_PANE (to_do_pane), FALSE);
+
+	tree_view = GTK_TREE_VIEW (widget);
+
+	if (!gtk_tree_view_get_tooltip_context (tree_view, &x, &y, keyboard_mode, &model, &path, &iter))
+		return FALSE;
+
+	gtk_tree_model_get (model, &iter,
+		COLUMN_CAL_CLIENT, &client,
+		COLUMN_CAL_COMPONENT, &comp,
+		-1);
+
+	if (client && comp) {
+		icaltimezone *default_zone;
+		gchar *sort_key = NULL;
+		gboolean is_task = FALSE, is_completed = FALSE;
+		guint date_mark = 0;
+
+		default_zone = e_cal_data_model_get_timezone (to_do_pane->priv->events_data_model);
+
+		if (etdp_get_component_data (to_do_pane, client, comp, default_zone, to_do_pane->priv->last_today,
+			NULL, &text, &is_task, &is_completed, &sort_key, &date_mark)) {
+			gtk_tooltip_set_markup (tooltip, text);
+			gtk_tree_view_set_tooltip_row (tree_view, tooltip, path);
+		}
+
+		g_free (sort_key);
+	}
+
+	g_clear_object (&client);
+	g_clear_object (&comp);
+	gtk_tree_path_free (path);
+
+	if (text) {
+		g_free (text);
+		return TRUE;
+	}
+
+	return FALSE;
+}
+
 static void
 etdp_source_changed_cb (ESourceRegistry *registry,
 			ESource *source,
@@ -2373,7 +2637,6 @@ e_to_do_pane_constructed (GObject *object)
 		G_TYPE_BOOLEAN,		/* COLUMN_HAS_ICON_NAME */
 		G_TYPE_STRING,		/* COLUMN_ICON_NAME */
 		G_TYPE_STRING,		/* COLUMN_SUMMARY */
-		G_TYPE_STRING,		/* COLUMN_TOOLTIP */
 		G_TYPE_STRING,		/* COLUMN_SORTKEY */
 		G_TYPE_UINT,		/* COLUMN_DATE_MARK */
 		E_TYPE_CAL_CLIENT,	/* COLUMN_CAL_CLIENT */
@@ -2445,11 +2708,13 @@ e_to_do_pane_constructed (GObject *object)
 	gtk_tree_view_column_pack_start (column, renderer, TRUE);
 
 	gtk_tree_view_column_set_attributes (column, renderer,
-		"markup", COLUMN_SUMMARY,
 		"background-rgba", COLUMN_BGCOLOR,
 		"foreground-rgba", COLUMN_FGCOLOR,
 		NULL);
 
+	gtk_tree_view_column_set_cell_data_func (column, renderer,
+		etdp_summary_cell_data_func, to_do_pane, NULL);
+
 	gtk_tree_view_append_column (tree_view, column);
 	gtk_tree_view_set_expander_column (tree_view, column);
 
@@ -2476,7 +2741,7 @@ e_to_do_pane_constructed (GObject *object)
 	}
 
 	gtk_tree_view_set_headers_visible (tree_view, FALSE);
-	gtk_tree_view_set_tooltip_column (tree_view, COLUMN_TOOLTIP);
+	gtk_widget_set_has_tooltip (GTK_WIDGET (tree_view), TRUE);
 
 	gtk_widget_show_all (GTK_WIDGET (grid));
 
@@ -2537,6 +2802,9 @@ e_to_do_pane_constructed (GObject *object)
 	g_signal_connect (tree_view, "popup-menu",
 		G_CALLBACK (etdp_popup_menu_cb), to_do_pane);
 
+	g_signal_connect (tree_view, "query-tooltip",
+		G_CALLBACK (etdp_query_tooltip_cb), to_do_pane);
+
 	to_do_pane->priv->tree_view = tree_view;
 
 	etdp_check_time_changed (to_do_pane, TRUE);
@@ -2580,6 +2848,7 @@ e_to_do_pane_dispose (GObject *object)
 
 	g_hash_table_remove_all (to_do_pane->priv->component_refs);
 	g_hash_table_remove_all (to_do_pane->priv->client_colors);
+	g_hash_table_remove_all (to_do_pane->priv->pending_changes);
 
 	g_clear_object (&to_do_pane->priv->client_cache);
 	g_clear_object (&to_do_pane->priv->watcher);
@@ -2602,6 +2871,7 @@ e_to_do_pane_finalize (GObject *object)
 
 	g_hash_table_destroy (to_do_pane->priv->component_refs);
 	g_hash_table_destroy (to_do_pane->priv->client_colors);
+	g_hash_table_destroy (to_do_pane->priv->pending_changes);
 
 	if (to_do_pane->priv->overdue_color)
 		gdk_rgba_free (to_do_pane->priv->overdue_color);
@@ -2622,6 +2892,9 @@ e_to_do_pane_init (EToDoPane *to_do_pane)
 	to_do_pane->priv->client_colors = g_hash_table_new_full (g_direct_hash, g_direct_equal,
 		NULL, (GDestroyNotify) gdk_rgba_free);
 
+	to_do_pane->priv->pending_changes = g_hash_table_new_full (component_ident_hash, component_ident_equal,
+		component_ident_free, pending_change_free);
+
 	to_do_pane->priv->nearest_due = (time_t) -1;
 
 	g_weak_ref_init (&to_do_pane->priv->shell_view_weakref, NULL);
@@ -41,8 +41,14 @@ struct _ETagCalendarPrivate
 	GHashTable *objects;	/* ObjectInfo ~> 1 (unused) */
 	GHashTable *dates;	/* julian date ~> DateInfo */
 
+	/* shown days */
 	guint32 range_start_julian;
 	guint32 range_end_julian;
+
+	/* days covered by the 'dates', the same as the shown days once
+	   the range is set; zeros when nothing is indexed yet */
+	guint32 indexed_start_julian;
+	guint32 indexed_end_julian;
 };
 
 enum {
@@ -112,7 +118,7 @@ object_info_data_equal (ObjectInfo *o1,
 		return FALSE;
 
 	return (o1->is_transparent ? 1: 0) == (o2->is_transparent ? 1 : 0) &&
-	       (o1->start_julian ? 1: 0) == (o2->is_recurring ? 1 : 0) &&
+	       (o1->is_recurring ? 1: 0) == (o2->is_recurring ? 1 : 0) &&
 	       (o1->start_julian == o2->start_julian) &&
 	       (o1->end_julian == o2->end_julian);
 }
@@ -259,29 +265,94 @@ decode_julian (guint32 julian,
 }
 
 static void
-tag_calendar_date_cb (gpointer key,
-		      gpointer value,
-		      gpointer user_data)
+e_tag_calendar_remark_days (ETagCalendar *tag_calendar)
 {
-	ETagCalendar *tag_calendar = user_data;
-	DateInfo *dinfo = value;
-	gint year, month, day;
+	guint32 dt;
+
+	g_return_if_fail (E_IS_TAG_CALENDAR (tag_calendar));
+	g_return_if_fail (tag_calendar->priv->calitem != NULL);
+
+	e_calendar_item_clear_marks (tag_calendar->priv->calitem);
+
+	if (!tag_calendar->priv->range_start_julian)
+		return;
+
+	/* Only the shown days are marked, the index can contain much more */
+	for (dt = tag_calendar->priv->range_start_julian; dt <= tag_calendar->priv->range_end_julian; dt++) {
+		DateInfo *dinfo;
+		gint year, month, day;
+
+		dinfo = g_hash_table_lookup (tag_calendar->priv->dates, GUINT_TO_POINTER (dt));
+		if (!dinfo)
+			continue;
 
-	decode_julian (GPOINTER_TO_UINT (key), &year, &month, &day);
+		decode_julian (dt, &year, &month, &day);
 
-	e_calendar_item_mark_day (tag_calendar->priv->calitem, year, month - 1, day,
-		date_info_get_style (dinfo, tag_calendar->priv->recur_events_italic), FALSE);
+		e_calendar_item_mark_day (tag_calendar->priv->calitem, year, month - 1, day,
+			date_info_get_style (dinfo, tag_calendar->priv->recur_events_italic), FALSE);
+	}
+}
+
+static gboolean
+tag_calendar_remove_unindexed_date_cb (gpointer key,
+				       gpointer value,
+				       gpointer user_data)
+{
+	ETagCalendar *tag_calendar = user_data;
+	guint32 dt = GPOINTER_TO_UINT (key);
+
+	return dt < tag_calendar->priv->indexed_start_julian ||
+	       dt > tag_calendar->priv->indexed_end_julian;
 }
 
+/* Changes the range of days covered by the index of dates. Days newly
+   covered get counts of the already known components, days, which are
+   not covered anymore, are forgotten. */
 static void
-e_tag_calendar_remark_days (ETagCalendar *tag_calendar)
+e_tag_calendar_set_indexed_range (ETagCalendar *tag_calendar,
+				  guint32 start_julian,
+				  guint32 end_julian)
 {
-	g_return_if_fail (E_IS_TAG_CALENDAR (tag_calendar));
-	g_return_if_fail (tag_calendar->priv->calitem != NULL);
+	guint32 old_start_julian, old_end_julian;
+	GHashTableIter iter;
+	gpointer key;
 
-	e_calendar_item_clear_marks (tag_calendar->priv->calitem);
+	old_start_julian = tag_calendar->priv->indexed_start_julian;
+	old_end_julian = tag_calendar->priv->indexed_end_julian;
+
+	if (old_start_julian == start_julian && old_end_julian == end_julian)
+		return;
 
-	g_hash_table_foreach (tag_calendar->priv->dates, tag_calendar_date_cb, tag_calendar);
+	tag_calendar->priv->indexed_start_julian = start_julian;
+	tag_calendar->priv->indexed_end_julian = end_julian;
+
+	if (old_start_julian)
+		g_hash_table_foreach_remove (tag_calendar->priv->dates, tag_calendar_remove_unindexed_date_cb, tag_calendar);
+
+	g_hash_table_iter_init (&iter, tag_calendar->priv->objects);
+	while (g_hash_table_iter_next (&iter, &key, NULL)) {
+		ObjectInfo *oinfo = key;
+		guint32 dt, from_julian, to_julian;
+
+		from_julian = MAX (oinfo->start_julian, start_julian);
+		to_julian = MIN (oinfo->end_julian, end_julian);
+
+		for (dt = from_julian; dt <= to_julian; dt++) {
+			DateInfo *dinfo;
+
+			/* Already counted */
+			if (old_start_julian && dt >= old_start_julian && dt <= old_end_julian)
+				continue;
+
+			dinfo = g_hash_table_lookup (tag_calendar->priv->dates, GUINT_TO_POINTER (dt));
+			if (!dinfo) {
+				dinfo = date_info_new ();
+				g_hash_table_insert (tag_calendar->priv->dates, GUINT_TO_POINTER (dt), dinfo);
+			}
+
+			date_info_update (dinfo, oinfo, TRUE);
+		}
+	}
 }
 
 static time_t
@@ -307,6 +378,7 @@ static void
 e_tag_calendar_date_range_changed_cb (ETagCalendar *tag_calendar)
 {
 	gint start_year, start_month, start_day, end_year, end_month, end_day;
+	guint32 start_julian, end_julian;
 	time_t range_start, range_end;
 
 	g_return_if_fail (E_IS_TAG_CALENDAR (tag_calendar));
@@ -325,15 +397,25 @@ e_tag_calendar_date_range_changed_cb (ETagCalendar *tag_calendar)
 	start_month++;
 	end_month++;
 
-	range_start = e_tag_calendar_date_to_timet (start_year, start_month, start_day, NULL);
-	range_end = e_tag_calendar_date_to_timet (end_year, end_month, end_day, NULL);
+	start_julian = encode_ymd_to_julian (start_year, start_month, start_day);
+	end_julian = encode_ymd_to_julian (end_year, end_month, end_day);
+
+	tag_calendar->priv->range_start_julian = start_julian;
+	tag_calendar->priv->range_end_julian = end_julian;
 
-	tag_calendar->priv->range_start_julian = encode_ymd_to_julian (start_year, start_month, start_day);
-	tag_calendar->priv->range_end_julian = encode_ymd_to_julian (end_year, end_month, end_day);
+	/* Keep what is known about the days, which are still shown; the data
+	   model notifies only about the components of the newly shown days
+	   and removes those, which moved out of the shown range. Only the shown
+	   range is subscribed, because the data model queries the union
+	   of the ranges of all its subscribers. */
+	e_tag_calendar_set_indexed_range (tag_calendar, start_julian, end_julian);
 
 	/* Range change causes removal of marks in the calendar */
 	e_tag_calendar_remark_days (tag_calendar);
 
+	range_start = e_tag_calendar_date_to_timet (start_year, start_month, start_day, NULL);
+	range_end = e_tag_calendar_date_to_timet (end_year, end_month, end_day, NULL);
+
 	e_cal_data_model_subscribe (tag_calendar->priv->data_model,
 		E_CAL_DATA_MODEL_SUBSCRIBER (tag_calendar),
 		range_start, range_end);
@@ -418,16 +500,9 @@ e_tag_calendar_update_by_oinfo (ETagCalendar *tag_calendar,
 	if (!oinfo)
 		return;
 
-	start_julian = oinfo->start_julian;
-	end_julian = oinfo->end_julian;
-
-	if (inc) {
-		if (start_julian < tag_calendar->priv->range_start_julian)
-			start_julian = tag_calendar->priv->range_start_julian;
-
-		if (end_julian > tag_calendar->priv->range_end_julian)
-			end_julian = tag_calendar->priv->range_end_julian;
-	}
+	/* The index holds only the indexed days */
+	start_julian = MAX (oinfo->start_julian, tag_calendar->priv->indexed_start_julian);
+	end_julian = MIN (oinfo->end_julian, tag_calendar->priv->indexed_end_julian);
 
 	for (dt = start_julian; dt <= end_julian; dt++) {
 		dinfo = g_hash_table_lookup (tag_calendar->priv->dates, GUINT_TO_POINTER (dt));
@@ -444,10 +519,14 @@ e_tag_calendar_update_by_oinfo (ETagCalendar *tag_calendar,
 			gint year, month, day;
 			guint8 style;
 
-			decode_julian (dt, &year, &month, &day);
 			style = date_info_get_style (dinfo, tag_calendar->priv->recur_events_italic);
 
-			e_calendar_item_mark_day (calitem, year, month - 1, day, style, FALSE);
+			if (dt >= tag_calendar->priv->range_start_julian &&
+			    dt <= tag_calendar->priv->range_end_julian) {
+				decode_julian (dt, &year, &month, &day);
+
+				e_calendar_item_mark_day (calitem, year, month - 1, day, style, FALSE);
+			}
 
 			if (!style && !inc)
 				g_hash_table_remove (tag_calendar->priv->dates, GUINT_TO_POINTER (dt));
@@ -467,50 +546,16 @@ e_tag_calendar_update_component_dates (ETagCalendar *tag_calendar,
 }
 
 static void
-e_tag_calendar_data_subscriber_component_added (ECalDataModelSubscriber *subscriber,
-						ECalClient *client,
-						ECalComponent *comp)
-{
-	ETagCalendar *tag_calendar;
-	ECalComponentTransparency transparency;
-	guint32 start_julian = 0, end_julian = 0;
-	ObjectInfo *oinfo;
-
-	g_return_if_fail (E_IS_TAG_CALENDAR (subscriber));
-
-	tag_calendar = E_TAG_CALENDAR (subscriber);
-
-	get_component_julian_range (client, comp, &start_julian, &end_julian);
-	if (start_julian == 0 || end_julian == 0)
-		return;
-
-	e_cal_component_get_transparency (comp, &transparency);
-
-	oinfo = object_info_new (client, e_cal_component_get_id (comp),
-		transparency == E_CAL_COMPONENT_TRANSP_TRANSPARENT,
-		e_cal_component_is_instance (comp),
-		start_julian, end_julian);
-
-	e_tag_calendar_update_component_dates (tag_calendar, NULL, oinfo);
-
-	g_hash_table_insert (tag_calendar->priv->objects, oinfo, GINT_TO_POINTER (0));
-}
-
-static void
-e_tag_calendar_data_subscriber_component_modified (ECalDataModelSubscriber *subscriber,
-						   ECalClient *client,
-						   ECalComponent *comp)
+e_tag_calendar_store_component (ETagCalendar *tag_calendar,
+				ECalClient *client,
+				ECalComponent *comp,
+				gboolean add_if_missing)
 {
-	ETagCalendar *tag_calendar;
 	ECalComponentTransparency transparency;
 	guint32 start_julian = 0, end_julian = 0;
 	gpointer orig_key, orig_value;
 	ObjectInfo *old_oinfo = NULL, *new_oinfo;
 
-	g_return_if_fail (E_IS_TAG_CALENDAR (subscriber));
-
-	tag_calendar = E_TAG_CALENDAR (subscriber);
-
 	get_component_julian_range (client, comp, &start_julian, &end_julian);
 	if (start_julian == 0 || end_julian == 0)
 		return;
@@ -522,14 +567,15 @@ e_tag_calendar_data_subscriber_component_modified (ECalDataModelSubscriber *subs
 		e_cal_component_is_instance (comp),
 		start_julian, end_julian);
 
-	if (!g_hash_table_lookup_extended (tag_calendar->priv->objects, new_oinfo, &orig_key, &orig_value)) {
+	/* The component can be known already, when it was added for another range */
+	if (g_hash_table_lookup_extended (tag_calendar->priv->objects, new_oinfo, &orig_key, &orig_value)) {
+		old_oinfo = orig_key;
+	} else if (!add_if_missing) {
 		object_info_free (new_oinfo);
 		return;
 	}
 
-	old_oinfo = orig_key;
-
-	if (object_info_data_equal (old_oinfo, new_oinfo)) {
+	if (old_oinfo && object_info_data_equal (old_oinfo, new_oinfo)) {
 		object_info_free (new_oinfo);
 		return;
 	}
@@ -537,7 +583,27 @@ e_tag_calendar_data_subscriber_component_modified (ECalDataModelSubscriber *subs
 	e_tag_calendar_update_component_dates (tag_calendar, old_oinfo, new_oinfo);
 
 	/* it also frees old_oinfo */
-	g_hash_table_insert (tag_calendar->priv->objects, new_oinfo, GINT_TO_POINTER (0));
+	g_hash_table_replace (tag_calendar->priv->objects, new_oinfo, GINT_TO_POINTER (0));
+}
+
+static void
+e_tag_calendar_data_subscriber_component_added (ECalDataModelSubscriber *subscriber,
+						ECalClient *client,
+						ECalComponent *comp)
+{
+	g_return_if_fail (E_IS_TAG_CALENDAR (subscriber));
+
+	e_tag_calendar_store_component (E_TAG_CALENDAR (subscriber), client, comp, TRUE);
+}
+
+static void
+e_tag_calendar_data_subscriber_component_modified (ECalDataModelSubscriber *subscriber,
+						   ECalClient *client,
+						   ECalComponent *comp)
+{
+	g_return_if_fail (E_IS_TAG_CALENDAR (subscriber));
+
+	e_tag_calendar_store_component (E_TAG_CALENDAR (subscriber), client, comp, FALSE);
 }
 
 static void
@@ -858,6 +924,9 @@ e_tag_calendar_unsubscribe (ETagCalendar *tag_calendar,
 
 	g_hash_table_remove_all (tag_calendar->priv->objects);
 	g_hash_table_remove_all (tag_calendar->priv->dates);
+
+	tag_calendar->priv->indexed_start_julian = 0;
+	tag_calendar->priv->indexed_end_julian = 0;
 }
 
 struct calendar_tag_closure {
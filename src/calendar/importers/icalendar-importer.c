@@ -44,6 +44,12 @@
 /* We timeout after 2 minutes, when opening the folders. */
 #define IMPORTER_TIMEOUT_SECONDS 120
 
+/* How much of the file is read to decide whether it is an iCalendar file */
+#define ICAL_SNIFF_SIZE (16 * 1024)
+
+/* How many events and tasks are shown in the preview at most */
+#define ICAL_PREVIEW_MAX_COMPONENTS 500
+
 typedef struct {
 	EImport *import;
 	EImportTarget *target;
@@ -53,7 +59,9 @@ typedef struct {
 	ECalClient *cal_client;
 	ECalClientSourceType source_type;
 
+	/* Either a parsed component or a file to be read incrementally */
 	icalcomponent *icalcomp;
+	gchar *filename;
 
 	GCancellable *cancellable;
 } ICalImporter;
@@ -98,7 +106,9 @@ ivcal_import_done (ICalImporter *ici,
 {
 	if (ici->cal_client)
 		g_object_unref (ici->cal_client);
-	icalcomponent_free (ici->icalcomp);
+	if (ici->icalcomp)
+		icalcomponent_free (ici->icalcomp);
+	g_free (ici->filename);
 
 	e_import_complete (ici->import, ici->target, error);
 	g_object_unref (ici->import);
@@ -166,12 +176,405 @@ prepare_tasks (icalcomponent *icalcomp,
 	g_list_free (vtodos);
 }
 
+typedef void (* ICalStreamReaderProgressFunc) (goffset bytes_read,
+					       gpointer user_data);
+
+/* Reads a (possibly huge) iCalendar file line by line and hands out its
+ * top-level subcomponents one at a time, so the whole VCALENDAR never has
+ * to be held in memory. Only components whose name is in 'names' are
+ * collected and parsed, everything else is skipped while scanning. */
+typedef struct _ICalStreamReader {
+	GDataInputStream *data_stream;
+	const gchar * const *names;
+	goffset size;
+	goffset bytes_read;
+	goffset notified_bytes;
+	ICalStreamReaderProgressFunc progress_func;
+	gpointer progress_data;
+	gint depth;
+	gint comp_depth;
+	gboolean in_vcalendar;
+	gboolean in_component;
+	GString *buffer;
+	icalproperty_method method;
+} ICalStreamReader;
+
+static void
+ical_stream_reader_free (ICalStreamReader *reader)
+{
+	if (!reader)
+		return;
+
+	g_clear_object (&reader->data_stream);
+	g_string_free (reader->buffer, TRUE);
+	g_free (reader);
+}
+
+static ICalStreamReader *
+ical_stream_reader_new (const gchar *filename,
+			const gchar * const *names,
+			GCancellable *cancellable,
+			GError **error)
+{
+	ICalStreamReader *reader;
+	GFileInputStream *file_stream;
+	GFileInfo *info;
+	GFile *file;
+
+	g_return_val_if_fail (filename != NULL, NULL);
+	g_return_val_if_fail (names != NULL, NULL);
+
+	file = g_file_new_for_path (filename);
+	file_stream = g_file_read (file, cancellable, error);
+	if (!file_stream) {
+		g_object_unref (file);
+		return NULL;
+	}
+
+	reader = g_new0 (ICalStreamReader, 1);
+	reader->data_stream = g_data_input_stream_new (G_INPUT_STREAM (file_stream));
+	reader->names = names;
+	reader->buffer = g_string_sized_new (4096);
+	reader->method = ICAL_METHOD_NONE;
+
+	g_data_input_stream_set_newline_type (reader->data_stream, G_DATA_STREAM_NEWLINE_TYPE_ANY);
+
+	info = g_file_input_stream_query_info (file_stream, G_FILE_ATTRIBUTE_STANDARD_SIZE, cancellable, NULL);
+	if (info) {
+		reader->size = g_file_info_get_size (info);
+		g_object_unref (info);
+	}
+
+	g_object_unref (file_stream);
+	g_object_unref (file);
+
+	return reader;
+}
+
+static gboolean
+ical_stream_reader_line_is (const gchar *line,
+			    const gchar *prefix,
+			    const gchar **out_value)
+{
+	gsize len = strlen (prefix);
+
+	if (g_ascii_strncasecmp (line, prefix, len) != 0)
+		return FALSE;
+
+	if (out_value)
+		*out_value = line + len;
+
+	return TRUE;
+}
+
+static gboolean
+ical_stream_reader_wants (ICalStreamReader *reader,
+			  const gchar *name)
+{
+	gint ii;
+
+	for (ii = 0; reader->names[ii]; ii++) {
+		if (g_ascii_strcasecmp (reader->names[ii], name) == 0)
+			return TRUE;
+	}
+
+	return FALSE;
+}
+
+/* Returns the next wanted top-level subcomponent, or NULL at the end of the
+ * file or on error. Components which fail to parse are skipped. */
+static icalcomponent *
+ical_stream_reader_next (ICalStreamReader *reader,
+			 GCancellable *cancellable,
+			 GError **error)
+{
+	gchar *line;
+	gsize len = 0;
+
+	g_return_val_if_fail (reader != NULL, NULL);
+
+	while ((line = g_data_input_stream_read_line (reader->data_stream, &len, cancellable, error)) != NULL) {
+		const gchar *value = NULL;
+		icalcomponent *icalcomp = NULL;
+		gboolean collecting = reader->in_component && reader->buffer->len > 0;
+
+		reader->bytes_read += len + 1;
+
+		/* Notify also while skipping components, which can take long */
+		if (reader->progress_func && reader->bytes_read - reader->notified_bytes >= 64 * 1024) {
+			reader->notified_bytes = reader->bytes_read;
+			reader->progress_func (reader->bytes_read, reader->progress_data);
+		}
+
+		if (ical_stream_reader_line_is (line, "BEGIN:", &value)) {
+			g_strchomp (line);
+
+			if (reader->depth == 0 && g_ascii_strcasecmp (value, "VCALENDAR") == 0) {
+				reader->in_vcalendar = TRUE;
+				reader->depth = 1;
+				g_free (line);
+				continue;
+			}
+
+			if (!reader->in_component && reader->depth == (reader->in_vcalendar ? 1 : 0)) {
+				reader->in_component = TRUE;
+				reader->comp_depth = reader->depth;
+				collecting = ical_stream_reader_wants (reader, value);
+			}
+
+			reader->depth++;
+		} else if (ical_stream_reader_line_is (line, "END:", NULL)) {
+			if (reader->depth > 0)
+				reader->depth--;
+
+			if (reader->in_vcalendar && reader->depth == 0) {
+				reader->in_vcalendar = FALSE;
+				g_free (line);
+				continue;
+			}
+
+			if (reader->in_component && reader->depth == reader->comp_depth) {
+				reader->in_component = FALSE;
+
+				if (collecting) {
+					g_string_append (reader->buffer, line);
+					g_string_append (reader->buffer, "\r\n");
+
+					icalcomp = icalcomponent_new_from_string (reader->buffer->str);
+					g_string_truncate (reader->buffer, 0);
+				}
+
+				g_free (line);
+
+				if (icalcomp)
+					return icalcomp;
+
+				continue;
+			}
+		} else if (!reader->in_component && reader->in_vcalendar && reader->depth == 1 &&
+			   ical_stream_reader_line_is (line, "METHOD:", &value)) {
+			if (reader->method == ICAL_METHOD_NONE)
+				reader->method = icalproperty_string_to_method (value);
+		}
+
+		if (collecting) {
+			g_string_append (reader->buffer, line);
+			g_string_append (reader->buffer, "\r\n");
+		}
+
+		g_free (line);
+	}
+
+	return NULL;
+}
+
+/* How many components are sent to the backend with one receive_objects call */
+#define IMPORT_BATCH_SIZE 100
+
+static const gchar *timezone_names[] = { "VTIMEZONE", NULL };
+static const gchar *vevent_names[] = { "VEVENT", NULL };
+static const gchar *vtodo_names[] = { "VTODO", NULL };
+static const gchar *preview_names[] = { "VTIMEZONE", "VEVENT", "VTODO", NULL };
+
 struct UpdateObjectsData
 {
+	ECalClient *cal_client;
+	GCancellable *cancellable;
+	icalproperty_method method;
+
+	/* Either an in-memory VCALENDAR... */
+	icalcomponent *icalcomp;
+	icalcomponent *owned_icalcomp;
+	icalcompiter iter;
+
+	/* ...or a file, which is read incrementally */
+	gchar *filename;
+	const gchar * const *names;
+	ICalStreamReader *reader;
+
+	/* Timezones are sent first, each TZID only once */
+	gboolean timezones_done;
+	GHashTable *sent_tzids;
+
+	guint n_total;
+	guint n_done;
+	guint n_batch;
+
+	/* The file is imported in a thread, which only stores the progress
+	   here; the main thread reports it from a timeout */
+	gint file_percent; /* atomic */
+	gint reported_percent;
+	guint progress_timeout_id;
+
+	void (*progress_cb) (gpointer user_data, gint percent);
 	void (*done_cb) (gpointer user_data, const GError *error);
 	gpointer user_data;
 };
 
+static void
+update_objects_data_free (struct UpdateObjectsData *uod)
+{
+	if (!uod)
+		return;
+
+	if (uod->owned_icalcomp)
+		icalcomponent_free (uod->owned_icalcomp);
+
+	if (uod->progress_timeout_id)
+		g_source_remove (uod->progress_timeout_id);
+
+	ical_stream_reader_free (uod->reader);
+	g_clear_object (&uod->cal_client);
+	g_clear_object (&uod->cancellable);
+	g_hash_table_destroy (uod->sent_tzids);
+	g_free (uod->filename);
+	g_free (uod);
+}
+
+static void
+update_objects_finish (struct UpdateObjectsData *uod,
+		       const GError *error)
+{
+	if (uod->done_cb)
+		uod->done_cb (uod->user_data, error);
+
+	update_objects_data_free (uod);
+}
+
+/* Called in the import thread. The file is read twice, first for the timezones,
+   then for the components, thus each pass counts as one half of the progress. */
+static void
+update_objects_file_progress_cb (goffset bytes_read,
+				 gpointer user_data)
+{
+	struct UpdateObjectsData *uod = user_data;
+	goffset size;
+
+	size = uod->reader ? uod->reader->size : 0;
+	if (size <= 0)
+		return;
+
+	g_atomic_int_set (&uod->file_percent,
+		(gint) MIN (100, ((uod->timezones_done ? size : 0) + bytes_read) * 100 / (2 * size)));
+}
+
+static gboolean
+update_objects_rewind (struct UpdateObjectsData *uod,
+		       GError **error)
+{
+	if (uod->icalcomp) {
+		uod->iter = icalcomponent_begin_component (uod->icalcomp, ICAL_ANY_COMPONENT);
+		return TRUE;
+	}
+
+	ical_stream_reader_free (uod->reader);
+	uod->reader = ical_stream_reader_new (uod->filename,
+		uod->timezones_done ? uod->names : timezone_names,
+		uod->cancellable, error);
+
+	if (uod->reader) {
+		uod->reader->progress_func = update_objects_file_progress_cb;
+		uod->reader->progress_data = uod;
+	}
+
+	return uod->reader != NULL;
+}
+
+/* Returns a new icalcomponent, which belongs to the current phase, either
+ * a VTIMEZONE not sent yet or a non-VTIMEZONE component. */
+static icalcomponent *
+update_objects_next_component (struct UpdateObjectsData *uod,
+			       GError **error)
+{
+	icalcomponent *subcomp;
+
+	while (TRUE) {
+		if (uod->icalcomp) {
+			subcomp = icalcompiter_deref (&uod->iter);
+			if (!subcomp)
+				return NULL;
+
+			icalcompiter_next (&uod->iter);
+
+			if ((icalcomponent_isa (subcomp) == ICAL_VTIMEZONE_COMPONENT) == uod->timezones_done)
+				continue;
+
+			subcomp = icalcomponent_new_clone (subcomp);
+		} else {
+			subcomp = ical_stream_reader_next (uod->reader, uod->cancellable, error);
+			if (!subcomp)
+				return NULL;
+
+			if (uod->method == ICAL_METHOD_NONE && uod->reader->method != ICAL_METHOD_NONE)
+				uod->method = uod->reader->method;
+		}
+
+		if (!uod->timezones_done) {
+			icalproperty *prop;
+			const gchar *tzid = NULL;
+
+			prop = icalcomponent_get_first_property (subcomp, ICAL_TZID_PROPERTY);
+			if (prop)
+				tzid = icalproperty_get_tzid (prop);
+
+			if (!tzid || g_hash_table_contains (uod->sent_tzids, tzid)) {
+				icalcomponent_free (subcomp);
+				continue;
+			}
+
+			g_hash_table_add (uod->sent_tzids, g_strdup (tzid));
+		}
+
+		return subcomp;
+	}
+}
+
+static icalcomponent *
+update_objects_next_batch (struct UpdateObjectsData *uod,
+			   GError **error)
+{
+	while (TRUE) {
+		icalcomponent *vcal, *subcomp;
+		GError *local_error = NULL;
+
+		uod->n_batch = 0;
+
+		vcal = e_cal_util_new_top_level ();
+
+		while (uod->n_batch < IMPORT_BATCH_SIZE &&
+		       (subcomp = update_objects_next_component (uod, &local_error)) != NULL) {
+			icalcomponent_add_component (vcal, subcomp);
+			uod->n_batch++;
+		}
+
+		if (local_error) {
+			g_propagate_error (error, local_error);
+			icalcomponent_free (vcal);
+			return NULL;
+		}
+
+		if (uod->n_batch > 0) {
+			icalcomponent_set_method (vcal, uod->method == ICAL_METHOD_NONE ? ICAL_METHOD_PUBLISH : uod->method);
+			return vcal;
+		}
+
+		icalcomponent_free (vcal);
+
+		if (uod->timezones_done)
+			break;
+
+		uod->timezones_done = TRUE;
+
+		if (!update_objects_rewind (uod, error))
+			break;
+	}
+
+	return NULL;
+}
+
+static void
+update_objects_send_next (struct UpdateObjectsData *uod);
+
 static void
 receive_objects_ready_cb (GObject *source_object,
                           GAsyncResult *result,
@@ -185,51 +588,250 @@ receive_objects_ready_cb (GObject *source_object,
 
 	e_cal_client_receive_objects_finish (cal_client, result, &error);
 
-	if (uod->done_cb)
-		uod->done_cb (uod->user_data, error);
-	g_clear_error (&error);
+	if (error) {
+		update_objects_finish (uod, error);
+		g_clear_error (&error);
+		return;
+	}
 
-	g_free (uod);
+	if (uod->timezones_done) {
+		uod->n_done += uod->n_batch;
+
+		if (uod->progress_cb) {
+			gint percent;
+
+			if (uod->n_total > 0)
+				percent = MIN (100, uod->n_done * 100 / uod->n_total);
+			else
+				percent = 100;
+
+			uod->progress_cb (uod->user_data, percent);
+		}
+	}
+
+	update_objects_send_next (uod);
+}
+
+static void
+update_objects_send_next (struct UpdateObjectsData *uod)
+{
+	icalcomponent *vcal;
+	GError *error = NULL;
+
+	if (g_cancellable_set_error_if_cancelled (uod->cancellable, &error)) {
+		update_objects_finish (uod, error);
+		g_clear_error (&error);
+		return;
+	}
+
+	vcal = update_objects_next_batch (uod, &error);
+	if (!vcal) {
+		update_objects_finish (uod, error);
+		g_clear_error (&error);
+		return;
+	}
+
+	e_cal_client_receive_objects (uod->cal_client, vcal, uod->cancellable, receive_objects_ready_cb, uod);
+
+	icalcomponent_free (vcal);
 }
 
+static struct UpdateObjectsData *
+update_objects_data_new (ECalClient *cal_client,
+			 GCancellable *cancellable,
+			 void (*progress_cb) (gpointer user_data, gint percent),
+			 void (*done_cb) (gpointer user_data, const GError *error),
+			 gpointer user_data)
+{
+	struct UpdateObjectsData *uod;
+
+	uod = g_new0 (struct UpdateObjectsData, 1);
+	uod->cal_client = g_object_ref (cal_client);
+	uod->cancellable = cancellable ? g_object_ref (cancellable) : g_cancellable_new ();
+	uod->method = ICAL_METHOD_NONE;
+	uod->sent_tzids = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+	uod->progress_cb = progress_cb;
+	uod->done_cb = done_cb;
+	uod->user_data = user_data;
+
+	return uod;
+}
+
+/* Sends the content of the 'icalcomp' to the 'cal_client' in batches
+ * of IMPORT_BATCH_SIZE components, all the timezones first. The 'icalcomp'
+ * should not be modified until the 'done_cb' is called. */
 static void
 update_objects (ECalClient *cal_client,
                 icalcomponent *icalcomp,
                 GCancellable *cancellable,
+                void (*progress_cb) (gpointer user_data, gint percent),
                 void (*done_cb) (gpointer user_data, const GError *error),
                 gpointer user_data)
 {
 	icalcomponent_kind kind;
-	icalcomponent *vcal;
 	struct UpdateObjectsData *uod;
+	GError *error = NULL;
 
 	kind = icalcomponent_isa (icalcomp);
-	if (kind == ICAL_VTODO_COMPONENT || kind == ICAL_VEVENT_COMPONENT) {
+	if (kind != ICAL_VTODO_COMPONENT && kind != ICAL_VEVENT_COMPONENT && kind != ICAL_VCALENDAR_COMPONENT) {
+		if (done_cb)
+			done_cb (user_data, NULL);
+		return;
+	}
+
+	uod = update_objects_data_new (cal_client, cancellable, progress_cb, done_cb, user_data);
+
+	if (kind == ICAL_VCALENDAR_COMPONENT) {
+		icalcomponent *subcomp;
+
+		uod->icalcomp = icalcomp;
+
+		if (icalcomponent_get_first_property (icalcomp, ICAL_METHOD_PROPERTY))
+			uod->method = icalcomponent_get_method (icalcomp);
+
+		for (subcomp = icalcomponent_get_first_component (icalcomp, ICAL_ANY_COMPONENT);
+		     subcomp;
+		     subcomp = icalcomponent_get_next_component (icalcomp, ICAL_ANY_COMPONENT)) {
+			if (icalcomponent_isa (subcomp) != ICAL_VTIMEZONE_COMPONENT)
+				uod->n_total++;
+		}
+	} else {
+		/* A lone component, wrap it into a VCALENDAR */
+		icalcomponent *vcal;
+
 		vcal = e_cal_util_new_top_level ();
 		if (icalcomponent_get_method (icalcomp) == ICAL_METHOD_CANCEL)
-			icalcomponent_set_method (vcal, ICAL_METHOD_CANCEL);
-		else
-			icalcomponent_set_method (vcal, ICAL_METHOD_PUBLISH);
+			uod->method = ICAL_METHOD_CANCEL;
 		icalcomponent_add_component (vcal, icalcomponent_new_clone (icalcomp));
-	} else if (kind == ICAL_VCALENDAR_COMPONENT) {
-		vcal = icalcomponent_new_clone (icalcomp);
-		if (!icalcomponent_get_first_property (vcal, ICAL_METHOD_PROPERTY))
-			icalcomponent_set_method (vcal, ICAL_METHOD_PUBLISH);
-	} else {
-		if (done_cb)
-			done_cb (user_data, NULL);
+
+		uod->icalcomp = vcal;
+		uod->owned_icalcomp = vcal;
+		uod->n_total = 1;
+	}
+
+	if (!update_objects_rewind (uod, &error)) {
+		update_objects_finish (uod, error);
+		g_clear_error (&error);
 		return;
 	}
 
-	uod = g_new0 (struct UpdateObjectsData, 1);
-	uod->done_cb = done_cb;
-	uod->user_data = user_data;
+	update_objects_send_next (uod);
+}
 
-	e_cal_client_receive_objects (cal_client, vcal, cancellable, receive_objects_ready_cb, uod);
+static gboolean
+update_objects_progress_timeout_cb (gpointer user_data)
+{
+	struct UpdateObjectsData *uod = user_data;
+	gint percent;
 
-	icalcomponent_free (vcal);
+	percent = g_atomic_int_get (&uod->file_percent);
+
+	if (percent != uod->reported_percent) {
+		uod->reported_percent = percent;
+
+		if (uod->progress_cb)
+			uod->progress_cb (uod->user_data, percent);
+	}
 
-	return;
+	return G_SOURCE_CONTINUE;
+}
+
+static void
+update_objects_from_file_thread (GTask *task,
+				 gpointer source_object,
+				 gpointer task_data,
+				 GCancellable *cancellable)
+{
+	struct UpdateObjectsData *uod = task_data;
+	GError *error = NULL;
+
+	if (update_objects_rewind (uod, &error)) {
+		icalcomponent *vcal;
+
+		while (!g_cancellable_set_error_if_cancelled (cancellable, &error) &&
+		       (vcal = update_objects_next_batch (uod, &error)) != NULL) {
+			gboolean success;
+
+			success = e_cal_client_receive_objects_sync (uod->cal_client, vcal, cancellable, &error);
+
+			icalcomponent_free (vcal);
+
+			if (!success)
+				break;
+
+			if (uod->timezones_done)
+				uod->n_done += uod->n_batch;
+
+			update_objects_file_progress_cb (uod->reader->bytes_read, uod);
+		}
+	}
+
+	if (error)
+		g_task_return_error (task, error);
+	else
+		g_task_return_boolean (task, TRUE);
+}
+
+static void
+update_objects_from_file_done_cb (GObject *source_object,
+				  GAsyncResult *result,
+				  gpointer user_data)
+{
+	struct UpdateObjectsData *uod = user_data;
+	GError *error = NULL;
+
+	g_task_propagate_boolean (G_TASK (result), &error);
+
+	if (uod->progress_timeout_id) {
+		g_source_remove (uod->progress_timeout_id);
+		uod->progress_timeout_id = 0;
+	}
+
+	update_objects_progress_timeout_cb (uod);
+	update_objects_finish (uod, error);
+
+	g_clear_error (&error);
+}
+
+/* Reads the 'filename' incrementally in a dedicated thread and sends its components
+ * of the 'source_type' to the 'cal_client' in batches of IMPORT_BATCH_SIZE components,
+ * all the timezones first. The progress is reported as the portion of the file already
+ * processed, from the main thread. */
+static void
+update_objects_from_file (ECalClient *cal_client,
+			  const gchar *filename,
+			  ECalClientSourceType source_type,
+			  GCancellable *cancellable,
+			  void (*progress_cb) (gpointer user_data, gint percent),
+			  void (*done_cb) (gpointer user_data, const GError *error),
+			  gpointer user_data)
+{
+	struct UpdateObjectsData *uod;
+	GTask *task;
+
+	uod = update_objects_data_new (cal_client, cancellable, progress_cb, done_cb, user_data);
+	uod->filename = g_strdup (filename);
+
+	switch (source_type) {
+	case E_CAL_CLIENT_SOURCE_TYPE_EVENTS:
+		uod->names = vevent_names;
+		break;
+	case E_CAL_CLIENT_SOURCE_TYPE_TASKS:
+		uod->names = vtodo_names;
+		break;
+	default:
+		g_warn_if_reached ();
+		update_objects_finish (uod, NULL);
+		return;
+	}
+
+	uod->progress_timeout_id = e_named_timeout_add (250, update_objects_progress_timeout_cb, uod);
+
+	task = g_task_new (NULL, uod->cancellable, update_objects_from_file_done_cb, uod);
+	g_task_set_source_tag (task, update_objects_from_file);
+	g_task_set_task_data (task, uod, NULL);
+	g_task_run_in_thread (task, update_objects_from_file_thread);
+	g_object_unref (task);
 }
 
 struct _selector_data {
@@ -423,6 +1025,15 @@ ivcal_call_import_done (gpointer user_data,
 	ivcal_import_done (user_data, error);
 }
 
+static void
+ivcal_call_import_progress (gpointer user_data,
+			    gint percent)
+{
+	ICalImporter *ici = user_data;
+
+	e_import_status (ici->import, ici->target, _("Importing..."), percent);
+}
+
 static gboolean
 ivcal_import_items (gpointer d)
 {
@@ -430,14 +1041,22 @@ ivcal_import_items (gpointer d)
 
 	ici->idle_id = 0;
 
+	if (ici->filename) {
+		update_objects_from_file (ici->cal_client, ici->filename, ici->source_type, ici->cancellable,
+			ivcal_call_import_progress, ivcal_call_import_done, ici);
+		return FALSE;
+	}
+
 	switch (ici->source_type) {
 	case E_CAL_CLIENT_SOURCE_TYPE_EVENTS:
 		prepare_events (ici->icalcomp, NULL);
-		update_objects (ici->cal_client, ici->icalcomp, ici->cancellable, ivcal_call_import_done, ici);
+		update_objects (ici->cal_client, ici->icalcomp, ici->cancellable,
+			ivcal_call_import_progress, ivcal_call_import_done, ici);
 		break;
 	case E_CAL_CLIENT_SOURCE_TYPE_TASKS:
 		prepare_tasks (ici->icalcomp, NULL);
-		update_objects (ici->cal_client, ici->icalcomp, ici->cancellable, ivcal_call_import_done, ici);
+		update_objects (ici->cal_client, ici->icalcomp, ici->cancellable,
+			ivcal_call_import_progress, ivcal_call_import_done, ici);
 		break;
 	default:
 		g_warn_if_reached ();
@@ -479,10 +1098,12 @@ ivcal_connect_cb (GObject *source_object,
 	ici->idle_id = g_idle_add (ivcal_import_items, ici);
 }
 
+/* Takes ownership of the 'icalcomp' and the 'filename'; only one of them is set */
 static void
 ivcal_import (EImport *ei,
               EImportTarget *target,
-              icalcomponent *icalcomp)
+              icalcomponent *icalcomp,
+              gchar *filename)
 {
 	ECalClientSourceType type;
 	ICalImporter *ici = g_malloc0 (sizeof (*ici));
@@ -494,6 +1115,7 @@ ivcal_import (EImport *ei,
 	g_object_ref (ei);
 	ici->target = target;
 	ici->icalcomp = icalcomp;
+	ici->filename = filename;
 	ici->cal_client = NULL;
 	ici->source_type = type;
 	ici->cancellable = g_cancellable_new ();
@@ -520,6 +1142,40 @@ ivcal_cancel (EImport *ei,
  * iCalendar importer functions.
  */
 
+/* Reads at most ICAL_SNIFF_SIZE bytes from the beginning of the 'filename';
+   the 'out_truncated' is set to TRUE when the file is longer than that. */
+static gchar *
+ical_sniff_file (const gchar *filename,
+		 gboolean *out_truncated)
+{
+	GFile *file;
+	GFileInputStream *stream;
+	gchar *contents = NULL;
+	gsize bytes_read = 0;
+
+	*out_truncated = FALSE;
+
+	file = g_file_new_for_path (filename);
+	stream = g_file_read (file, NULL, NULL);
+
+	if (stream) {
+		contents = g_malloc (ICAL_SNIFF_SIZE + 2);
+
+		if (g_input_stream_read_all (G_INPUT_STREAM (stream), contents, ICAL_SNIFF_SIZE + 1, &bytes_read, NULL, NULL)) {
+			*out_truncated = bytes_read > ICAL_SNIFF_SIZE;
+			contents[MIN (bytes_read, ICAL_SNIFF_SIZE)] = '\0';
+		} else {
+			g_clear_pointer (&contents, g_free);
+		}
+
+		g_object_unref (stream);
+	}
+
+	g_object_unref (file);
+
+	return contents;
+}
+
 static gboolean
 ical_supported (EImport *ei,
                 EImportTarget *target,
@@ -527,6 +1183,7 @@ ical_supported (EImport *ei,
 {
 	gchar *filename;
 	gchar *contents;
+	gboolean truncated = FALSE;
 	gboolean ret = FALSE;
 	EImportTargetURI *s;
 
@@ -544,16 +1201,22 @@ ical_supported (EImport *ei,
 	if (!filename)
 		return FALSE;
 
-	if (g_file_get_contents (filename, &contents, NULL, NULL)) {
-		icalcomponent *icalcomp;
+	/* Only the beginning of the file is checked, the file can be huge */
+	contents = ical_sniff_file (filename, &truncated);
+	if (contents) {
+		gchar *lowered;
 
-		icalcomp = e_cal_util_parse_ics_string (contents);
-		g_free (contents);
+		lowered = g_ascii_strdown (contents, -1);
 
-		if (icalcomp) {
-			ret = is_icalcomp_usable (icalcomp);
-			icalcomponent_free (icalcomp);
-		}
+		/* When the file continues after the sniffed part, then
+		   the events or tasks can be defined later in it */
+		ret = strstr (lowered, "begin:vcalendar") != NULL && (
+			strstr (lowered, "begin:vevent") != NULL ||
+			strstr (lowered, "begin:vtodo") != NULL ||
+			truncated);
+
+		g_free (lowered);
+		g_free (contents);
 	}
 	g_free (filename);
 
@@ -566,8 +1229,6 @@ ical_import (EImport *ei,
              EImportImporter *im)
 {
 	gchar *filename;
-	gchar *contents;
-	icalcomponent *icalcomp;
 	GError *error = NULL;
 	EImportTargetURI *s = (EImportTargetURI *) target;
 
@@ -578,21 +1239,18 @@ ical_import (EImport *ei,
 		return;
 	}
 
-	if (!g_file_get_contents (filename, &contents, NULL, &error)) {
+	if (!g_file_test (filename, G_FILE_TEST_IS_REGULAR)) {
+		g_set_error (&error, G_IO_ERROR, G_IO_ERROR_NOT_FOUND,
+			_("File “%s” not found"), filename);
 		g_free (filename);
 		e_import_complete (ei, target, error);
 		g_clear_error (&error);
 		return;
 	}
-	g_free (filename);
 
-	icalcomp = e_cal_util_parse_ics_string (contents);
-	g_free (contents);
-
-	if (icalcomp)
-		ivcal_import (ei, target, icalcomp);
-	else
-		e_import_complete (ei, target, error);
+	/* The file is parsed incrementally while importing, thus
+	   the whole content is never held in memory at once */
+	ivcal_import (ei, target, NULL, filename);
 }
 
 static GtkWidget *
@@ -602,9 +1260,10 @@ ivcal_get_preview (EImport *ei,
 {
 	GtkWidget *preview;
 	EImportTargetURI *s = (EImportTargetURI *) target;
+	ICalStreamReader *reader;
 	gchar *filename;
-	icalcomponent *icalcomp;
-	gchar *contents;
+	icalcomponent *icalcomp, *subcomp;
+	gint n_components = 0;
 
 	filename = g_filename_from_uri (s->uri_src, NULL, NULL);
 	if (filename == NULL) {
@@ -612,18 +1271,25 @@ ivcal_get_preview (EImport *ei,
 		return NULL;
 	}
 
-	if (!g_file_get_contents (filename, &contents, NULL, NULL)) {
-		g_free (filename);
-		return NULL;
-	}
+	/* Read only as much of the file as is shown in the preview */
+	reader = ical_stream_reader_new (filename, preview_names, NULL, NULL);
 	g_free (filename);
 
-	icalcomp = e_cal_util_parse_ics_string (contents);
-	g_free (contents);
-
-	if (!icalcomp)
+	if (!reader)
 		return NULL;
 
+	icalcomp = e_cal_util_new_top_level ();
+
+	while (n_components < ICAL_PREVIEW_MAX_COMPONENTS &&
+	       (subcomp = ical_stream_reader_next (reader, NULL, NULL)) != NULL) {
+		if (icalcomponent_isa (subcomp) != ICAL_VTIMEZONE_COMPONENT)
+			n_components++;
+
+		icalcomponent_add_component (icalcomp, subcomp);
+	}
+
+	ical_stream_reader_free (reader);
+
 	preview = ical_get_preview (icalcomp);
 
 	icalcomponent_free (icalcomp);
@@ -775,7 +1441,7 @@ vcal_import (EImport *ei,
 	icalcomp = load_vcalendar_file (filename);
 	g_free (filename);
 	if (icalcomp)
-		ivcal_import (ei, target, icalcomp);
+		ivcal_import (ei, target, icalcomp, NULL);
 	else
 		e_import_complete (ei, target, error);
 }
@@ -956,6 +1622,17 @@ continue_done_cb (gpointer user_data,
 	e_import_complete (ici->ei, ici->target, error);
 }
 
+static void
+continue_progress_cb (gpointer user_data,
+		      gint percent)
+{
+	ICalIntelligentImporter *ici = user_data;
+
+	g_return_if_fail (ici != NULL);
+
+	e_import_status (ici->ei, ici->target, _("Importing..."), percent);
+}
+
 static void
 gc_import_tasks (ECalClient *cal_client,
                  const GError *error,
@@ -973,8 +1650,8 @@ gc_import_tasks (ECalClient *cal_client,
 	prepare_tasks (ici->icalcomp, ici->tasks);
 
 	update_objects (
-		cal_client, ici->icalcomp,
-		ici->cancellable, continue_done_cb, ici);
+		cal_client, ici->icalcomp, ici->cancellable,
+		continue_progress_cb, continue_done_cb, ici);
 }
 
 static void
@@ -1011,7 +1688,7 @@ gc_import_events (ECalClient *cal_client,
 	e_import_status (ici->ei, ici->target, _("Importing..."), 0);
 
 	update_objects (
-		cal_client, ici->icalcomp, ici->cancellable,
+		cal_client, ici->icalcomp, ici->cancellable, continue_progress_cb,
 		ici->tasks ? continue_tasks_cb : continue_done_cb, ici);
 }
 
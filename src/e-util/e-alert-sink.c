@@ -33,6 +33,7 @@
 #include "e-activity.h"
 
 #include "e-alert-dialog.h"
+#include "e-trace.h"
 
 G_DEFINE_INTERFACE (
 	EAlertSink,
@@ -102,6 +103,8 @@ struct _EAlertSinkThreadJobData {
 	EAlertSinkThreadJobFunc func;
 	gpointer user_data;
 	GDestroyNotify free_user_data;
+
+	ETraceOp *trace_op;
 };
 
 static gboolean
@@ -138,6 +141,7 @@ e_alert_sink_thread_job_done_cb (gpointer user_data)
 	}
 
 	/* clean-up */
+	e_trace_op_finish (job_data->trace_op);
 	g_clear_object (&job_data->activity);
 	g_clear_error (&job_data->error);
 	g_free (job_data->alert_ident);
@@ -163,8 +167,13 @@ e_alert_sink_thread_job (gpointer user_data)
 
 	cancellable = e_activity_get_cancellable (job_data->activity);
 
+	e_trace_op_start (job_data->trace_op);
+
 	job_data->func (job_data, job_data->user_data, cancellable, &job_data->error);
 
+	e_trace_op_finish (job_data->trace_op);
+	job_data->trace_op = NULL;
+
 	g_timeout_add (1, e_alert_sink_thread_job_done_cb, job_data);
 
 	return NULL;
@@ -233,6 +242,7 @@ e_alert_sink_submit_thread_job (EAlertSink *alert_sink,
 	job_data->func = func;
 	job_data->user_data = user_data;
 	job_data->free_user_data = free_user_data;
+	job_data->trace_op = e_trace_op_new ("alert-sink-job", description);
 
 	thread = g_thread_try_new (G_STRFUNC, e_alert_sink_thread_job, job_data, &job_data->error);
 
@@ -44,6 +44,11 @@ struct _EContactStorePrivate {
 	gint stamp;
 	EBookQuery *query;
 	GArray *contact_sources;
+
+	/* Set by e_contact_store_narrow_query() */
+	EContactStoreFilterFunc filter_func;
+	gpointer filter_data;
+	GDestroyNotify filter_data_free;
 };
 
 /* Signals */
@@ -103,12 +108,21 @@ typedef struct
 
 	EBookClientView *client_view_pending;
 	GPtrArray *contacts_pending;
+
+	/* All contacts of the current view while a filter is set;
+	 * the 'contacts' then hold only those passing the filter. */
+	GPtrArray *view_contacts;
+
+	guint n_view_requests;
+	gboolean view_complete;
+	gboolean view_failed;
 }
 ContactSource;
 
 static void free_contact_ptrarray (GPtrArray *contacts);
 static void clear_contact_source  (EContactStore *contact_store, ContactSource *source);
 static void stop_view             (EContactStore *contact_store, EBookClientView *view);
+static void clear_filter          (EContactStore *contact_store);
 
 static void
 contact_store_dispose (GObject *object)
@@ -132,6 +146,8 @@ contact_store_dispose (GObject *object)
 	}
 	g_array_set_size (priv->contact_sources, 0);
 
+	clear_filter (E_CONTACT_STORE (object));
+
 	if (priv->query != NULL) {
 		e_book_query_unref (priv->query);
 		priv->query = NULL;
@@ -559,6 +575,33 @@ get_contact_at_row (EContactStore *contact_store,
 	return g_ptr_array_index (source->contacts, row);
 }
 
+static gint
+find_contact_in_ptrarray (GPtrArray *contacts,
+                          const gchar *find_uid)
+{
+	gint i;
+
+	for (i = 0; i < contacts->len; i++) {
+		EContact    *contact = g_ptr_array_index (contacts, i);
+		const gchar *uid = e_contact_get_const (contact, E_CONTACT_UID);
+
+		if (uid && !strcmp (find_uid, uid))
+			return i;
+	}
+
+	return -1;
+}
+
+static gboolean
+filter_accepts_contact (EContactStore *contact_store,
+                        EContact *contact)
+{
+	if (!contact_store->priv->filter_func)
+		return TRUE;
+
+	return contact_store->priv->filter_func (contact, contact_store->priv->filter_data);
+}
+
 static gboolean
 find_contact_source_details_by_view (EContactStore *contact_store,
                                      EBookClientView *client_view,
@@ -600,15 +643,20 @@ view_contacts_added (EContactStore *contact_store,
 	for (l = contacts; l; l = g_slist_next (l)) {
 		EContact *contact = l->data;
 
-		g_object_ref (contact);
-
 		if (client_view == source->client_view) {
 			/* Current view */
-			g_ptr_array_add (source->contacts, contact);
+			if (source->view_contacts) {
+				g_ptr_array_add (source->view_contacts, g_object_ref (contact));
+
+				if (!filter_accepts_contact (contact_store, contact))
+					continue;
+			}
+
+			g_ptr_array_add (source->contacts, g_object_ref (contact));
 			row_inserted (contact_store, offset + source->contacts->len - 1);
 		} else {
 			/* Pending view */
-			g_ptr_array_add (source->contacts_pending, contact);
+			g_ptr_array_add (source->contacts_pending, g_object_ref (contact));
 		}
 	}
 }
@@ -632,6 +680,22 @@ view_contacts_removed (EContactStore *contact_store,
 		gint         n = find_contact_by_view_and_uid (contact_store, client_view, uid);
 		EContact    *contact;
 
+		if (client_view == source->client_view && source->view_contacts) {
+			gint v = find_contact_in_ptrarray (source->view_contacts, uid);
+
+			if (v < 0) {
+				g_warning ("EContactStore got 'contacts_removed' on unknown contact!");
+				continue;
+			}
+
+			g_object_unref (g_ptr_array_index (source->view_contacts, v));
+			g_ptr_array_remove_index (source->view_contacts, v);
+
+			/* Filtered out */
+			if (n < 0)
+				continue;
+		}
+
 		if (n < 0) {
 			g_warning ("EContactStore got 'contacts_removed' on unknown contact!");
 			continue;
@@ -678,6 +742,38 @@ view_contacts_modified (EContactStore *contact_store,
 		const gchar *uid = e_contact_get_const (contact, E_CONTACT_UID);
 		gint         n = find_contact_by_view_and_uid (contact_store, client_view, uid);
 
+		if (client_view == source->client_view && source->view_contacts) {
+			gint v = find_contact_in_ptrarray (source->view_contacts, uid);
+
+			if (v < 0) {
+				g_warning ("EContactStore got change notification on unknown contact!");
+				continue;
+			}
+
+			cached_contact = g_ptr_array_index (source->view_contacts, v);
+			if (cached_contact != contact) {
+				g_object_unref (cached_contact);
+				source->view_contacts->pdata[v] = g_object_ref (contact);
+			}
+
+			if (!filter_accepts_contact (contact_store, contact)) {
+				/* No longer passes the filter */
+				if (n >= 0) {
+					g_object_unref (g_ptr_array_index (cached_contacts, n));
+					g_ptr_array_remove_index (cached_contacts, n);
+					row_deleted (contact_store, offset + n);
+				}
+				continue;
+			}
+
+			if (n < 0) {
+				/* Newly passes the filter */
+				g_ptr_array_add (cached_contacts, g_object_ref (contact));
+				row_inserted (contact_store, offset + cached_contacts->len - 1);
+				continue;
+			}
+		}
+
 		if (n < 0) {
 			g_warning ("EContactStore got change notification on unknown contact!");
 			continue;
@@ -714,6 +810,8 @@ view_complete (EContactStore *contact_store,
 
 	/* If current view finished, do nothing */
 	if (client_view == source->client_view) {
+		source->view_complete = TRUE;
+		source->view_failed = error != NULL;
 		stop_view (contact_store, source->client_view);
 		return;
 	}
@@ -765,6 +863,8 @@ view_complete (EContactStore *contact_store,
 	g_object_unref (source->client_view);
 	source->client_view = source->client_view_pending;
 	source->client_view_pending = NULL;
+	source->view_complete = TRUE;
+	source->view_failed = error != NULL;
 
 	/* Free array of pending contacts (members have been either moved or unreffed) */
 	g_ptr_array_free (source->contacts_pending, TRUE);
@@ -885,6 +985,11 @@ clear_contact_source (EContactStore *contact_store,
 
 	/* Free main and pending views, clear cached contacts */
 
+	if (source->view_contacts) {
+		free_contact_ptrarray (source->view_contacts);
+		source->view_contacts = NULL;
+	}
+
 	if (source->client_view) {
 		stop_view (contact_store, source->client_view);
 		g_object_unref (source->client_view);
@@ -892,6 +997,9 @@ clear_contact_source (EContactStore *contact_store,
 		source->client_view = NULL;
 	}
 
+	source->view_complete = FALSE;
+	source->view_failed = FALSE;
+
 	if (source->client_view_pending) {
 		stop_view (contact_store, source->client_view_pending);
 		g_object_unref (source->client_view_pending);
@@ -927,6 +1035,9 @@ client_view_ready_cb (GObject *source_object,
 
 		source = &g_array_index (contact_store->priv->contact_sources, ContactSource, source_idx);
 
+		if (source->n_view_requests > 0)
+			source->n_view_requests--;
+
 		if (source->client_view) {
 			if (source->client_view_pending) {
 				stop_view (contact_store, source->client_view_pending);
@@ -944,6 +1055,8 @@ client_view_ready_cb (GObject *source_object,
 			}
 		} else {
 			source->client_view = client_view;
+			source->view_complete = FALSE;
+			source->view_failed = FALSE;
 
 			if (source->client_view) {
 				start_view (contact_store, client_view);
@@ -977,6 +1090,8 @@ query_contact_source (EContactStore *contact_store,
 		}
 	}
 
+	source->n_view_requests++;
+
 	query_str = e_book_query_to_string (contact_store->priv->query);
 	e_book_client_get_view (source->book_client, query_str, NULL, client_view_ready_cb, g_object_ref (contact_store));
 	g_free (query_str);
@@ -1198,12 +1313,21 @@ e_contact_store_set_query (EContactStore *contact_store,
 	if (book_query)
 		e_book_query_ref (book_query);
 
+	/* The shown contacts stay until the new views replace them */
+	clear_filter (contact_store);
+
 	/* Query books */
 	array = contact_store->priv->contact_sources;
 	for (i = 0; i < array->len; i++) {
 		ContactSource *contact_source;
 
 		contact_source = &g_array_index (array, ContactSource, i);
+
+		if (contact_source->view_contacts) {
+			free_contact_ptrarray (contact_source->view_contacts);
+			contact_source->view_contacts = NULL;
+		}
+
 		query_contact_source (contact_store, contact_source);
 	}
 }
@@ -1225,6 +1349,147 @@ e_contact_store_peek_query (EContactStore *contact_store)
 	return contact_store->priv->query;
 }
 
+static void
+clear_filter (EContactStore *contact_store)
+{
+	if (contact_store->priv->filter_data_free)
+		contact_store->priv->filter_data_free (contact_store->priv->filter_data);
+
+	contact_store->priv->filter_func = NULL;
+	contact_store->priv->filter_data = NULL;
+	contact_store->priv->filter_data_free = NULL;
+}
+
+static void
+refilter_contact_source (EContactStore *contact_store,
+                         gint source_index)
+{
+	ContactSource *source;
+	GHashTable    *hash;
+	gint           offset;
+	gint           i;
+
+	source = &g_array_index (contact_store->priv->contact_sources, ContactSource, source_index);
+	offset = get_contact_source_offset (contact_store, source_index);
+
+	g_signal_emit (contact_store, signals[START_UPDATE], 0, source->client_view);
+
+	/* Deletions */
+	for (i = 0; i < source->contacts->len; i++) {
+		EContact *contact = g_ptr_array_index (source->contacts, i);
+
+		if (!filter_accepts_contact (contact_store, contact)) {
+			g_object_unref (contact);
+			g_ptr_array_remove_index (source->contacts, i);
+			row_deleted (contact_store, offset + i);
+			i--;  /* Stay in place */
+		}
+	}
+
+	/* Insertions, when the filter is less strict than the previous one */
+	hash = get_contact_hash (contact_store, source->client_view);
+	for (i = 0; i < source->view_contacts->len; i++) {
+		EContact    *contact = g_ptr_array_index (source->view_contacts, i);
+		const gchar *uid = e_contact_get_const (contact, E_CONTACT_UID);
+
+		if (uid && !g_hash_table_contains (hash, uid) &&
+		    filter_accepts_contact (contact_store, contact)) {
+			g_ptr_array_add (source->contacts, g_object_ref (contact));
+			row_inserted (contact_store, offset + source->contacts->len - 1);
+		}
+	}
+	g_hash_table_unref (hash);
+
+	g_signal_emit (contact_store, signals[STOP_UPDATE], 0, source->client_view);
+}
+
+/**
+ * e_contact_store_narrow_query:
+ * @contact_store: an #EContactStore
+ * @book_query: an #EBookQuery
+ * @filter_func: an #EContactStoreFilterFunc
+ * @user_data: user data passed to @filter_func
+ * @destroy_data: (nullable): a #GDestroyNotify for @user_data
+ *
+ * Sets @book_query like e_contact_store_set_query(), except that when all
+ * the books finished their current views, the books are not asked again.
+ * Instead, the contacts received with the last query set by
+ * e_contact_store_set_query() are filtered with @filter_func. The @filter_func
+ * should accept exactly the contacts matching @book_query, which should be
+ * narrower than that last query, because only its contacts are considered.
+ *
+ * When any of the books did not finish its view yet, or it failed, like when
+ * it hit a search size limit, the @book_query is passed to the books as with
+ * e_contact_store_set_query() and @user_data is freed immediately.
+ *
+ * Returns: %TRUE, when the contacts had been filtered locally, %FALSE when
+ *    the books had been queried
+ *
+ * Since: 3.30
+ **/
+gboolean
+e_contact_store_narrow_query (EContactStore *contact_store,
+                              EBookQuery *book_query,
+                              EContactStoreFilterFunc filter_func,
+                              gpointer user_data,
+                              GDestroyNotify destroy_data)
+{
+	GArray *array;
+	gint i;
+
+	g_return_val_if_fail (E_IS_CONTACT_STORE (contact_store), FALSE);
+	g_return_val_if_fail (book_query != NULL, FALSE);
+	g_return_val_if_fail (filter_func != NULL, FALSE);
+
+	array = contact_store->priv->contact_sources;
+
+	for (i = 0; i < array->len; i++) {
+		ContactSource *source = &g_array_index (array, ContactSource, i);
+
+		if (!source->client_view || source->client_view_pending ||
+		    source->n_view_requests > 0 ||
+		    !source->view_complete || source->view_failed) {
+			if (destroy_data)
+				destroy_data (user_data);
+
+			e_contact_store_set_query (contact_store, book_query);
+
+			return FALSE;
+		}
+	}
+
+	if (book_query != contact_store->priv->query) {
+		if (contact_store->priv->query)
+			e_book_query_unref (contact_store->priv->query);
+
+		contact_store->priv->query = e_book_query_ref (book_query);
+	}
+
+	clear_filter (contact_store);
+
+	contact_store->priv->filter_func = filter_func;
+	contact_store->priv->filter_data = user_data;
+	contact_store->priv->filter_data_free = destroy_data;
+
+	for (i = 0; i < array->len; i++) {
+		ContactSource *source = &g_array_index (array, ContactSource, i);
+
+		/* The first filter; all the view's contacts are shown */
+		if (!source->view_contacts) {
+			gint j;
+
+			source->view_contacts = g_ptr_array_sized_new (source->contacts->len);
+
+			for (j = 0; j < source->contacts->len; j++)
+				g_ptr_array_add (source->view_contacts, g_object_ref (g_ptr_array_index (source->contacts, j)));
+		}
+
+		refilter_contact_source (contact_store, i);
+	}
+
+	return TRUE;
+}
+
 /* ---------------- *
  * GtkTreeModel API *
  * ---------------- */
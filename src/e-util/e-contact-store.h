@@ -54,6 +54,18 @@ typedef struct _EContactStore EContactStore;
 typedef struct _EContactStoreClass EContactStoreClass;
 typedef struct _EContactStorePrivate EContactStorePrivate;
 
+/**
+ * EContactStoreFilterFunc:
+ * @contact: an #EContact
+ * @user_data: user data passed to e_contact_store_narrow_query()
+ *
+ * Returns: whether @contact should be shown in the #EContactStore
+ *
+ * Since: 3.30
+ **/
+typedef gboolean (* EContactStoreFilterFunc)	(EContact *contact,
+						 gpointer user_data);
+
 struct _EContactStore {
 	GObject parent;
 	EContactStorePrivate *priv;
@@ -93,6 +105,11 @@ gboolean	e_contact_store_remove_client	(EContactStore *contact_store,
 void		e_contact_store_set_query	(EContactStore *contact_store,
 						 EBookQuery *book_query);
 EBookQuery *	e_contact_store_peek_query	(EContactStore *contact_store);
+gboolean	e_contact_store_narrow_query	(EContactStore *contact_store,
+						 EBookQuery *book_query,
+						 EContactStoreFilterFunc filter_func,
+						 gpointer user_data,
+						 GDestroyNotify destroy_data);
 
 G_END_DECLS
 
@@ -68,6 +68,109 @@ static gint special_chars[] = {
 #define is_trailing_garbage(c) (c > 127 || (special_chars[c] & 2))
 #define is_domain_name_char(c) (c < 128 && (special_chars[c] & 4))
 
+/* Characters the conversion loop in e_text_to_html_full() has to look
+ * at one by one; anything else is copied to the output as is.
+ *
+ * 1 = always: NUL, controls except CR and TAB, "&<>, newline and 8-bit
+ * 2 = space, with E_TEXT_TO_HTML_CONVERT_SPACES
+ * 4 = TAB, with E_TEXT_TO_HTML_CONVERT_SPACES or E_TEXT_TO_HTML_CONVERT_NL
+ * 8 = '@', with E_TEXT_TO_HTML_CONVERT_ADDRESSES
+ * 16 = first letters of recognized URL prefixes, with E_TEXT_TO_HTML_CONVERT_URLS
+ */
+static const guchar stop_chars[256] = {
+	1, 1, 1, 1, 1, 1, 1, 1, 1, 4, 1, 1, 1, 0, 1, 1,    /*  nul - 0x0f */
+	1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,    /* 0x10 - 0x1f */
+	2, 0, 1, 0, 0, 0, 1, 0, 0, 0, 0, 0, 0, 0, 0, 0,    /*   sp - /    */
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 0, 1, 0,    /*    0 - ?    */
+	8, 0, 0,16, 0, 0,16, 0,16, 0, 0, 0, 0,16,16, 0,    /*    @ - O    */
+	0, 0, 0,16,16, 0, 0,16, 0, 0, 0, 0, 0, 0, 0, 0,    /*    P - _    */
+	0, 0, 0,16, 0, 0,16, 0,16, 0, 0, 0, 0,16,16, 0,    /*    ` - o    */
+	0, 0, 0,16,16, 0, 0,16, 0, 0, 0, 0, 0, 0, 0, 0,    /*    p - del  */
+	1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,    /* 0x80 - 0x8f */
+	1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+	1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+	1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+	1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+	1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+	1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+	1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1     /* 0xf0 - 0xff */
+};
+
+static guchar
+stop_chars_mask (guint flags)
+{
+	guchar mask = 1;
+
+	if (flags & E_TEXT_TO_HTML_CONVERT_SPACES)
+		mask |= 2;
+	if (flags & (E_TEXT_TO_HTML_CONVERT_SPACES | E_TEXT_TO_HTML_CONVERT_NL))
+		mask |= 4;
+	if (flags & E_TEXT_TO_HTML_CONVERT_ADDRESSES)
+		mask |= 8;
+	if (flags & E_TEXT_TO_HTML_CONVERT_URLS)
+		mask |= 16;
+
+	return mask;
+}
+
+static gboolean
+has_url_scheme (const guchar *text)
+{
+	const gchar *cur = (const gchar *) text;
+
+	return !g_ascii_strncasecmp (cur, "http://", 7) ||
+		!g_ascii_strncasecmp (cur, "https://", 8) ||
+		!g_ascii_strncasecmp (cur, "ftp://", 6) ||
+		!g_ascii_strncasecmp (cur, "nntp://", 7) ||
+		!g_ascii_strncasecmp (cur, "mailto:", 7) ||
+		!g_ascii_strncasecmp (cur, "news:", 5) ||
+		!g_ascii_strncasecmp (cur, "file:", 5) ||
+		!g_ascii_strncasecmp (cur, "callto:", 7) ||
+		!g_ascii_strncasecmp (cur, "h323:", 5) ||
+		!g_ascii_strncasecmp (cur, "sip:", 4) ||
+		!g_ascii_strncasecmp (cur, "tel:", 4) ||
+		!g_ascii_strncasecmp (cur, "webcal:", 7);
+}
+
+static gboolean
+is_www_start (const guchar *text)
+{
+	return !g_ascii_strncasecmp ((const gchar *) text, "www.", 4) &&
+		is_url_char (text[4]);
+}
+
+/* Returns how many bytes from @text on need no conversion at all */
+static gsize
+plain_run_length (const guchar *text,
+                  guchar mask)
+{
+	const guchar *p = text;
+
+	while (TRUE) {
+		guchar stop;
+
+		/* Unrolled, most runs are longer than a few bytes */
+		while (!(stop_chars[p[0]] & mask) &&
+		       !(stop_chars[p[1]] & mask) &&
+		       !(stop_chars[p[2]] & mask) &&
+		       !(stop_chars[p[3]] & mask))
+			p += 4;
+
+		while (!(stop_chars[*p] & mask))
+			p++;
+
+		/* Letters like 't' or 's' are too common to stop
+		 * at each of them, only stop when a URL starts. */
+		stop = stop_chars[*p] & mask;
+		if (stop != 16 || has_url_scheme (p) || is_www_start (p))
+			break;
+
+		p++;
+	}
+
+	return p - text;
+}
+
 /* (http|https|ftp|nntp)://[^ "|/]+\.([^ "|]*[^ ,.!?;:>)\]}`'"|_-])+ */
 /* www\.[A-Za-z0-9.-]+(/([^ "|]*[^ ,.!?;:>)\]}`'"|_-])+)             */
 
@@ -243,6 +346,7 @@ e_text_to_html_full (const gchar *input,
 	gchar *out = NULL;
 	gint buffer_size = 0, col;
 	gboolean colored = FALSE, saw_citation = FALSE;
+	guchar mask;
 
 	/* Allocate a translation buffer.  */
 	buffer_size = strlen (input) * 2 + 5;
@@ -253,6 +357,7 @@ e_text_to_html_full (const gchar *input,
 		out += sprintf (out, "<PRE>");
 
 	col = 0;
+	mask = stop_chars_mask (flags);
 
 	for (cur = linestart = (const guchar *) input; cur && *cur; cur = next) {
 		gunichar u;
@@ -285,23 +390,26 @@ e_text_to_html_full (const gchar *input,
 			out += sprintf (out, "&gt; ");
 		}
 
+		/* Copy characters which are not escaped, not part
+		 * of whitespace conversion and cannot start a URL
+		 * or an address in one go. */
+		if (!(stop_chars[*cur] & mask)) {
+			gsize len = plain_run_length (cur, mask);
+
+			out = check_size (&buffer, &buffer_size, out, len);
+			memcpy (out, cur, len);
+			out += len;
+			col += len;
+			next = cur + len;
+			continue;
+		}
+
 		u = g_utf8_get_char ((gchar *) cur);
 		if (g_unichar_isalpha (u) &&
 		    (flags & E_TEXT_TO_HTML_CONVERT_URLS)) {
 			gchar *tmpurl = NULL, *refurl = NULL, *dispurl = NULL;
 
-			if (!g_ascii_strncasecmp ((gchar *) cur, "http://", 7) ||
-			    !g_ascii_strncasecmp ((gchar *) cur, "https://", 8) ||
-			    !g_ascii_strncasecmp ((gchar *) cur, "ftp://", 6) ||
-			    !g_ascii_strncasecmp ((gchar *) cur, "nntp://", 7) ||
-			    !g_ascii_strncasecmp ((gchar *) cur, "mailto:", 7) ||
-			    !g_ascii_strncasecmp ((gchar *) cur, "news:", 5) ||
-			    !g_ascii_strncasecmp ((gchar *) cur, "file:", 5) ||
-			    !g_ascii_strncasecmp ((gchar *) cur, "callto:", 7) ||
-			    !g_ascii_strncasecmp ((gchar *) cur, "h323:", 5) ||
-			    !g_ascii_strncasecmp ((gchar *) cur, "sip:", 4) ||
-			    !g_ascii_strncasecmp ((gchar *) cur, "tel:", 4) ||
-			    !g_ascii_strncasecmp ((gchar *) cur, "webcal:", 7)) {
+			if (has_url_scheme (cur)) {
 				tmpurl = url_extract (&cur, TRUE, (flags & E_TEXT_TO_HTML_URL_IS_WHOLE_TEXT) != 0);
 				if (tmpurl) {
 					refurl = e_text_to_html (tmpurl, 0);
@@ -323,8 +431,7 @@ e_text_to_html_full (const gchar *input,
 						dispurl = g_strdup (refurl);
 					}
 				}
-			} else if (!g_ascii_strncasecmp ((gchar *) cur, "www.", 4) &&
-				   is_url_char (*(cur + 4))) {
+			} else if (is_www_start (cur)) {
 				tmpurl = url_extract (&cur, FALSE, (flags & E_TEXT_TO_HTML_URL_IS_WHOLE_TEXT) != 0);
 				if (tmpurl) {
 					dispurl = e_text_to_html (tmpurl, 0);
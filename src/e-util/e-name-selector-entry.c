@@ -62,6 +62,9 @@ struct _ENameSelectorEntryPrivate {
 	gboolean is_completing;
 	GSList *user_query_fields;
 
+	/* The cue the contact store last asked the books for */
+	gchar *completion_base_cue;
+
 	/* For asynchronous operations. */
 	GQueue cancellables;
 
@@ -223,6 +226,8 @@ name_selector_entry_dispose (GObject *object)
 	g_slist_free (priv->user_query_fields);
 	priv->user_query_fields = NULL;
 
+	g_clear_pointer (&priv->completion_base_cue, g_free);
+
 	/* Cancel any stuck book loading operations. */
 	while (!g_queue_is_empty (&priv->cancellables)) {
 		GCancellable *cancellable;
@@ -824,6 +829,129 @@ ens_util_populate_user_query_fields (GSList *user_query_fields,
 	return g_string_free (user_fields, !user_fields->str || !*user_fields->str);
 }
 
+typedef struct _CompletionFilter {
+	gchar *cue_str;
+	gchar *spaced_str;
+	gchar *comma_str;
+} CompletionFilter;
+
+static CompletionFilter *
+completion_filter_new (const gchar *cue_str)
+{
+	CompletionFilter *filter;
+	gchar **strv;
+
+	filter = g_new0 (CompletionFilter, 1);
+	filter->cue_str = g_strdup (cue_str);
+
+	/* The same as name_style_query() does */
+	filter->spaced_str = sanitize_string (cue_str);
+	g_strstrip (filter->spaced_str);
+
+	strv = g_strsplit (filter->spaced_str, " ", 0);
+	if (strv[0] && strv[1]) {
+		filter->comma_str = g_strjoinv (", ", strv);
+		g_strstrip (filter->comma_str);
+	}
+	g_strfreev (strv);
+
+	return filter;
+}
+
+static void
+completion_filter_free (gpointer ptr)
+{
+	CompletionFilter *filter = ptr;
+
+	if (filter) {
+		g_free (filter->cue_str);
+		g_free (filter->spaced_str);
+		g_free (filter->comma_str);
+		g_free (filter);
+	}
+}
+
+static gboolean
+completion_filter_match_value (const gchar *value,
+                               const gchar *str,
+                               gboolean beginswith)
+{
+	const gchar *found;
+
+	if (!value || !*value || !str)
+		return FALSE;
+
+	found = e_util_utf8_strstrcasedecomp (value, str);
+
+	return found && (!beginswith || found == value);
+}
+
+static gboolean
+completion_filter_match_name (CompletionFilter *filter,
+                              EContact *contact,
+                              EContactField field_id)
+{
+	const gchar *value;
+
+	value = e_contact_get_const (contact, field_id);
+
+	return completion_filter_match_value (value, filter->spaced_str, TRUE) ||
+		completion_filter_match_value (value, filter->comma_str, TRUE);
+}
+
+/* The backends evaluate the name-style tests also against the parts
+ * of the structured name, like the local book does for the "full_name"
+ * and the LDAP book with the surname, thus match them here too. */
+static gboolean
+completion_filter_match_name_parts (CompletionFilter *filter,
+                                    EContact *contact)
+{
+	EContactName *name;
+	gboolean matches;
+
+	name = e_contact_get (contact, E_CONTACT_NAME);
+	if (!name)
+		return FALSE;
+
+	matches = completion_filter_match_value (name->given, filter->spaced_str, TRUE) ||
+		completion_filter_match_value (name->additional, filter->spaced_str, TRUE) ||
+		completion_filter_match_value (name->family, filter->spaced_str, TRUE);
+
+	e_contact_name_free (name);
+
+	return matches;
+}
+
+/* Matches the contacts the same way as the query from set_completion_query();
+ * it can accept a few more, when a backend does not test the name parts, but
+ * never less, thus narrowing does not drop what a new query would return. */
+static gboolean
+completion_filter_contact_cb (EContact *contact,
+                              gpointer user_data)
+{
+	CompletionFilter *filter = user_data;
+	GList *emails, *link;
+	gboolean matches;
+
+	matches = completion_filter_match_value (e_contact_get_const (contact, E_CONTACT_NICKNAME), filter->cue_str, FALSE) ||
+		completion_filter_match_name (filter, contact, E_CONTACT_FULL_NAME) ||
+		completion_filter_match_name (filter, contact, E_CONTACT_FILE_AS) ||
+		completion_filter_match_name_parts (filter, contact);
+
+	if (matches)
+		return TRUE;
+
+	emails = e_contact_get (contact, E_CONTACT_EMAIL);
+
+	for (link = emails; link && !matches; link = g_list_next (link)) {
+		matches = completion_filter_match_value (link->data, filter->cue_str, FALSE);
+	}
+
+	g_list_free_full (emails, g_free);
+
+	return matches;
+}
+
 static void
 set_completion_query (ENameSelectorEntry *name_selector_entry,
                       const gchar *cue_str)
@@ -844,6 +972,7 @@ set_completion_query (ENameSelectorEntry *name_selector_entry,
 	if (!cue_str) {
 		/* Clear the store */
 		e_contact_store_set_query (name_selector_entry->priv->contact_store, NULL);
+		g_clear_pointer (&priv->completion_base_cue, g_free);
 		return;
 	}
 
@@ -875,7 +1004,23 @@ set_completion_query (ENameSelectorEntry *name_selector_entry,
 	ENS_DEBUG (g_print ("%s\n", query_str));
 
 	book_query = e_book_query_from_string (query_str);
-	e_contact_store_set_query (name_selector_entry->priv->contact_store, book_query);
+
+	/* When the cue had been only extended, filter the contacts received
+	 * for the shorter cue, instead of asking the books again. The user
+	 * query fields can contain exact matches, which cannot be narrowed. */
+	if (!priv->completion_base_cue || priv->user_query_fields ||
+	    !g_str_has_prefix (cue_str, priv->completion_base_cue) ||
+	    !e_contact_store_narrow_query (
+		name_selector_entry->priv->contact_store, book_query,
+		completion_filter_contact_cb, completion_filter_new (cue_str),
+		completion_filter_free)) {
+		/* Does nothing when e_contact_store_narrow_query() set it already */
+		e_contact_store_set_query (name_selector_entry->priv->contact_store, book_query);
+
+		g_free (priv->completion_base_cue);
+		priv->completion_base_cue = g_strdup (cue_str);
+	}
+
 	e_book_query_unref (book_query);
 
 	g_free (query_str);
@@ -1270,6 +1415,7 @@ clear_completion_model (ENameSelectorEntry *name_selector_entry)
 
 	e_contact_store_set_query (name_selector_entry->priv->contact_store, NULL);
 	g_hash_table_remove_all (name_selector_entry->priv->known_contacts);
+	g_clear_pointer (&priv->completion_base_cue, g_free);
 	priv->is_completing = FALSE;
 }
 
@@ -3741,6 +3887,8 @@ e_name_selector_entry_set_contact_store (ENameSelectorEntry *name_selector_entry
 	if (name_selector_entry->priv->contact_store)
 		g_object_ref (name_selector_entry->priv->contact_store);
 
+	g_clear_pointer (&name_selector_entry->priv->completion_base_cue, g_free);
+
 	setup_contact_store (name_selector_entry);
 }
 
@@ -18,6 +18,8 @@
 
 #include <gio/gio.h>
 
+#include "e-trace.h"
+
 #include "e-simple-async-result.h"
 
 struct _ESimpleAsyncResultPrivate {
@@ -243,6 +245,7 @@ typedef struct _ThreadData {
 	gint io_priority;
 	ESimpleAsyncResultThreadFunc func;
 	GCancellable *cancellable;
+	ETraceOp *trace_op;
 } ThreadData;
 
 static gint
@@ -269,10 +272,14 @@ e_simple_async_result_thread (gpointer data,
 	g_return_if_fail (E_IS_SIMPLE_ASYNC_RESULT (td->result));
 	g_return_if_fail (td->func != NULL);
 
+	e_trace_op_start (td->trace_op);
+
 	td->func (td->result,
 		g_async_result_get_source_object (G_ASYNC_RESULT (td->result)),
 		td->cancellable);
 
+	e_trace_op_finish (td->trace_op);
+
 	e_simple_async_result_complete_idle (td->result);
 
 	g_clear_object (&td->result);
@@ -297,6 +304,11 @@ e_simple_async_result_run_in_thread (ESimpleAsyncResult *result,
 	td->func = func;
 	td->cancellable = cancellable ? g_object_ref (cancellable) : NULL;
 
+	if (e_trace_is_enabled ()) {
+		td->trace_op = e_trace_op_new ("thread-job",
+			result->priv->source_object ? G_OBJECT_TYPE_NAME (result->priv->source_object) : G_OBJECT_TYPE_NAME (result));
+	}
+
 	G_LOCK (thread_pool);
 
 	if (!thread_pool) {
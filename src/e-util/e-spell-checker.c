@@ -34,9 +34,22 @@
 
 #define MAX_SUGGESTIONS 10
 
+/* Limits for the word verdict caches; when reached, the cache
+ * is simply emptied and refilled by subsequent checks. */
+#define MAX_CACHED_VERDICTS 8192
+#define MAX_VERDICT_CACHES 8
+
+/* Values stored in the word verdict caches. */
+#define VERDICT_RECOGNIZED GINT_TO_POINTER (1)
+#define VERDICT_MISSPELLED GINT_TO_POINTER (2)
+
 struct _ESpellCheckerPrivate {
 	GHashTable *active_dictionaries;
 	GHashTable *dictionaries_cache;
+
+	/* Active language codes ~> GHashTable { gchar *word ~> verdict } */
+	GHashTable *verdict_caches;
+	GHashTable *active_verdicts; /* owned by verdict_caches, or NULL */
 };
 
 enum {
@@ -107,6 +120,8 @@ spell_checker_dispose (GObject *object)
 
 	priv = E_SPELL_CHECKER_GET_PRIVATE (object);
 
+	priv->active_verdicts = NULL;
+	g_hash_table_remove_all (priv->verdict_caches);
 	g_hash_table_remove_all (priv->active_dictionaries);
 	g_hash_table_remove_all (priv->dictionaries_cache);
 
@@ -123,6 +138,7 @@ spell_checker_finalize (GObject *object)
 
 	g_hash_table_destroy (priv->active_dictionaries);
 	g_hash_table_destroy (priv->dictionaries_cache);
+	g_hash_table_destroy (priv->verdict_caches);
 
 	/* Chain up to parent's finalize() method. */
 	G_OBJECT_CLASS (e_spell_checker_parent_class)->finalize (object);
@@ -184,6 +200,43 @@ e_spell_checker_init (ESpellChecker *checker)
 
 	checker->priv->active_dictionaries = active_dictionaries;
 	checker->priv->dictionaries_cache = dictionaries_cache;
+	checker->priv->verdict_caches = g_hash_table_new_full (
+		(GHashFunc) g_str_hash,
+		(GEqualFunc) g_str_equal,
+		(GDestroyNotify) g_free,
+		(GDestroyNotify) g_hash_table_destroy);
+}
+
+static GHashTable *
+spell_checker_get_active_verdicts (ESpellChecker *checker)
+{
+	GHashTable *verdicts;
+	gchar **languages;
+	gchar *key;
+
+	if (checker->priv->active_verdicts)
+		return checker->priv->active_verdicts;
+
+	/* The list is sorted, thus the key does not depend
+	 * on the order in which the languages were activated. */
+	languages = e_spell_checker_list_active_languages (checker, NULL);
+	key = g_strjoinv (",", languages);
+	g_strfreev (languages);
+
+	verdicts = g_hash_table_lookup (checker->priv->verdict_caches, key);
+	if (verdicts) {
+		g_free (key);
+	} else {
+		if (g_hash_table_size (checker->priv->verdict_caches) >= MAX_VERDICT_CACHES)
+			g_hash_table_remove_all (checker->priv->verdict_caches);
+
+		verdicts = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+		g_hash_table_insert (checker->priv->verdict_caches, key, verdicts);
+	}
+
+	checker->priv->active_verdicts = verdicts;
+
+	return verdicts;
 }
 
 /**
@@ -460,9 +513,11 @@ e_spell_checker_set_language_active (ESpellChecker *checker,
 	if (active && !is_active) {
 		g_object_ref (dictionary);
 		g_hash_table_add (active_dictionaries, dictionary);
+		checker->priv->active_verdicts = NULL;
 		g_object_notify (G_OBJECT (checker), "active-languages");
 	} else if (!active && is_active) {
 		g_hash_table_remove (active_dictionaries, dictionary);
+		checker->priv->active_verdicts = NULL;
 		g_object_notify (G_OBJECT (checker), "active-languages");
 	}
 
@@ -497,6 +552,7 @@ e_spell_checker_set_active_languages (ESpellChecker *checker,
 	}
 
 	g_hash_table_remove_all (checker->priv->active_dictionaries);
+	checker->priv->active_verdicts = NULL;
 	for (ii = 0; languages && languages[ii]; ii++) {
 		e_spell_checker_set_language_active (checker, languages[ii], TRUE);
 	}
@@ -577,6 +633,9 @@ e_spell_checker_count_active_languages (ESpellChecker *checker)
  * Calls e_spell_dictionary_check_word() on all active dictionaries in
  * @checker, and returns %TRUE if @word is recognized by any of them.
  *
+ * The verdicts are remembered for each set of active dictionaries,
+ * thus checking the same word again is cheap.
+ *
  * Returns: %TRUE if @word is recognized, %FALSE otherwise
  **/
 gboolean
@@ -584,12 +643,30 @@ e_spell_checker_check_word (ESpellChecker *checker,
                             const gchar *word,
                             gsize length)
 {
+	GHashTable *verdicts;
 	GList *list, *link;
+	gchar *key;
+	gpointer verdict;
 	gboolean recognized = FALSE;
 
 	g_return_val_if_fail (E_IS_SPELL_CHECKER (checker), TRUE);
 	g_return_val_if_fail (word != NULL && *word != '\0', TRUE);
 
+	if (!g_hash_table_size (checker->priv->active_dictionaries))
+		return FALSE;
+
+	if (length == (gsize) -1)
+		key = g_strdup (word);
+	else
+		key = g_strndup (word, length);
+
+	verdicts = spell_checker_get_active_verdicts (checker);
+	verdict = g_hash_table_lookup (verdicts, key);
+	if (verdict) {
+		g_free (key);
+		return verdict == VERDICT_RECOGNIZED;
+	}
+
 	list = g_hash_table_get_keys (checker->priv->active_dictionaries);
 
 	for (link = list; link != NULL; link = g_list_next (link)) {
@@ -604,9 +681,51 @@ e_spell_checker_check_word (ESpellChecker *checker,
 
 	g_list_free (list);
 
+	if (g_hash_table_size (verdicts) >= MAX_CACHED_VERDICTS)
+		g_hash_table_remove_all (verdicts);
+
+	g_hash_table_insert (verdicts, key, recognized ? VERDICT_RECOGNIZED : VERDICT_MISSPELLED);
+
 	return recognized;
 }
 
+/**
+ * e_spell_checker_invalidate_word:
+ * @checker: an #ESpellChecker
+ * @word: a word whose remembered verdict should be dropped
+ * @length: length of @word in bytes or -1 when %NULL-terminated
+ *
+ * Drops any verdict remembered by e_spell_checker_check_word() for @word,
+ * for all sets of active dictionaries. This is called automatically when
+ * the @word is learned or ignored by any of the @checker dictionaries.
+ *
+ * Since: 3.30
+ **/
+void
+e_spell_checker_invalidate_word (ESpellChecker *checker,
+                                 const gchar *word,
+                                 gsize length)
+{
+	GHashTableIter iter;
+	gpointer value;
+	gchar *key;
+
+	g_return_if_fail (E_IS_SPELL_CHECKER (checker));
+	g_return_if_fail (word != NULL);
+
+	if (length == (gsize) -1)
+		key = g_strdup (word);
+	else
+		key = g_strndup (word, length);
+
+	g_hash_table_iter_init (&iter, checker->priv->verdict_caches);
+	while (g_hash_table_iter_next (&iter, NULL, &value)) {
+		g_hash_table_remove (value, key);
+	}
+
+	g_free (key);
+}
+
 /**
  * e_spell_checker_ignore_word:
  * @checker: an #ESpellChecker
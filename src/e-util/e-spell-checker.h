@@ -93,6 +93,9 @@ guint		e_spell_checker_count_active_languages
 gboolean	e_spell_checker_check_word	(ESpellChecker *checker,
 						 const gchar *word,
 						 gsize length);
+void		e_spell_checker_invalidate_word	(ESpellChecker *checker,
+						 const gchar *word,
+						 gsize length);
 void		e_spell_checker_learn_word	(ESpellChecker *checker,
 						 const gchar *word);
 void		e_spell_checker_ignore_word	(ESpellChecker *checker,
@@ -0,0 +1,537 @@
+/*
+ * Copyright (C) 2018 Red Hat, Inc. (www.redhat.com)
+ *
+ * This library is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * SECTION: e-trace
+ * @include: e-util/e-util.h
+ * @short_description: Operation timing and lock contention tracer
+ *
+ * The tracer records when an operation was queued, when it started and
+ * finished, and how long it waited for locks taken with e_trace_mutex_lock()
+ * or e_trace_rec_mutex_lock(). It is disabled by default and enabled by
+ * setting the EVOLUTION_TRACE environment variable; a value containing
+ * "live" also prints the currently queued and running operations to stderr
+ * every few seconds.
+ *
+ * The recorded operations are written at exit into a file in the Trace Event
+ * JSON format, which can be opened in chrome://tracing or similar tools.
+ * The file name can be set with the EVOLUTION_TRACE_FILE environment
+ * variable, otherwise it is a "trace-PID.json" file in the user cache
+ * directory.
+ **/
+
+#include "evolution-config.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <libedataserver/libedataserver.h>
+
+#include "e-trace.h"
+
+/* How many finished operations are remembered */
+#define E_TRACE_MAX_EVENTS	100000
+
+/* How often the live view is printed, in seconds */
+#define E_TRACE_LIVE_INTERVAL	2
+
+struct _ETraceOp {
+	gchar *category;
+	gchar *name;
+	gint64 queued;
+	gint64 started;
+	gint64 finished;
+	gint64 lock_wait;
+	guint tid;
+	ETraceOp *parent; /* the operation running in the thread before this one */
+};
+
+static gboolean trace_enabled = FALSE;
+static gint64 trace_start_time = 0;
+static gchar *trace_filename = NULL;
+
+static GMutex trace_lock;
+static GQueue trace_finished = G_QUEUE_INIT; /* ETraceOp * */
+static GHashTable *trace_unfinished = NULL; /* ETraceOp * */
+
+static GPrivate trace_current_op;
+static GPrivate trace_thread_id;
+static volatile gint trace_last_thread_id = 0;
+
+static void
+trace_op_free (ETraceOp *op)
+{
+	if (op) {
+		g_free (op->category);
+		g_free (op->name);
+		g_slice_free (ETraceOp, op);
+	}
+}
+
+static guint
+trace_get_thread_id (void)
+{
+	guint tid;
+
+	tid = GPOINTER_TO_UINT (g_private_get (&trace_thread_id));
+	if (!tid) {
+		tid = g_atomic_int_add (&trace_last_thread_id, 1) + 1;
+		g_private_set (&trace_thread_id, GUINT_TO_POINTER (tid));
+	}
+
+	return tid;
+}
+
+static void
+trace_write_at_exit (void)
+{
+	GError *local_error = NULL;
+
+	if (e_trace_write_json (trace_filename, &local_error))
+		g_printerr ("Evolution trace written to '%s'\n", trace_filename);
+	else
+		g_printerr ("Failed to write Evolution trace to '%s': %s\n", trace_filename, local_error ? local_error->message : "Unknown error");
+
+	g_clear_error (&local_error);
+}
+
+static gpointer
+trace_live_thread (gpointer user_data)
+{
+	while (TRUE) {
+		gchar *text;
+
+		g_usleep (E_TRACE_LIVE_INTERVAL * G_USEC_PER_SEC);
+
+		text = e_trace_dup_running ();
+		if (text && *text)
+			g_printerr ("--- Evolution operations ---\n%s", text);
+		g_free (text);
+	}
+
+	return NULL;
+}
+
+static gpointer
+trace_init (gpointer user_data)
+{
+	const gchar *env;
+
+	env = g_getenv ("EVOLUTION_TRACE");
+	if (!env || !*env || g_strcmp0 (env, "0") == 0)
+		return NULL;
+
+	trace_start_time = g_get_monotonic_time ();
+	trace_unfinished = g_hash_table_new (g_direct_hash, g_direct_equal);
+
+	env = g_getenv ("EVOLUTION_TRACE_FILE");
+	if (env && *env) {
+		trace_filename = g_strdup (env);
+	} else {
+		gchar *basename;
+
+		basename = g_strdup_printf ("trace-%d.json", (gint) getpid ());
+		trace_filename = g_build_filename (e_get_user_cache_dir (), basename, NULL);
+		g_free (basename);
+	}
+
+	atexit (trace_write_at_exit);
+
+	if (strstr (g_getenv ("EVOLUTION_TRACE"), "live")) {
+		GThread *thread;
+
+		thread = g_thread_new ("e-trace-live", trace_live_thread, NULL);
+		g_thread_unref (thread);
+	}
+
+	/* The last, the other threads can start using it now */
+	g_atomic_int_set (&trace_enabled, TRUE);
+
+	return NULL;
+}
+
+/**
+ * e_trace_is_enabled:
+ *
+ * Returns: Whether the operation tracing is enabled
+ *
+ * Since: 3.30
+ **/
+gboolean
+e_trace_is_enabled (void)
+{
+	static GOnce trace_once = G_ONCE_INIT;
+
+	g_once (&trace_once, trace_init, NULL);
+
+	return trace_enabled;
+}
+
+/**
+ * e_trace_op_new:
+ * @category: a category of the operation, like "mail-msg"
+ * @name: a name of the operation
+ *
+ * Creates a new traced operation and marks it as queued. Start it with
+ * e_trace_op_start() in the thread, which executes it, and finish it
+ * with e_trace_op_finish().
+ *
+ * Returns: (transfer full) (nullable): a new #ETraceOp, or %NULL, when
+ *    the tracing is disabled
+ *
+ * Since: 3.30
+ **/
+ETraceOp *
+e_trace_op_new (const gchar *category,
+		const gchar *name)
+{
+	ETraceOp *op;
+
+	if (!e_trace_is_enabled ())
+		return NULL;
+
+	op = g_slice_new0 (ETraceOp);
+	op->category = g_strdup (category ? category : "default");
+	op->name = g_strdup (name ? name : "unnamed");
+	op->queued = g_get_monotonic_time ();
+
+	g_mutex_lock (&trace_lock);
+	g_hash_table_add (trace_unfinished, op);
+	g_mutex_unlock (&trace_lock);
+
+	return op;
+}
+
+/**
+ * e_trace_op_start:
+ * @op: (nullable): an #ETraceOp
+ *
+ * Marks the @op as running in the current thread. Waits in
+ * e_trace_mutex_lock() and e_trace_rec_mutex_lock() are counted
+ * to the @op, until it's finished. Does nothing when @op is %NULL.
+ *
+ * Since: 3.30
+ **/
+void
+e_trace_op_start (ETraceOp *op)
+{
+	if (!op)
+		return;
+
+	op->started = g_get_monotonic_time ();
+	op->tid = trace_get_thread_id ();
+	op->parent = g_private_get (&trace_current_op);
+
+	g_private_set (&trace_current_op, op);
+}
+
+/**
+ * e_trace_op_finish:
+ * @op: (nullable) (transfer full): an #ETraceOp
+ *
+ * Marks the @op as finished. It should be called in the same thread
+ * as e_trace_op_start() had been called. The @op cannot be used after
+ * this call. Does nothing when @op is %NULL.
+ *
+ * Since: 3.30
+ **/
+void
+e_trace_op_finish (ETraceOp *op)
+{
+	if (!op)
+		return;
+
+	op->finished = g_get_monotonic_time ();
+
+	/* Never started, like a cancelled operation */
+	if (!op->started) {
+		op->started = op->finished;
+		op->tid = trace_get_thread_id ();
+	} else if (g_private_get (&trace_current_op) == op) {
+		g_private_set (&trace_current_op, op->parent);
+	}
+
+	op->parent = NULL;
+
+	g_mutex_lock (&trace_lock);
+
+	g_hash_table_remove (trace_unfinished, op);
+	g_queue_push_tail (&trace_finished, op);
+
+	if (g_queue_get_length (&trace_finished) > E_TRACE_MAX_EVENTS)
+		trace_op_free (g_queue_pop_head (&trace_finished));
+
+	g_mutex_unlock (&trace_lock);
+}
+
+static void
+trace_add_lock_wait (gint64 wait_start)
+{
+	ETraceOp *op;
+
+	op = g_private_get (&trace_current_op);
+	if (op)
+		op->lock_wait += g_get_monotonic_time () - wait_start;
+}
+
+/**
+ * e_trace_mutex_lock:
+ * @mutex: a #GMutex
+ *
+ * Locks the @mutex like g_mutex_lock() does. When the tracing is enabled,
+ * the time spent waiting for the @mutex is counted to the operation
+ * running in the current thread.
+ *
+ * Since: 3.30
+ **/
+void
+e_trace_mutex_lock (GMutex *mutex)
+{
+	gint64 wait_start;
+
+	if (!e_trace_is_enabled ()) {
+		g_mutex_lock (mutex);
+		return;
+	}
+
+	if (g_mutex_trylock (mutex))
+		return;
+
+	wait_start = g_get_monotonic_time ();
+	g_mutex_lock (mutex);
+	trace_add_lock_wait (wait_start);
+}
+
+/**
+ * e_trace_rec_mutex_lock:
+ * @mutex: a #GRecMutex
+ *
+ * Locks the @mutex like g_rec_mutex_lock() does. When the tracing is enabled,
+ * the time spent waiting for the @mutex is counted to the operation
+ * running in the current thread.
+ *
+ * Since: 3.30
+ **/
+void
+e_trace_rec_mutex_lock (GRecMutex *mutex)
+{
+	gint64 wait_start;
+
+	if (!e_trace_is_enabled ()) {
+		g_rec_mutex_lock (mutex);
+		return;
+	}
+
+	if (g_rec_mutex_trylock (mutex))
+		return;
+
+	wait_start = g_get_monotonic_time ();
+	g_rec_mutex_lock (mutex);
+	trace_add_lock_wait (wait_start);
+}
+
+static gint
+trace_compare_ops_by_queued (gconstpointer ptr1,
+			     gconstpointer ptr2)
+{
+	const ETraceOp *op1 = *((const ETraceOp **) ptr1);
+	const ETraceOp *op2 = *((const ETraceOp **) ptr2);
+
+	if (op1->queued == op2->queued)
+		return 0;
+
+	return op1->queued < op2->queued ? -1 : 1;
+}
+
+/**
+ * e_trace_dup_running:
+ *
+ * Describes the operations, which are currently queued or running,
+ * one per line, with the time they have been queued or running for.
+ *
+ * Returns: (transfer full) (nullable): a newly allocated string with
+ *    the description, or %NULL, when the tracing is disabled. Free it
+ *    with g_free(), when no longer needed.
+ *
+ * Since: 3.30
+ **/
+gchar *
+e_trace_dup_running (void)
+{
+	GPtrArray *ops;
+	GHashTableIter iter;
+	GString *str;
+	gpointer key;
+	gint64 now;
+	guint ii;
+
+	if (!e_trace_is_enabled ())
+		return NULL;
+
+	str = g_string_new ("");
+	ops = g_ptr_array_new ();
+	now = g_get_monotonic_time ();
+
+	g_mutex_lock (&trace_lock);
+
+	g_hash_table_iter_init (&iter, trace_unfinished);
+	while (g_hash_table_iter_next (&iter, &key, NULL)) {
+		g_ptr_array_add (ops, key);
+	}
+
+	g_ptr_array_sort (ops, trace_compare_ops_by_queued);
+
+	for (ii = 0; ii < ops->len; ii++) {
+		const ETraceOp *op = g_ptr_array_index (ops, ii);
+
+		/* Reading of the 'started' and the 'lock_wait' can race
+		 * with the executing thread, which is fine for the view. */
+		if (op->started) {
+			g_string_append_printf (str, "[%s] %s: running %.3f s, queued %.3f s, thread %u\n",
+				op->category, op->name,
+				(now - op->started) / (gdouble) G_USEC_PER_SEC,
+				(op->started - op->queued) / (gdouble) G_USEC_PER_SEC,
+				op->tid);
+		} else {
+			g_string_append_printf (str, "[%s] %s: queued %.3f s\n",
+				op->category, op->name,
+				(now - op->queued) / (gdouble) G_USEC_PER_SEC);
+		}
+	}
+
+	g_mutex_unlock (&trace_lock);
+
+	g_ptr_array_free (ops, TRUE);
+
+	return g_string_free (str, FALSE);
+}
+
+static void
+trace_append_json_string (GString *json,
+			  const gchar *str)
+{
+	const gchar *ptr;
+
+	g_string_append_c (json, '\"');
+
+	for (ptr = str; *ptr; ptr++) {
+		guchar chr = *ptr;
+
+		if (chr == '\"' || chr == '\\') {
+			g_string_append_c (json, '\\');
+			g_string_append_c (json, chr);
+		} else if (chr < 0x20) {
+			g_string_append_printf (json, "\\u%04x", chr);
+		} else {
+			g_string_append_c (json, chr);
+		}
+	}
+
+	g_string_append_c (json, '\"');
+}
+
+static void
+trace_append_json_event (GString *json,
+			 const ETraceOp *op,
+			 gint64 now,
+			 gint pid)
+{
+	gint64 started, finished;
+
+	started = op->started ? op->started : op->queued;
+	finished = op->finished ? op->finished : now;
+
+	if (json->len > 1)
+		g_string_append (json, ",\n");
+
+	g_string_append (json, "{\"name\":");
+	trace_append_json_string (json, op->name);
+	g_string_append (json, ",\"cat\":");
+	trace_append_json_string (json, op->category);
+	g_string_append_printf (json,
+		",\"ph\":\"X\",\"pid\":%d,\"tid\":%u"
+		",\"ts\":%" G_GINT64_FORMAT ",\"dur\":%" G_GINT64_FORMAT
+		",\"args\":{\"queued_us\":%" G_GINT64_FORMAT ",\"lock_wait_us\":%" G_GINT64_FORMAT "%s}}",
+		pid, op->tid,
+		started - trace_start_time,
+		finished - started,
+		started - op->queued,
+		op->lock_wait,
+		op->finished ? "" : ",\"unfinished\":true");
+}
+
+/**
+ * e_trace_write_json:
+ * @filename: a file name to write the trace to
+ * @error: return location for a #GError, or %NULL
+ *
+ * Writes the recorded operations into the @filename, in the Trace Event
+ * JSON format. Each operation is a complete event ("ph":"X") with
+ * the queue and the lock wait times, in microseconds, in its "args".
+ * The unfinished operations are written as well, with an "unfinished"
+ * argument.
+ *
+ * Returns: Whether succeeded; it fails also when the tracing is disabled
+ *
+ * Since: 3.30
+ **/
+gboolean
+e_trace_write_json (const gchar *filename,
+		    GError **error)
+{
+	GHashTableIter iter;
+	GString *json;
+	GList *link;
+	gpointer key;
+	gint64 now;
+	gint pid;
+	gboolean success;
+
+	g_return_val_if_fail (filename != NULL, FALSE);
+
+	if (!e_trace_is_enabled ()) {
+		g_set_error_literal (error, G_IO_ERROR, G_IO_ERROR_NOT_SUPPORTED, "Tracing is not enabled");
+		return FALSE;
+	}
+
+	json = g_string_sized_new (1024);
+	now = g_get_monotonic_time ();
+	pid = getpid ();
+
+	g_string_append_c (json, '[');
+
+	g_mutex_lock (&trace_lock);
+
+	for (link = g_queue_peek_head_link (&trace_finished); link; link = g_list_next (link)) {
+		trace_append_json_event (json, link->data, now, pid);
+	}
+
+	g_hash_table_iter_init (&iter, trace_unfinished);
+	while (g_hash_table_iter_next (&iter, &key, NULL)) {
+		trace_append_json_event (json, key, now, pid);
+	}
+
+	g_mutex_unlock (&trace_lock);
+
+	g_string_append (json, "]\n");
+
+	success = g_file_set_contents (filename, json->str, json->len, error);
+
+	g_string_free (json, TRUE);
+
+	return success;
+}
@@ -0,0 +1,43 @@
+/*
+ * Copyright (C) 2018 Red Hat, Inc. (www.redhat.com)
+ *
+ * This library is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#if !defined (__E_UTIL_H_INSIDE__) && !defined (LIBEUTIL_COMPILATION)
+#error "Only <e-util/e-util.h> should be included directly."
+#endif
+
+#ifndef E_TRACE_H
+#define E_TRACE_H
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+typedef struct _ETraceOp ETraceOp;
+
+gboolean	e_trace_is_enabled		(void);
+ETraceOp *	e_trace_op_new			(const gchar *category,
+						 const gchar *name);
+void		e_trace_op_start		(ETraceOp *op);
+void		e_trace_op_finish		(ETraceOp *op);
+void		e_trace_mutex_lock		(GMutex *mutex);
+void		e_trace_rec_mutex_lock		(GRecMutex *mutex);
+gchar *		e_trace_dup_running		(void);
+gboolean	e_trace_write_json		(const gchar *filename,
+						 GError **error);
+
+G_END_DECLS
+
+#endif /* E_TRACE_H */
@@ -0,0 +1,485 @@
+/*
+ * Copyright (C) 2018 Red Hat, Inc. (www.redhat.com)
+ *
+ * This library is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "evolution-config.h"
+
+#include <string.h>
+
+#include <e-util/e-util.h>
+
+#define MAIL_FLAGS ( \
+	E_TEXT_TO_HTML_CONVERT_NL | \
+	E_TEXT_TO_HTML_CONVERT_SPACES | \
+	E_TEXT_TO_HTML_CONVERT_URLS | \
+	E_TEXT_TO_HTML_CONVERT_ADDRESSES | \
+	E_TEXT_TO_HTML_MARK_CITATION)
+
+#define CITATION_COLOR 0x737373
+
+/* The expected output is what the character-by-character conversion
+ * produced before e_text_to_html_full() started to copy plain runs
+ * in bulk; it must not change in any byte. */
+static const struct {
+	const gchar *input;
+	guint flags;
+	const gchar *output;
+} corpus[] = {
+	{ "",
+	  0,
+	  "" },
+	{ "",
+	  MAIL_FLAGS,
+	  "" },
+	{ "",
+	  E_TEXT_TO_HTML_PRE | E_TEXT_TO_HTML_CONVERT_URLS | E_TEXT_TO_HTML_CONVERT_ADDRESSES,
+	  "<PRE></PRE>" },
+	{ "",
+	  E_TEXT_TO_HTML_CONVERT_NL | E_TEXT_TO_HTML_CITE | E_TEXT_TO_HTML_ESCAPE_8BIT,
+	  "" },
+	{ "",
+	  E_TEXT_TO_HTML_CONVERT_URLS | E_TEXT_TO_HTML_HIDE_URL_SCHEME,
+	  "" },
+	{ "Plain text without anything special in it.",
+	  0,
+	  "Plain text without anything special in it." },
+	{ "Plain text without anything special in it.",
+	  MAIL_FLAGS,
+	  "Plain text without anything special in it." },
+	{ "Plain text without anything special in it.",
+	  E_TEXT_TO_HTML_PRE | E_TEXT_TO_HTML_CONVERT_URLS | E_TEXT_TO_HTML_CONVERT_ADDRESSES,
+	  "<PRE>Plain text without anything special in it.</PRE>" },
+	{ "Plain text without anything special in it.",
+	  E_TEXT_TO_HTML_CONVERT_NL | E_TEXT_TO_HTML_CITE | E_TEXT_TO_HTML_ESCAPE_8BIT,
+	  "&gt; Plain text without anything special in it." },
+	{ "Plain text without anything special in it.",
+	  E_TEXT_TO_HTML_CONVERT_URLS | E_TEXT_TO_HTML_HIDE_URL_SCHEME,
+	  "Plain text without anything special in it." },
+	{ "a < b && c > d, \"quoted\"",
+	  0,
+	  "a &lt; b &amp;&amp; c &gt; d, &quot;quoted&quot;" },
+	{ "a < b && c > d, \"quoted\"",
+	  MAIL_FLAGS,
+	  "a &lt; b &amp;&amp; c &gt; d, &quot;quoted&quot;" },
+	{ "a < b && c > d, \"quoted\"",
+	  E_TEXT_TO_HTML_PRE | E_TEXT_TO_HTML_CONVERT_URLS | E_TEXT_TO_HTML_CONVERT_ADDRESSES,
+	  "<PRE>a &lt; b &amp;&amp; c &gt; d, &quot;quoted&quot;</PRE>" },
+	{ "a < b && c > d, \"quoted\"",
+	  E_TEXT_TO_HTML_CONVERT_NL | E_TEXT_TO_HTML_CITE | E_TEXT_TO_HTML_ESCAPE_8BIT,
+	  "&gt; a &lt; b &amp;&amp; c &gt; d, &quot;quoted&quot;" },
+	{ "a < b && c > d, \"quoted\"",
+	  E_TEXT_TO_HTML_CONVERT_URLS | E_TEXT_TO_HTML_HIDE_URL_SCHEME,
+	  "a &lt; b &amp;&amp; c &gt; d, &quot;quoted&quot;" },
+	{ "line one\nline two\n\nline four\n",
+	  0,
+	  "line one\nline two\n\nline four\n" },
+	{ "line one\nline two\n\nline four\n",
+	  MAIL_FLAGS,
+	  "line one<br>\nline two<br>\n<br>\nline four<br>\n" },
+	{ "line one\nline two\n\nline four\n",
+	  E_TEXT_TO_HTML_PRE | E_TEXT_TO_HTML_CONVERT_URLS | E_TEXT_TO_HTML_CONVERT_ADDRESSES,
+	  "<PRE>line one\nline two\n\nline four\n</PRE>" },
+	{ "line one\nline two\n\nline four\n",
+	  E_TEXT_TO_HTML_CONVERT_NL | E_TEXT_TO_HTML_CITE | E_TEXT_TO_HTML_ESCAPE_8BIT,
+	  "&gt; line one<br>\n&gt; line two<br>\n&gt; <br>\n&gt; line four<br>\n" },
+	{ "line one\nline two\n\nline four\n",
+	  E_TEXT_TO_HTML_CONVERT_URLS | E_TEXT_TO_HTML_HIDE_URL_SCHEME,
+	  "line one\nline two\n\nline four\n" },
+	{ "  two leading spaces and  double  spaces \n trailing ",
+	  0,
+	  "  two leading spaces and  double  spaces \n trailing " },
+	{ "  two leading spaces and  double  spaces \n trailing ",
+	  MAIL_FLAGS,
+	  "&nbsp; two leading spaces and&nbsp; double&nbsp; spaces <br>\n&nbsp;trailing " },
+	{ "  two leading spaces and  double  spaces \n trailing ",
+	  E_TEXT_TO_HTML_PRE | E_TEXT_TO_HTML_CONVERT_URLS | E_TEXT_TO_HTML_CONVERT_ADDRESSES,
+	  "<PRE>  two leading spaces and  double  spaces \n trailing </PRE>" },
+	{ "  two leading spaces and  double  spaces \n trailing ",
+	  E_TEXT_TO_HTML_CONVERT_NL | E_TEXT_TO_HTML_CITE | E_TEXT_TO_HTML_ESCAPE_8BIT,
+	  "&gt;   two leading spaces and  double  spaces <br>\n&gt;  trailing " },
+	{ "  two leading spaces and  double  spaces \n trailing ",
+	  E_TEXT_TO_HTML_CONVERT_URLS | E_TEXT_TO_HTML_HIDE_URL_SCHEME,
+	  "  two leading spaces and  double  spaces \n trailing " },
+	{ "col\tumn\tseparated\ttext\n\ttabbed",
+	  0,
+	  "col\tumn\tseparated\ttext\n\ttabbed" },
+	{ "col\tumn\tseparated\ttext\n\ttabbed",
+	  MAIL_FLAGS,
+	  "col&nbsp;&nbsp;&nbsp;&nbsp;&nbsp;umn&nbsp;&nbsp;&nbsp;&nbsp;&nbsp;separated&nbsp;&nbsp;&nbsp;&nbsp;&nbsp;&nbsp;&nbsp;text<br>\n&nbsp;&nbsp;&nbsp;&nbsp;&nbsp;&nbsp;&nbsp;&nbsp;tabbed" },
+	{ "col\tumn\tseparated\ttext\n\ttabbed",
+	  E_TEXT_TO_HTML_PRE | E_TEXT_TO_HTML_CONVERT_URLS | E_TEXT_TO_HTML_CONVERT_ADDRESSES,
+	  "<PRE>col\tumn\tseparated\ttext\n\ttabbed</PRE>" },
+	{ "col\tumn\tseparated\ttext\n\ttabbed",
+	  E_TEXT_TO_HTML_CONVERT_NL | E_TEXT_TO_HTML_CITE | E_TEXT_TO_HTML_ESCAPE_8BIT,
+	  "&gt; col&nbsp;&nbsp;&nbsp;&nbsp;&nbsp;umn&nbsp;&nbsp;&nbsp;&nbsp;&nbsp;separated&nbsp;&nbsp;&nbsp;&nbsp;&nbsp;&nbsp;&nbsp;text<br>\n&gt; &nbsp;&nbsp;&nbsp;&nbsp;&nbsp;&nbsp;&nbsp;&nbsp;tabbed" },
+	{ "col\tumn\tseparated\ttext\n\ttabbed",
+	  E_TEXT_TO_HTML_CONVERT_URLS | E_TEXT_TO_HTML_HIDE_URL_SCHEME,
+	  "col\tumn\tseparated\ttext\n\ttabbed" },
+	{ "> quoted line\n> another one\nreply text\n",
+	  0,
+	  "&gt; quoted line\n&gt; another one\nreply text\n" },
+	{ "> quoted line\n> another one\nreply text\n",
+	  MAIL_FLAGS,
+	  "<FONT COLOR=\"#737373\">&gt; quoted line<br>\n&gt; another one<br>\n</FONT>reply text<br>\n" },
+	{ "> quoted line\n> another one\nreply text\n",
+	  E_TEXT_TO_HTML_PRE | E_TEXT_TO_HTML_CONVERT_URLS | E_TEXT_TO_HTML_CONVERT_ADDRESSES,
+	  "<PRE>&gt; quoted line\n&gt; another one\nreply text\n</PRE>" },
+	{ "> quoted line\n> another one\nreply text\n",
+	  E_TEXT_TO_HTML_CONVERT_NL | E_TEXT_TO_HTML_CITE | E_TEXT_TO_HTML_ESCAPE_8BIT,
+	  "&gt; &gt; quoted line<br>\n&gt; &gt; another one<br>\n&gt; reply text<br>\n" },
+	{ "> quoted line\n> another one\nreply text\n",
+	  E_TEXT_TO_HTML_CONVERT_URLS | E_TEXT_TO_HTML_HIDE_URL_SCHEME,
+	  "&gt; quoted line\n&gt; another one\nreply text\n" },
+	{ ">From the beginning\nof an mbox-mangled line\n",
+	  0,
+	  "&gt;From the beginning\nof an mbox-mangled line\n" },
+	{ ">From the beginning\nof an mbox-mangled line\n",
+	  MAIL_FLAGS,
+	  "From the beginning<br>\nof an mbox-mangled line<br>\n" },
+	{ ">From the beginning\nof an mbox-mangled line\n",
+	  E_TEXT_TO_HTML_PRE | E_TEXT_TO_HTML_CONVERT_URLS | E_TEXT_TO_HTML_CONVERT_ADDRESSES,
+	  "<PRE>&gt;From the beginning\nof an mbox-mangled line\n</PRE>" },
+	{ ">From the beginning\nof an mbox-mangled line\n",
+	  E_TEXT_TO_HTML_CONVERT_NL | E_TEXT_TO_HTML_CITE | E_TEXT_TO_HTML_ESCAPE_8BIT,
+	  "&gt; &gt;From the beginning<br>\n&gt; of an mbox-mangled line<br>\n" },
+	{ ">From the beginning\nof an mbox-mangled line\n",
+	  E_TEXT_TO_HTML_CONVERT_URLS | E_TEXT_TO_HTML_HIDE_URL_SCHEME,
+	  "&gt;From the beginning\nof an mbox-mangled line\n" },
+	{ ">From here\n> the next line is quoted\n",
+	  0,
+	  "&gt;From here\n&gt; the next line is quoted\n" },
+	{ ">From here\n> the next line is quoted\n",
+	  MAIL_FLAGS,
+	  "<FONT COLOR=\"#737373\">&gt;From here<br>\n&gt; the next line is quoted<br>\n" },
+	{ ">From here\n> the next line is quoted\n",
+	  E_TEXT_TO_HTML_PRE | E_TEXT_TO_HTML_CONVERT_URLS | E_TEXT_TO_HTML_CONVERT_ADDRESSES,
+	  "<PRE>&gt;From here\n&gt; the next line is quoted\n</PRE>" },
+	{ ">From here\n> the next line is quoted\n",
+	  E_TEXT_TO_HTML_CONVERT_NL | E_TEXT_TO_HTML_CITE | E_TEXT_TO_HTML_ESCAPE_8BIT,
+	  "&gt; &gt;From here<br>\n&gt; &gt; the next line is quoted<br>\n" },
+	{ ">From here\n> the next line is quoted\n",
+	  E_TEXT_TO_HTML_CONVERT_URLS | E_TEXT_TO_HTML_HIDE_URL_SCHEME,
+	  "&gt;From here\n&gt; the next line is quoted\n" },
+	{ "Visit http://www.example.com/index.html, please.",
+	  0,
+	  "Visit http://www.example.com/index.html, please." },
+	{ "Visit http://www.example.com/index.html, please.",
+	  MAIL_FLAGS,
+	  "Visit <a href=\"http://www.example.com/index.html\">http://www.example.com/index.html</a>, please." },
+	{ "Visit http://www.example.com/index.html, please.",
+	  E_TEXT_TO_HTML_PRE | E_TEXT_TO_HTML_CONVERT_URLS | E_TEXT_TO_HTML_CONVERT_ADDRESSES,
+	  "<PRE>Visit <a href=\"http://www.example.com/index.html\">http://www.example.com/index.html</a>, please.</PRE>" },
+	{ "Visit http://www.example.com/index.html, please.",
+	  E_TEXT_TO_HTML_CONVERT_NL | E_TEXT_TO_HTML_CITE | E_TEXT_TO_HTML_ESCAPE_8BIT,
+	  "&gt; Visit http://www.example.com/index.html, please." },
+	{ "Visit http://www.example.com/index.html, please.",
+	  E_TEXT_TO_HTML_CONVERT_URLS | E_TEXT_TO_HTML_HIDE_URL_SCHEME,
+	  "Visit <a href=\"http://www.example.com/index.html\">www.example.com/index.html</a>, please." },
+	{ "See https://example.org/a?b=c&d=e#f and ftp://ftp.example.net/pub/.",
+	  0,
+	  "See https://example.org/a?b=c&amp;d=e#f and ftp://ftp.example.net/pub/." },
+	{ "See https://example.org/a?b=c&d=e#f and ftp://ftp.example.net/pub/.",
+	  MAIL_FLAGS,
+	  "See <a href=\"https://example.org/a?b=c&amp;d=e#f\">https://example.org/a?b=c&amp;d=e#f</a> and <a href=\"ftp://ftp.example.net/pub/\">ftp://ftp.example.net/pub/</a>." },
+	{ "See https://example.org/a?b=c&d=e#f and ftp://ftp.example.net/pub/.",
+	  E_TEXT_TO_HTML_PRE | E_TEXT_TO_HTML_CONVERT_URLS | E_TEXT_TO_HTML_CONVERT_ADDRESSES,
+	  "<PRE>See <a href=\"https://example.org/a?b=c&amp;d=e#f\">https://example.org/a?b=c&amp;d=e#f</a> and <a href=\"ftp://ftp.example.net/pub/\">ftp://ftp.example.net/pub/</a>.</PRE>" },
+	{ "See https://example.org/a?b=c&d=e#f and ftp://ftp.example.net/pub/.",
+	  E_TEXT_TO_HTML_CONVERT_NL | E_TEXT_TO_HTML_CITE | E_TEXT_TO_HTML_ESCAPE_8BIT,
+	  "&gt; See https://example.org/a?b=c&amp;d=e#f and ftp://ftp.example.net/pub/." },
+	{ "See https://example.org/a?b=c&d=e#f and ftp://ftp.example.net/pub/.",
+	  E_TEXT_TO_HTML_CONVERT_URLS | E_TEXT_TO_HTML_HIDE_URL_SCHEME,
+	  "See <a href=\"https://example.org/a?b=c&amp;d=e#f\">example.org/a?b=c&amp;d=e#f</a> and <a href=\"ftp://ftp.example.net/pub/\">ftp.example.net/pub/</a>." },
+	{ "Go to www.example.com/path or www.gnome.org!",
+	  0,
+	  "Go to www.example.com/path or www.gnome.org!" },
+	{ "Go to www.example.com/path or www.gnome.org!",
+	  MAIL_FLAGS,
+	  "Go to <a href=\"http://www.example.com/path\">www.example.com/path</a> or <a href=\"http://www.gnome.org\">www.gnome.org</a>!" },
+	{ "Go to www.example.com/path or www.gnome.org!",
+	  E_TEXT_TO_HTML_PRE | E_TEXT_TO_HTML_CONVERT_URLS | E_TEXT_TO_HTML_CONVERT_ADDRESSES,
+	  "<PRE>Go to <a href=\"http://www.example.com/path\">www.example.com/path</a> or <a href=\"http://www.gnome.org\">www.gnome.org</a>!</PRE>" },
+	{ "Go to www.example.com/path or www.gnome.org!",
+	  E_TEXT_TO_HTML_CONVERT_NL | E_TEXT_TO_HTML_CITE | E_TEXT_TO_HTML_ESCAPE_8BIT,
+	  "&gt; Go to www.example.com/path or www.gnome.org!" },
+	{ "Go to www.example.com/path or www.gnome.org!",
+	  E_TEXT_TO_HTML_CONVERT_URLS | E_TEXT_TO_HTML_HIDE_URL_SCHEME,
+	  "Go to <a href=\"http://www.example.com/path\">www.example.com/path</a> or <a href=\"http://www.gnome.org\">www.gnome.org</a>!" },
+	{ "Mail bob@example.com or <alice.smith@mail.example.org>.",
+	  0,
+	  "Mail bob@example.com or &lt;alice.smith@mail.example.org&gt;." },
+	{ "Mail bob@example.com or <alice.smith@mail.example.org>.",
+	  MAIL_FLAGS,
+	  "Mail <a href=\"mailto:bob@example.com\">bob@example.com</a> or &lt;<a href=\"mailto:alice.smith@mail.example.org\">alice.smith@mail.example.org</a>&gt;." },
+	{ "Mail bob@example.com or <alice.smith@mail.example.org>.",
+	  E_TEXT_TO_HTML_PRE | E_TEXT_TO_HTML_CONVERT_URLS | E_TEXT_TO_HTML_CONVERT_ADDRESSES,
+	  "<PRE>Mail <a href=\"mailto:bob@example.com\">bob@example.com</a> or &lt;<a href=\"mailto:alice.smith@mail.example.org\">alice.smith@mail.example.org</a>&gt;.</PRE>" },
+	{ "Mail bob@example.com or <alice.smith@mail.example.org>.",
+	  E_TEXT_TO_HTML_CONVERT_NL | E_TEXT_TO_HTML_CITE | E_TEXT_TO_HTML_ESCAPE_8BIT,
+	  "&gt; Mail bob@example.com or &lt;alice.smith@mail.example.org&gt;." },
+	{ "Mail bob@example.com or <alice.smith@mail.example.org>.",
+	  E_TEXT_TO_HTML_CONVERT_URLS | E_TEXT_TO_HTML_HIDE_URL_SCHEME,
+	  "Mail bob@example.com or &lt;alice.smith@mail.example.org&gt;." },
+	{ "mailto:someone@example.com and news:comp.os.linux",
+	  0,
+	  "mailto:someone@example.com and news:comp.os.linux" },
+	{ "mailto:someone@example.com and news:comp.os.linux",
+	  MAIL_FLAGS,
+	  "<a href=\"mailto:someone@example.com\">mailto:someone@example.com</a> and <a href=\"news:comp.os.linux\">news:comp.os.linux</a>" },
+	{ "mailto:someone@example.com and news:comp.os.linux",
+	  E_TEXT_TO_HTML_PRE | E_TEXT_TO_HTML_CONVERT_URLS | E_TEXT_TO_HTML_CONVERT_ADDRESSES,
+	  "<PRE><a href=\"mailto:someone@example.com\">mailto:someone@example.com</a> and <a href=\"news:comp.os.linux\">news:comp.os.linux</a></PRE>" },
+	{ "mailto:someone@example.com and news:comp.os.linux",
+	  E_TEXT_TO_HTML_CONVERT_NL | E_TEXT_TO_HTML_CITE | E_TEXT_TO_HTML_ESCAPE_8BIT,
+	  "&gt; mailto:someone@example.com and news:comp.os.linux" },
+	{ "mailto:someone@example.com and news:comp.os.linux",
+	  E_TEXT_TO_HTML_CONVERT_URLS | E_TEXT_TO_HTML_HIDE_URL_SCHEME,
+	  "<a href=\"mailto:someone@example.com\">someone@example.com</a> and <a href=\"news:comp.os.linux\">comp.os.linux</a>" },
+	{ "sip:user@host.example.com tel:+1-555-0100 webcal://cal.example.com/x.ics",
+	  0,
+	  "sip:user@host.example.com tel:+1-555-0100 webcal://cal.example.com/x.ics" },
+	{ "sip:user@host.example.com tel:+1-555-0100 webcal://cal.example.com/x.ics",
+	  MAIL_FLAGS,
+	  "<a href=\"sip:user@host.example.com\">sip:user@host.example.com</a> <a href=\"tel:+1-555-0100\">tel:+1-555-0100</a> <a href=\"webcal://cal.example.com/x.ics\">webcal://cal.example.com/x.ics</a>" },
+	{ "sip:user@host.example.com tel:+1-555-0100 webcal://cal.example.com/x.ics",
+	  E_TEXT_TO_HTML_PRE | E_TEXT_TO_HTML_CONVERT_URLS | E_TEXT_TO_HTML_CONVERT_ADDRESSES,
+	  "<PRE><a href=\"sip:user@host.example.com\">sip:user@host.example.com</a> <a href=\"tel:+1-555-0100\">tel:+1-555-0100</a> <a href=\"webcal://cal.example.com/x.ics\">webcal://cal.example.com/x.ics</a></PRE>" },
+	{ "sip:user@host.example.com tel:+1-555-0100 webcal://cal.example.com/x.ics",
+	  E_TEXT_TO_HTML_CONVERT_NL | E_TEXT_TO_HTML_CITE | E_TEXT_TO_HTML_ESCAPE_8BIT,
+	  "&gt; sip:user@host.example.com tel:+1-555-0100 webcal://cal.example.com/x.ics" },
+	{ "sip:user@host.example.com tel:+1-555-0100 webcal://cal.example.com/x.ics",
+	  E_TEXT_TO_HTML_CONVERT_URLS | E_TEXT_TO_HTML_HIDE_URL_SCHEME,
+	  "<a href=\"sip:user@host.example.com\">user@host.example.com</a> <a href=\"tel:+1-555-0100\">+1-555-0100</a> <a href=\"webcal://cal.example.com/x.ics\">cal.example.com/x.ics</a>" },
+	{ "no url: http: or http:// or www. alone, src/www.c",
+	  0,
+	  "no url: http: or http:// or www. alone, src/www.c" },
+	{ "no url: http: or http:// or www. alone, src/www.c",
+	  MAIL_FLAGS,
+	  "no url: http: or http:// or www. alone, src/www.c" },
+	{ "no url: http: or http:// or www. alone, src/www.c",
+	  E_TEXT_TO_HTML_PRE | E_TEXT_TO_HTML_CONVERT_URLS | E_TEXT_TO_HTML_CONVERT_ADDRESSES,
+	  "<PRE>no url: http: or http:// or www. alone, src/www.c</PRE>" },
+	{ "no url: http: or http:// or www. alone, src/www.c",
+	  E_TEXT_TO_HTML_CONVERT_NL | E_TEXT_TO_HTML_CITE | E_TEXT_TO_HTML_ESCAPE_8BIT,
+	  "&gt; no url: http: or http:// or www. alone, src/www.c" },
+	{ "no url: http: or http:// or www. alone, src/www.c",
+	  E_TEXT_TO_HTML_CONVERT_URLS | E_TEXT_TO_HTML_HIDE_URL_SCHEME,
+	  "no url: http: or http:// or www. alone, src/www.c" },
+	{ "foohttp://inside.example.com/word and M@ke money fast @_@",
+	  0,
+	  "foohttp://inside.example.com/word and M@ke money fast @_@" },
+	{ "foohttp://inside.example.com/word and M@ke money fast @_@",
+	  MAIL_FLAGS,
+	  "foo<a href=\"http://inside.example.com/word\">http://inside.example.com/word</a> and M@ke money fast @_@" },
+	{ "foohttp://inside.example.com/word and M@ke money fast @_@",
+	  E_TEXT_TO_HTML_PRE | E_TEXT_TO_HTML_CONVERT_URLS | E_TEXT_TO_HTML_CONVERT_ADDRESSES,
+	  "<PRE>foo<a href=\"http://inside.example.com/word\">http://inside.example.com/word</a> and M@ke money fast @_@</PRE>" },
+	{ "foohttp://inside.example.com/word and M@ke money fast @_@",
+	  E_TEXT_TO_HTML_CONVERT_NL | E_TEXT_TO_HTML_CITE | E_TEXT_TO_HTML_ESCAPE_8BIT,
+	  "&gt; foohttp://inside.example.com/word and M@ke money fast @_@" },
+	{ "foohttp://inside.example.com/word and M@ke money fast @_@",
+	  E_TEXT_TO_HTML_CONVERT_URLS | E_TEXT_TO_HTML_HIDE_URL_SCHEME,
+	  "foo<a href=\"http://inside.example.com/word\">inside.example.com/word</a> and M@ke money fast @_@" },
+	{ "caf\303\251 na\303\257ve \342\202\254 5 \360\237\230\200",
+	  0,
+	  "caf&#233;&#169; na&#239;&#175;ve &#8364;&#172; 5 &#128512" },
+	{ "caf\303\251 na\303\257ve \342\202\254 5 \360\237\230\200",
+	  MAIL_FLAGS,
+	  "caf&#233;&#169; na&#239;&#175;ve &#8364;&#172; 5 &#128512" },
+	{ "caf\303\251 na\303\257ve \342\202\254 5 \360\237\230\200",
+	  E_TEXT_TO_HTML_PRE | E_TEXT_TO_HTML_CONVERT_URLS | E_TEXT_TO_HTML_CONVERT_ADDRESSES,
+	  "<PRE>caf&#233;&#169; na&#239;&#175;ve &#8364;&#172; 5 &#128512" },
+	{ "caf\303\251 na\303\257ve \342\202\254 5 \360\237\230\200",
+	  E_TEXT_TO_HTML_CONVERT_NL | E_TEXT_TO_HTML_CITE | E_TEXT_TO_HTML_ESCAPE_8BIT,
+	  "&gt; caf?? na??ve ?? 5 ??" },
+	{ "caf\303\251 na\303\257ve \342\202\254 5 \360\237\230\200",
+	  E_TEXT_TO_HTML_CONVERT_URLS | E_TEXT_TO_HTML_HIDE_URL_SCHEME,
+	  "caf&#233;&#169; na&#239;&#175;ve &#8364;&#172; 5 &#128512" },
+	{ "latin1 caf\351 and \377 bytes",
+	  0,
+	  "latin1 caf&#38945;nd &#255; bytes" },
+	{ "latin1 caf\351 and \377 bytes",
+	  MAIL_FLAGS,
+	  "latin1 caf&#38945;nd &#255; bytes" },
+	{ "latin1 caf\351 and \377 bytes",
+	  E_TEXT_TO_HTML_PRE | E_TEXT_TO_HTML_CONVERT_URLS | E_TEXT_TO_HTML_CONVERT_ADDRESSES,
+	  "<PRE>latin1 caf&#38945;nd &#255; bytes</PRE>" },
+	{ "latin1 caf\351 and \377 bytes",
+	  E_TEXT_TO_HTML_CONVERT_NL | E_TEXT_TO_HTML_CITE | E_TEXT_TO_HTML_ESCAPE_8BIT,
+	  "&gt; latin1 caf?nd ? bytes" },
+	{ "latin1 caf\351 and \377 bytes",
+	  E_TEXT_TO_HTML_CONVERT_URLS | E_TEXT_TO_HTML_HIDE_URL_SCHEME,
+	  "latin1 caf&#38945;nd &#255; bytes" },
+	{ "control \001 chars \177 and \r\n crlf",
+	  0,
+	  "control &#1; chars \177 and \r\n crlf" },
+	{ "control \001 chars \177 and \r\n crlf",
+	  MAIL_FLAGS,
+	  "control &#1; chars \177 and \r<br>\n&nbsp;crlf" },
+	{ "control \001 chars \177 and \r\n crlf",
+	  E_TEXT_TO_HTML_PRE | E_TEXT_TO_HTML_CONVERT_URLS | E_TEXT_TO_HTML_CONVERT_ADDRESSES,
+	  "<PRE>control &#1; chars \177 and \r\n crlf</PRE>" },
+	{ "control \001 chars \177 and \r\n crlf",
+	  E_TEXT_TO_HTML_CONVERT_NL | E_TEXT_TO_HTML_CITE | E_TEXT_TO_HTML_ESCAPE_8BIT,
+	  "&gt; control ? chars \177 and \r<br>\n&gt;  crlf" },
+	{ "control \001 chars \177 and \r\n crlf",
+	  E_TEXT_TO_HTML_CONVERT_URLS | E_TEXT_TO_HTML_HIDE_URL_SCHEME,
+	  "control &#1; chars \177 and \r\n crlf" },
+	{ "HTTPS://UPPER.EXAMPLE.COM/PATH WWW.UPPER.COM",
+	  0,
+	  "HTTPS://UPPER.EXAMPLE.COM/PATH WWW.UPPER.COM" },
+	{ "HTTPS://UPPER.EXAMPLE.COM/PATH WWW.UPPER.COM",
+	  MAIL_FLAGS,
+	  "<a href=\"HTTPS://UPPER.EXAMPLE.COM/PATH\">HTTPS://UPPER.EXAMPLE.COM/PATH</a> <a href=\"http://WWW.UPPER.COM\">WWW.UPPER.COM</a>" },
+	{ "HTTPS://UPPER.EXAMPLE.COM/PATH WWW.UPPER.COM",
+	  E_TEXT_TO_HTML_PRE | E_TEXT_TO_HTML_CONVERT_URLS | E_TEXT_TO_HTML_CONVERT_ADDRESSES,
+	  "<PRE><a href=\"HTTPS://UPPER.EXAMPLE.COM/PATH\">HTTPS://UPPER.EXAMPLE.COM/PATH</a> <a href=\"http://WWW.UPPER.COM\">WWW.UPPER.COM</a></PRE>" },
+	{ "HTTPS://UPPER.EXAMPLE.COM/PATH WWW.UPPER.COM",
+	  E_TEXT_TO_HTML_CONVERT_NL | E_TEXT_TO_HTML_CITE | E_TEXT_TO_HTML_ESCAPE_8BIT,
+	  "&gt; HTTPS://UPPER.EXAMPLE.COM/PATH WWW.UPPER.COM" },
+	{ "HTTPS://UPPER.EXAMPLE.COM/PATH WWW.UPPER.COM",
+	  E_TEXT_TO_HTML_CONVERT_URLS | E_TEXT_TO_HTML_HIDE_URL_SCHEME,
+	  "<a href=\"HTTPS://UPPER.EXAMPLE.COM/PATH\">UPPER.EXAMPLE.COM/PATH</a> <a href=\"http://WWW.UPPER.COM\">WWW.UPPER.COM</a>" },
+	{ "ASCII art <-- --> \"|\" {braces} [brackets] `tick'",
+	  0,
+	  "ASCII art &lt;-- --&gt; &quot;|&quot; {braces} [brackets] `tick'" },
+	{ "ASCII art <-- --> \"|\" {braces} [brackets] `tick'",
+	  MAIL_FLAGS,
+	  "ASCII art &lt;-- --&gt; &quot;|&quot; {braces} [brackets] `tick'" },
+	{ "ASCII art <-- --> \"|\" {braces} [brackets] `tick'",
+	  E_TEXT_TO_HTML_PRE | E_TEXT_TO_HTML_CONVERT_URLS | E_TEXT_TO_HTML_CONVERT_ADDRESSES,
+	  "<PRE>ASCII art &lt;-- --&gt; &quot;|&quot; {braces} [brackets] `tick'</PRE>" },
+	{ "ASCII art <-- --> \"|\" {braces} [brackets] `tick'",
+	  E_TEXT_TO_HTML_CONVERT_NL | E_TEXT_TO_HTML_CITE | E_TEXT_TO_HTML_ESCAPE_8BIT,
+	  "&gt; ASCII art &lt;-- --&gt; &quot;|&quot; {braces} [brackets] `tick'" },
+	{ "ASCII art <-- --> \"|\" {braces} [brackets] `tick'",
+	  E_TEXT_TO_HTML_CONVERT_URLS | E_TEXT_TO_HTML_HIDE_URL_SCHEME,
+	  "ASCII art &lt;-- --&gt; &quot;|&quot; {braces} [brackets] `tick'" },
+	{ "http://bob@www.foo.com/bar/baz/ \"http://www.foo.com/index.html\"",
+	  0,
+	  "http://bob@www.foo.com/bar/baz/ &quot;http://www.foo.com/index.html&quot;" },
+	{ "http://bob@www.foo.com/bar/baz/ \"http://www.foo.com/index.html\"",
+	  MAIL_FLAGS,
+	  "<a href=\"http://bob@www.foo.com/bar/baz/\">http://bob@www.foo.com/bar/baz/</a> &quot;<a href=\"http://www.foo.com/index.html\">http://www.foo.com/index.html</a>&quot;" },
+	{ "http://bob@www.foo.com/bar/baz/ \"http://www.foo.com/index.html\"",
+	  E_TEXT_TO_HTML_PRE | E_TEXT_TO_HTML_CONVERT_URLS | E_TEXT_TO_HTML_CONVERT_ADDRESSES,
+	  "<PRE><a href=\"http://bob@www.foo.com/bar/baz/\">http://bob@www.foo.com/bar/baz/</a> &quot;<a href=\"http://www.foo.com/index.html\">http://www.foo.com/index.html</a>&quot;</PRE>" },
+	{ "http://bob@www.foo.com/bar/baz/ \"http://www.foo.com/index.html\"",
+	  E_TEXT_TO_HTML_CONVERT_NL | E_TEXT_TO_HTML_CITE | E_TEXT_TO_HTML_ESCAPE_8BIT,
+	  "&gt; http://bob@www.foo.com/bar/baz/ &quot;http://www.foo.com/index.html&quot;" },
+	{ "http://bob@www.foo.com/bar/baz/ \"http://www.foo.com/index.html\"",
+	  E_TEXT_TO_HTML_CONVERT_URLS | E_TEXT_TO_HTML_HIDE_URL_SCHEME,
+	  "<a href=\"http://bob@www.foo.com/bar/baz/\">bob@www.foo.com/bar/baz/</a> &quot;<a href=\"http://www.foo.com/index.html\">www.foo.com/index.html</a>&quot;" },
+	{ "sometimes the text starts with letters which begin schemes: sipping tea, telling tales, newsworthy, fileserver",
+	  0,
+	  "sometimes the text starts with letters which begin schemes: sipping tea, telling tales, newsworthy, fileserver" },
+	{ "sometimes the text starts with letters which begin schemes: sipping tea, telling tales, newsworthy, fileserver",
+	  MAIL_FLAGS,
+	  "sometimes the text starts with letters which begin schemes: sipping tea, telling tales, newsworthy, fileserver" },
+	{ "sometimes the text starts with letters which begin schemes: sipping tea, telling tales, newsworthy, fileserver",
+	  E_TEXT_TO_HTML_PRE | E_TEXT_TO_HTML_CONVERT_URLS | E_TEXT_TO_HTML_CONVERT_ADDRESSES,
+	  "<PRE>sometimes the text starts with letters which begin schemes: sipping tea, telling tales, newsworthy, fileserver</PRE>" },
+	{ "sometimes the text starts with letters which begin schemes: sipping tea, telling tales, newsworthy, fileserver",
+	  E_TEXT_TO_HTML_CONVERT_NL | E_TEXT_TO_HTML_CITE | E_TEXT_TO_HTML_ESCAPE_8BIT,
+	  "&gt; sometimes the text starts with letters which begin schemes: sipping tea, telling tales, newsworthy, fileserver" },
+	{ "sometimes the text starts with letters which begin schemes: sipping tea, telling tales, newsworthy, fileserver",
+	  E_TEXT_TO_HTML_CONVERT_URLS | E_TEXT_TO_HTML_HIDE_URL_SCHEME,
+	  "sometimes the text starts with letters which begin schemes: sipping tea, telling tales, newsworthy, fileserver" },
+};
+
+static void
+test_html_utils_corpus (void)
+{
+	guint ii;
+
+	for (ii = 0; ii < G_N_ELEMENTS (corpus); ii++) {
+		gchar *html;
+
+		html = e_text_to_html_full (corpus[ii].input, corpus[ii].flags, CITATION_COLOR);
+		g_assert_cmpstr (html, ==, corpus[ii].output);
+		g_free (html);
+	}
+}
+
+static gchar *
+test_html_utils_build_document (gsize size)
+{
+	GString *document;
+	guint ii = 0;
+
+	document = g_string_sized_new (size + 1024);
+
+	while (document->len < size) {
+		g_string_append (document, corpus[ii].input);
+		g_string_append_c (document, '\n');
+		ii = (ii + 1) % G_N_ELEMENTS (corpus);
+	}
+
+	return g_string_free (document, FALSE);
+}
+
+static void
+test_html_utils_benchmark (void)
+{
+	const guint flags[] = {
+		0,
+		E_TEXT_TO_HTML_PRE,
+		MAIL_FLAGS
+	};
+	gchar *document;
+	guint ii, jj;
+
+	/* Roughly the size of a big mailing list digest or a log file */
+	document = test_html_utils_build_document (8 * 1024 * 1024);
+
+	for (ii = 0; ii < G_N_ELEMENTS (flags); ii++) {
+		gdouble best = -1.0;
+
+		for (jj = 0; jj < 5; jj++) {
+			gchar *html;
+			gdouble elapsed;
+
+			g_test_timer_start ();
+			html = e_text_to_html_full (document, flags[ii], CITATION_COLOR);
+			elapsed = g_test_timer_elapsed ();
+
+			g_free (html);
+
+			if (best < 0.0 || elapsed < best)
+				best = elapsed;
+		}
+
+		g_test_minimized_result (
+			best, "e_text_to_html_full() with flags 0x%x: %.3f s for %" G_GSIZE_FORMAT " bytes",
+			flags[ii], best, strlen (document));
+	}
+
+	g_free (document);
+}
+
+gint
+main (gint argc,
+      gchar *argv[])
+{
+	g_test_init (&argc, &argv, NULL);
+
+	g_test_add_func ("/EHtmlUtils/Corpus", test_html_utils_corpus);
+
+	/* Run with "-m perf" */
+	if (g_test_perf ())
+		g_test_add_func ("/EHtmlUtils/Benchmark", test_html_utils_benchmark);
+
+	return g_test_run ();
+}
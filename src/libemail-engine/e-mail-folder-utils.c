@@ -375,6 +375,68 @@ exit:
 	return success;
 }
 
+static gboolean
+mail_folder_expunge_vee_folder_sync (CamelVeeFolder *vfolder,
+                                     GCancellable *cancellable,
+                                     GError **error)
+{
+	GList *folders, *link;
+	guint n_folders, ii;
+	GError *first_error = NULL;
+
+	/* Expunge one real folder at a time, not the whole virtual folder
+	 * at once, thus the progress is reported, the operation can be
+	 * cancelled between the folders and the folder locks are released
+	 * after each of them.  Folders expunged before a cancellation stay
+	 * expunged, thus running it again continues with the rest.  A folder
+	 * which fails to expunge, like an offline remote folder, does not
+	 * stop the others; the first error is reported at the end. */
+	folders = camel_vee_folder_ref_folders (vfolder);
+	n_folders = g_list_length (folders);
+
+	for (link = folders, ii = 0; link; link = g_list_next (link), ii++) {
+		CamelFolder *subfolder = link->data;
+		GError *local_error = NULL;
+
+		if (g_cancellable_set_error_if_cancelled (cancellable, &local_error)) {
+			g_clear_error (&first_error);
+			first_error = local_error;
+			break;
+		}
+
+		camel_operation_push_message (
+			cancellable, _("Expunging folder “%s”"),
+			camel_folder_get_display_name (subfolder));
+
+		if (!camel_folder_expunge_sync (subfolder, cancellable, &local_error) && local_error) {
+			if (g_error_matches (local_error, G_IO_ERROR, G_IO_ERROR_CANCELLED)) {
+				camel_operation_pop_message (cancellable);
+				g_clear_error (&first_error);
+				first_error = local_error;
+				break;
+			}
+
+			if (!first_error)
+				first_error = local_error;
+			else
+				g_clear_error (&local_error);
+		}
+
+		camel_operation_pop_message (cancellable);
+
+		camel_operation_progress (cancellable, 100 * (ii + 1) / n_folders);
+	}
+
+	g_list_free_full (folders, g_object_unref);
+
+	if (first_error) {
+		g_propagate_error (error, first_error);
+		return FALSE;
+	}
+
+	return TRUE;
+}
+
 gboolean
 e_mail_folder_expunge_sync (CamelFolder *folder,
                             GCancellable *cancellable,
@@ -426,9 +488,14 @@ e_mail_folder_expunge_sync (CamelFolder *folder,
 		success = mail_folder_expunge_pop3_stores (
 			folder, cancellable, error);
 
-	if (success)
-		success = camel_folder_expunge_sync (
-			folder, cancellable, error);
+	if (success) {
+		if (CAMEL_IS_VEE_FOLDER (folder))
+			success = mail_folder_expunge_vee_folder_sync (
+				CAMEL_VEE_FOLDER (folder), cancellable, error);
+		else
+			success = camel_folder_expunge_sync (
+				folder, cancellable, error);
+	}
 
 exit:
 	g_object_unref (session);
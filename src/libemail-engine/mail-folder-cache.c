@@ -73,8 +73,17 @@ struct _MailFolderCachePrivate {
 
 	GQueue local_folder_uris;
 	GQueue remote_folder_uris;
+
+	/* Plain unread count updates, coalesced per folder URI
+	 * and flushed to the main context at a bounded rate. */
+	GHashTable *pending_updates;	/* gchar *uri ~> UpdateClosure * */
+	GSource *pending_updates_source;
+	GMutex pending_updates_lock;
 };
 
+/* How often coalesced unread count updates are flushed. */
+#define PENDING_UPDATES_INTERVAL_MS 300
+
 enum {
 	PROP_0,
 	PROP_MAIN_CONTEXT,
@@ -87,6 +96,8 @@ enum {
 	FOLDER_RENAMED,
 	FOLDER_UNREAD_UPDATED,
 	FOLDER_CHANGED,
+	FOLDER_UNREAD_BATCH_STARTED,
+	FOLDER_UNREAD_BATCH_FINISHED,
 	LAST_SIGNAL
 };
 
@@ -787,6 +798,117 @@ mail_folder_cache_update_idle_cb (gpointer user_data)
 	return FALSE;
 }
 
+static void
+mail_folder_cache_drop_pending_update (MailFolderCache *cache,
+                                       CamelStore *store,
+                                       const gchar *full_name)
+{
+	gchar *folder_uri;
+
+	if (full_name == NULL)
+		return;
+
+	folder_uri = e_mail_folder_uri_build (store, full_name);
+
+	g_mutex_lock (&cache->priv->pending_updates_lock);
+	g_hash_table_remove (cache->priv->pending_updates, folder_uri);
+	g_mutex_unlock (&cache->priv->pending_updates_lock);
+
+	g_free (folder_uri);
+}
+
+static gboolean
+mail_folder_cache_flush_pending_updates_cb (gpointer user_data)
+{
+	MailFolderCache *cache;
+	GHashTable *pending_updates;
+	GList *closures, *link;
+	gboolean is_batch;
+
+	cache = g_weak_ref_get (user_data);
+	if (cache == NULL)
+		return FALSE;
+
+	g_mutex_lock (&cache->priv->pending_updates_lock);
+
+	pending_updates = cache->priv->pending_updates;
+	cache->priv->pending_updates = g_hash_table_new_full (
+		(GHashFunc) g_str_hash,
+		(GEqualFunc) g_str_equal,
+		(GDestroyNotify) g_free,
+		(GDestroyNotify) update_closure_free);
+
+	g_source_unref (cache->priv->pending_updates_source);
+	cache->priv->pending_updates_source = NULL;
+
+	g_mutex_unlock (&cache->priv->pending_updates_lock);
+
+	closures = g_hash_table_get_values (pending_updates);
+	is_batch = closures != NULL && closures->next != NULL;
+
+	/* Let listeners, like the folder tree model, apply
+	 * all the counts at once instead of one by one. */
+	if (is_batch)
+		g_signal_emit (cache, signals[FOLDER_UNREAD_BATCH_STARTED], 0);
+
+	for (link = closures; link != NULL; link = g_list_next (link))
+		mail_folder_cache_update_idle_cb (link->data);
+
+	if (is_batch)
+		g_signal_emit (cache, signals[FOLDER_UNREAD_BATCH_FINISHED], 0);
+
+	g_list_free (closures);
+	g_hash_table_destroy (pending_updates);
+	g_object_unref (cache);
+
+	return FALSE;
+}
+
+/* Queues a plain unread count update, which replaces any not yet
+ * flushed update for the same folder.  All queued updates are emitted
+ * together from the main context at most every PENDING_UPDATES_INTERVAL_MS,
+ * which avoids flooding the main loop during a sync of many folders
+ * or a bulk flag change.  Takes ownership of the @closure. */
+static void
+mail_folder_cache_queue_update (UpdateClosure *closure)
+{
+	MailFolderCache *cache;
+
+	g_return_if_fail (closure != NULL);
+
+	cache = g_weak_ref_get (&closure->cache);
+	if (cache == NULL) {
+		update_closure_free (closure);
+		g_return_if_reached ();
+	}
+
+	g_mutex_lock (&cache->priv->pending_updates_lock);
+
+	g_hash_table_insert (
+		cache->priv->pending_updates,
+		e_mail_folder_uri_build (closure->store, closure->full_name),
+		closure);
+
+	if (cache->priv->pending_updates_source == NULL) {
+		GSource *timeout_source;
+
+		timeout_source = g_timeout_source_new (PENDING_UPDATES_INTERVAL_MS);
+		g_source_set_name (timeout_source, G_STRFUNC);
+		g_source_set_callback (
+			timeout_source,
+			mail_folder_cache_flush_pending_updates_cb,
+			e_weak_ref_new (cache),
+			(GDestroyNotify) e_weak_ref_free);
+		g_source_attach (timeout_source, cache->priv->main_context);
+
+		cache->priv->pending_updates_source = timeout_source;
+	}
+
+	g_mutex_unlock (&cache->priv->pending_updates_lock);
+
+	g_object_unref (cache);
+}
+
 static void
 mail_folder_cache_submit_update (UpdateClosure *closure)
 {
@@ -799,6 +921,14 @@ mail_folder_cache_submit_update (UpdateClosure *closure)
 	cache = g_weak_ref_get (&closure->cache);
 	g_return_if_fail (cache != NULL);
 
+	/* Any coalesced update for the same folder is older than
+	 * this one, thus do not let it overwrite it on flush. */
+	mail_folder_cache_drop_pending_update (
+		cache, closure->store, closure->full_name);
+	if (closure->oldfull != NULL)
+		mail_folder_cache_drop_pending_update (
+			cache, closure->store, closure->oldfull);
+
 	main_context = mail_folder_cache_ref_main_context (cache);
 
 	idle_source = g_idle_source_new ();
@@ -923,7 +1053,12 @@ update_1folder (MailFolderCache *cache,
 		up->msg_sender = g_strdup (msg_sender);
 		up->msg_subject = g_strdup (msg_subject);
 
-		mail_folder_cache_submit_update (up);
+		/* New messages are reported right away, for notifications;
+		 * plain count changes can wait for the next batch. */
+		if (new_messages == 0)
+			mail_folder_cache_queue_update (up);
+		else
+			mail_folder_cache_submit_update (up);
 	}
 }
 
@@ -1530,6 +1665,15 @@ mail_folder_cache_dispose (GObject *object)
 
 	g_hash_table_remove_all (priv->store_info_ht);
 
+	g_mutex_lock (&priv->pending_updates_lock);
+	if (priv->pending_updates_source != NULL) {
+		g_source_destroy (priv->pending_updates_source);
+		g_source_unref (priv->pending_updates_source);
+		priv->pending_updates_source = NULL;
+	}
+	g_hash_table_remove_all (priv->pending_updates);
+	g_mutex_unlock (&priv->pending_updates_lock);
+
 	/* Chain up to parent's dispose() method. */
 	G_OBJECT_CLASS (mail_folder_cache_parent_class)->dispose (object);
 }
@@ -1546,6 +1690,9 @@ mail_folder_cache_finalize (GObject *object)
 	g_hash_table_destroy (priv->store_info_ht);
 	g_mutex_clear (&priv->store_info_ht_lock);
 
+	g_hash_table_destroy (priv->pending_updates);
+	g_mutex_clear (&priv->pending_updates_lock);
+
 	while (!g_queue_is_empty (&priv->local_folder_uris))
 		g_free (g_queue_pop_head (&priv->local_folder_uris));
 
@@ -1857,6 +2004,38 @@ mail_folder_cache_class_init (MailFolderCacheClass *class)
 		G_TYPE_STRING,
 		G_TYPE_STRING,
 		G_TYPE_STRING);
+
+	/**
+	 * MailFolderCache::folder-unread-batch-started
+	 *
+	 * Emitted before a batch of coalesced MailFolderCache::folder-unread-updated
+	 * signals. It is always followed by MailFolderCache::folder-unread-batch-finished.
+	 *
+	 * Since: 3.30
+	 **/
+	signals[FOLDER_UNREAD_BATCH_STARTED] = g_signal_new (
+		"folder-unread-batch-started",
+		G_OBJECT_CLASS_TYPE (object_class),
+		G_SIGNAL_RUN_FIRST,
+		G_STRUCT_OFFSET (MailFolderCacheClass, folder_unread_batch_started),
+		NULL, NULL, NULL,
+		G_TYPE_NONE, 0);
+
+	/**
+	 * MailFolderCache::folder-unread-batch-finished
+	 *
+	 * Emitted after the last MailFolderCache::folder-unread-updated signal
+	 * of a batch started with MailFolderCache::folder-unread-batch-started.
+	 *
+	 * Since: 3.30
+	 **/
+	signals[FOLDER_UNREAD_BATCH_FINISHED] = g_signal_new (
+		"folder-unread-batch-finished",
+		G_OBJECT_CLASS_TYPE (object_class),
+		G_SIGNAL_RUN_FIRST,
+		G_STRUCT_OFFSET (MailFolderCacheClass, folder_unread_batch_finished),
+		NULL, NULL, NULL,
+		G_TYPE_NONE, 0);
 }
 
 static void
@@ -1881,6 +2060,13 @@ mail_folder_cache_init (MailFolderCache *cache)
 
 	g_queue_init (&cache->priv->local_folder_uris);
 	g_queue_init (&cache->priv->remote_folder_uris);
+
+	cache->priv->pending_updates = g_hash_table_new_full (
+		(GHashFunc) g_str_hash,
+		(GEqualFunc) g_str_equal,
+		(GDestroyNotify) g_free,
+		(GDestroyNotify) update_closure_free);
+	g_mutex_init (&cache->priv->pending_updates_lock);
 }
 
 MailFolderCache *
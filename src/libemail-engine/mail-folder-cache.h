@@ -95,6 +95,10 @@ struct _MailFolderCacheClass {
 						 const gchar *msg_uid,
 						 const gchar *msg_sender,
 						 const gchar *msg_subject);
+	void		(*folder_unread_batch_started)
+						(MailFolderCache *cache);
+	void		(*folder_unread_batch_finished)
+						(MailFolderCache *cache);
 };
 
 GType		mail_folder_cache_get_type	(void) G_GNUC_CONST;
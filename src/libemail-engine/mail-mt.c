@@ -96,7 +96,7 @@ mail_msg_new_with_cancellable (MailMsgInfo *info,
 {
 	MailMsg *msg;
 
-	g_mutex_lock (&mail_msg_lock);
+	e_trace_mutex_lock (&mail_msg_lock);
 
 	msg = g_slice_alloc0 (info->size);
 	msg->info = info;
@@ -164,12 +164,19 @@ mail_msg_free (MailMsg *mail_msg)
 	if (free_activity)
 		free_activity (mail_msg->cancellable);
 
+	/* Also closes operations which never ran; the op is NULL,
+	 * thus this is a no-op, when tracing is disabled */
+	e_trace_op_finish (mail_msg->trace_op);
+
 	if (mail_msg->cancellable != NULL)
 		g_object_unref (mail_msg->cancellable);
 
 	if (mail_msg->error != NULL)
 		g_error_free (mail_msg->error);
 
+	g_clear_object (&mail_msg->service);
+	g_clear_object (&mail_msg->other_service);
+
 	g_slice_free1 (mail_msg->info->size, mail_msg);
 
 	return FALSE;
@@ -208,7 +215,7 @@ mail_msg_unref (gpointer msg)
 		if (mail_msg->info->free)
 			mail_msg->info->free (mail_msg);
 
-		g_mutex_lock (&mail_msg_lock);
+		e_trace_mutex_lock (&mail_msg_lock);
 
 		g_hash_table_remove (
 			mail_msg_active_table,
@@ -226,6 +233,65 @@ mail_msg_unref (gpointer msg)
 	}
 }
 
+/* Can be called only before the message is pushed */
+void
+mail_msg_set_priority (gpointer msg,
+                       gint priority)
+{
+	MailMsg *mail_msg = msg;
+
+	g_return_if_fail (mail_msg != NULL);
+
+	mail_msg->priority = priority;
+}
+
+/* Sets the lane of the message for mail_msg_fast_ordered_push() and
+ * mail_msg_slow_ordered_push(). Messages of different services do not
+ * wait for each other; messages without a service are ordered against
+ * each other only. Can be called only before the message is pushed. */
+void
+mail_msg_set_service (gpointer msg,
+                      CamelService *service)
+{
+	MailMsg *mail_msg = msg;
+
+	g_return_if_fail (mail_msg != NULL);
+
+	if (service)
+		g_return_if_fail (CAMEL_IS_SERVICE (service));
+
+	if (mail_msg->service == service)
+		return;
+
+	g_clear_object (&mail_msg->service);
+
+	if (service)
+		mail_msg->service = g_object_ref (service);
+}
+
+/* Sets the second lane of the message, like the destination account
+ * of a transfer; the message waits for both lanes and blocks them both
+ * while it runs. Can be called only before the message is pushed. */
+void
+mail_msg_set_other_service (gpointer msg,
+                            CamelService *other_service)
+{
+	MailMsg *mail_msg = msg;
+
+	g_return_if_fail (mail_msg != NULL);
+
+	if (other_service)
+		g_return_if_fail (CAMEL_IS_SERVICE (other_service));
+
+	if (mail_msg->other_service == other_service)
+		return;
+
+	g_clear_object (&mail_msg->other_service);
+
+	if (other_service)
+		mail_msg->other_service = g_object_ref (other_service);
+}
+
 void
 mail_msg_check_error (gpointer msg)
 {
@@ -276,7 +342,7 @@ mail_msg_cancel (guint msgid)
 	MailMsg *msg;
 	GCancellable *cancellable = NULL;
 
-	g_mutex_lock (&mail_msg_lock);
+	e_trace_mutex_lock (&mail_msg_lock);
 
 	msg = g_hash_table_lookup (
 		mail_msg_active_table, GINT_TO_POINTER (msgid));
@@ -304,7 +370,7 @@ mail_msg_active (void)
 {
 	gboolean active;
 
-	g_mutex_lock (&mail_msg_lock);
+	e_trace_mutex_lock (&mail_msg_lock);
 	active = g_hash_table_size (mail_msg_active_table) > 0;
 	g_mutex_unlock (&mail_msg_lock);
 
@@ -341,8 +407,11 @@ mail_msg_idle_cb (void)
 			(GSourceFunc) mail_msg_submit,
 			g_object_ref (msg->cancellable),
 			(GDestroyNotify) g_object_unref);
+		e_trace_op_start (msg->trace_op);
 		if (msg->info->exec != NULL)
 			msg->info->exec (msg, cancellable, &msg->error);
+		e_trace_op_finish (msg->trace_op);
+		msg->trace_op = NULL;
 		if (msg->info->done != NULL)
 			msg->info->done (msg);
 		mail_msg_unref (msg);
@@ -377,9 +446,14 @@ mail_msg_proxy (MailMsg *msg)
 		g_object_ref (msg->cancellable),
 		(GDestroyNotify) g_object_unref);
 
+	e_trace_op_start (msg->trace_op);
+
 	if (msg->info->exec != NULL)
 		msg->info->exec (msg, cancellable, &msg->error);
 
+	e_trace_op_finish (msg->trace_op);
+	msg->trace_op = NULL;
+
 	if (msg->info->desc != NULL)
 		camel_operation_pop_message (cancellable);
 
@@ -407,6 +481,23 @@ mail_msg_init (void)
 	main_thread = g_thread_self ();
 }
 
+static void
+mail_msg_trace_queued (MailMsg *msg,
+                       const gchar *category)
+{
+	gchar *desc = NULL;
+
+	if (!e_trace_is_enabled () || msg->trace_op)
+		return;
+
+	if (msg->info->desc)
+		desc = msg->info->desc (msg);
+
+	msg->trace_op = e_trace_op_new (category, desc ? desc : "MailMsg");
+
+	g_free (desc);
+}
+
 static gint
 mail_msg_compare (const MailMsg *msg1,
                   const MailMsg *msg2)
@@ -414,8 +505,13 @@ mail_msg_compare (const MailMsg *msg1,
 	gint priority1 = msg1->priority;
 	gint priority2 = msg2->priority;
 
-	if (priority1 == priority2)
-		return 0;
+	if (priority1 == priority2) {
+		/* Keep the order in which the messages were created */
+		if (msg1->seq == msg2->seq)
+			return 0;
+
+		return (msg1->seq < msg2->seq) ? -1 : 1;
+	}
 
 	return (priority1 < priority2) ? 1 : -1;
 }
@@ -435,9 +531,143 @@ create_thread_pool (gpointer data)
 	return thread_pool;
 }
 
+/* The ordered messages are queued in lanes, one lane per CamelService.
+ * A message is put into the thread pool only when all its lanes, one, or
+ * two for a transfer between accounts, are idle, and it takes them all
+ * at once, thus the messages of one lane are executed one after another,
+ * while any idle thread can run a message of other lanes. A message never
+ * holds one lane while waiting for another, thus the lanes cannot deadlock. */
+
+#define MAIL_MSG_ORDERED_MAX_THREADS 4
+
+typedef struct _MailMsgScheduler {
+	GMutex lock;
+	GThreadPool *thread_pool;
+	GHashTable *busy_lanes;	/* CamelService *, lanes with a running message */
+	GQueue waiting;		/* MailMsg *, sorted by mail_msg_compare() */
+} MailMsgScheduler;
+
+static gboolean
+mail_msg_lanes_contain (GHashTable *lanes,
+                        MailMsg *msg)
+{
+	return g_hash_table_contains (lanes, msg->service) ||
+		(msg->other_service && g_hash_table_contains (lanes, msg->other_service));
+}
+
+static void
+mail_msg_lanes_add (GHashTable *lanes,
+                    MailMsg *msg)
+{
+	g_hash_table_add (lanes, msg->service);
+
+	if (msg->other_service)
+		g_hash_table_add (lanes, msg->other_service);
+}
+
+/* Starts the waiting messages whose lanes are idle. A message which has
+ * to wait blocks its lanes for the later messages too, which keeps the order
+ * within each lane. Expects the scheduler->lock being held. */
+static void
+mail_msg_scheduler_run_waiting (MailMsgScheduler *scheduler)
+{
+	GHashTable *blocked_lanes;
+	GList *link;
+
+	if (g_queue_is_empty (&scheduler->waiting))
+		return;
+
+	blocked_lanes = g_hash_table_new (g_direct_hash, g_direct_equal);
+
+	link = g_queue_peek_head_link (&scheduler->waiting);
+	while (link) {
+		MailMsg *msg = link->data;
+		GList *next = g_list_next (link);
+
+		if (mail_msg_lanes_contain (scheduler->busy_lanes, msg) ||
+		    mail_msg_lanes_contain (blocked_lanes, msg)) {
+			mail_msg_lanes_add (blocked_lanes, msg);
+		} else {
+			g_queue_delete_link (&scheduler->waiting, link);
+			mail_msg_lanes_add (scheduler->busy_lanes, msg);
+			g_thread_pool_push (scheduler->thread_pool, msg, NULL);
+		}
+
+		link = next;
+	}
+
+	g_hash_table_destroy (blocked_lanes);
+}
+
+static void
+mail_msg_ordered_proxy (MailMsg *msg,
+                        MailMsgScheduler *scheduler)
+{
+	CamelService *service, *other_service;
+
+	/* The 'msg' can be freed after the proxy, while the services
+	 * are needed to release the lanes. */
+	service = msg->service ? g_object_ref (msg->service) : NULL;
+	other_service = msg->other_service ? g_object_ref (msg->other_service) : NULL;
+
+	mail_msg_proxy (msg);
+
+	e_trace_mutex_lock (&scheduler->lock);
+
+	g_warn_if_fail (g_hash_table_remove (scheduler->busy_lanes, service));
+
+	if (other_service)
+		g_hash_table_remove (scheduler->busy_lanes, other_service);
+
+	mail_msg_scheduler_run_waiting (scheduler);
+
+	g_mutex_unlock (&scheduler->lock);
+
+	g_clear_object (&service);
+	g_clear_object (&other_service);
+}
+
+static gpointer
+create_scheduler (gpointer data)
+{
+	MailMsgScheduler *scheduler;
+
+	/* once created, run forever */
+	scheduler = g_new0 (MailMsgScheduler, 1);
+	g_mutex_init (&scheduler->lock);
+	scheduler->busy_lanes = g_hash_table_new (g_direct_hash, g_direct_equal);
+	g_queue_init (&scheduler->waiting);
+	scheduler->thread_pool = g_thread_pool_new (
+		(GFunc) mail_msg_ordered_proxy, scheduler, GPOINTER_TO_INT (data), FALSE, NULL);
+	g_thread_pool_set_sort_function (
+		scheduler->thread_pool, (GCompareDataFunc) mail_msg_compare, NULL);
+
+	return scheduler;
+}
+
+static void
+mail_msg_scheduler_push (MailMsgScheduler *scheduler,
+                         MailMsg *msg)
+{
+	/* A single lane is enough when both are the same */
+	if (msg->other_service == msg->service)
+		g_clear_object (&msg->other_service);
+
+	e_trace_mutex_lock (&scheduler->lock);
+
+	/* Interactive messages go before the background ones */
+	g_queue_insert_sorted (&scheduler->waiting, msg, (GCompareDataFunc) mail_msg_compare, NULL);
+
+	mail_msg_scheduler_run_waiting (scheduler);
+
+	g_mutex_unlock (&scheduler->lock);
+}
+
 void
 mail_msg_main_loop_push (gpointer msg)
 {
+	mail_msg_trace_queued (msg, "mail-msg-main-loop");
+
 	g_async_queue_push_sorted (
 		main_loop_queue, msg,
 		(GCompareDataFunc) mail_msg_compare, NULL);
@@ -458,6 +688,8 @@ mail_msg_unordered_push (gpointer msg)
 
 	g_once (&once, (GThreadFunc) create_thread_pool, GINT_TO_POINTER (10));
 
+	mail_msg_trace_queued (msg, "mail-msg-unordered");
+
 	g_thread_pool_push ((GThreadPool *) once.retval, msg, NULL);
 }
 
@@ -466,9 +698,11 @@ mail_msg_fast_ordered_push (gpointer msg)
 {
 	static GOnce once = G_ONCE_INIT;
 
-	g_once (&once, (GThreadFunc) create_thread_pool, GINT_TO_POINTER (1));
+	g_once (&once, (GThreadFunc) create_scheduler, GINT_TO_POINTER (MAIL_MSG_ORDERED_MAX_THREADS));
 
-	g_thread_pool_push ((GThreadPool *) once.retval, msg, NULL);
+	mail_msg_trace_queued (msg, "mail-msg-fast-ordered");
+
+	mail_msg_scheduler_push ((MailMsgScheduler *) once.retval, msg);
 }
 
 void
@@ -476,9 +710,11 @@ mail_msg_slow_ordered_push (gpointer msg)
 {
 	static GOnce once = G_ONCE_INIT;
 
-	g_once (&once, (GThreadFunc) create_thread_pool, GINT_TO_POINTER (1));
+	g_once (&once, (GThreadFunc) create_scheduler, GINT_TO_POINTER (MAIL_MSG_ORDERED_MAX_THREADS));
 
-	g_thread_pool_push ((GThreadPool *) once.retval, msg, NULL);
+	mail_msg_trace_queued (msg, "mail-msg-slow-ordered");
+
+	mail_msg_scheduler_push ((MailMsgScheduler *) once.retval, msg);
 }
 
 gboolean
@@ -52,6 +52,11 @@ typedef void    (*MailMsgAlertErrorFunc)	(GCancellable *cancellable,
 typedef EAlertSink *
 		(*MailMsgGetAlertSinkFunc)	(void);
 
+/* Higher priority messages are executed first */
+#define MAIL_MSG_PRIORITY_BACKGROUND	(-100)
+#define MAIL_MSG_PRIORITY_DEFAULT	0
+#define MAIL_MSG_PRIORITY_INTERACTIVE	100
+
 struct _MailMsg {
 	MailMsgInfo *info;
 	volatile gint ref_count;
@@ -59,6 +64,9 @@ struct _MailMsg {
 	gint priority;			/* priority (default = 0) */
 	GCancellable *cancellable;
 	GError *error;			/* up to the caller to use this */
+	CamelService *service;		/* ordering lane, set by mail_msg_set_service() */
+	CamelService *other_service;	/* second lane, set by mail_msg_set_other_service() */
+	ETraceOp *trace_op;		/* set only when tracing is enabled */
 };
 
 struct _MailMsgInfo {
@@ -91,10 +99,15 @@ gpointer mail_msg_new_with_cancellable (MailMsgInfo *info,
 gpointer mail_msg_ref (gpointer msg);
 void mail_msg_unref (gpointer msg);
 void mail_msg_check_error (gpointer msg);
+void mail_msg_set_priority (gpointer msg, gint priority);
+void mail_msg_set_service (gpointer msg, CamelService *service);
+void mail_msg_set_other_service (gpointer msg, CamelService *other_service);
 void mail_msg_cancel (guint msgid);
 gboolean mail_msg_active (void);
 
-/* dispatch a message */
+/* dispatch a message; the ordered messages are ordered only against
+ * the messages of the same service, see mail_msg_set_service()
+ * and mail_msg_set_other_service() */
 void mail_msg_main_loop_push (gpointer msg);
 void mail_msg_unordered_push (gpointer msg);
 void mail_msg_fast_ordered_push (gpointer msg);
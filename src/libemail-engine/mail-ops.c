@@ -568,70 +568,143 @@ static void	report_status		(struct _send_queue_msg *m,
 					 const gchar *desc,
 					 ...);
 
-/* send 1 message to a specific transport */
+/* How many messages can be sent at once; one transport
+ * still sends only one message at a time. */
+#define MAX_SENDING_THREADS 3
+
+typedef struct _SendQueueRun {
+	struct _send_queue_msg *m;
+	GCancellable *cancellable;
+
+	GMutex lock;
+	GCond cond;
+
+	/* Appends sent messages to the Sent folder, one at a time */
+	GThreadPool *store_pool;
+
+	/* gchar *transport_uid ~> GQueue { SendItem * }, the messages
+	   waiting for the transport, in the order of the Outbox */
+	GHashTable *busy_transports;
+
+	/* SendItem *, processed by send_queue_exec() */
+	GQueue finished_items;
+} SendQueueRun;
+
+typedef struct _SendItem {
+	SendQueueRun *run;
+	gchar *uid;
+
+	CamelMimeMessage *message;
+	CamelService *service;
+	CamelProvider *provider;
+	CamelNameValueArray *xev_headers;
+	gboolean sent_message_saved;
+
+	GError *error;
+} SendItem;
+
 static void
-mail_send_message (struct _send_queue_msg *m,
-                   CamelFolder *queue,
-                   const gchar *uid,
-                   CamelFilterDriver *driver,
-                   GCancellable *cancellable,
-                   GError **error)
+send_item_free (SendItem *item)
+{
+	if (!item)
+		return;
+
+	g_free (item->uid);
+	g_clear_object (&item->message);
+	g_clear_object (&item->service);
+	if (item->xev_headers)
+		camel_name_value_array_free (item->xev_headers);
+	g_clear_error (&item->error);
+
+	g_slice_free (SendItem, item);
+}
+
+/* finds the transport to send the message with; the message itself
+ * is not kept, it's loaded again once the transport is ready for it */
+static gboolean
+mail_send_message_resolve_transport (SendQueueRun *run,
+                                     SendItem *item,
+                                     GError **error)
 {
-	CamelService *service;
-	const CamelInternetAddress *iaddr;
-	CamelAddress *from, *recipients;
-	CamelMessageInfo *info = NULL;
-	CamelProvider *provider = NULL;
-	const gchar *resent_from;
-	CamelFolder *folder = NULL;
-	GString *err = NULL;
-	CamelNameValueArray *xev_headers = NULL;
 	CamelMimeMessage *message;
-	gint i;
-	guint jj, len;
-	GError *local_error = NULL;
-	gboolean did_connect = FALSE;
-	gboolean sent_message_saved = FALSE;
 
 	message = camel_folder_get_message_sync (
-		queue, uid, cancellable, error);
+		run->m->queue, item->uid, run->cancellable, error);
 	if (!message)
-		return;
-
-	camel_medium_set_header (CAMEL_MEDIUM (message), "User-Agent", USER_AGENT);
+		return FALSE;
 
 	/* Do this before removing "X-Evolution" headers. */
-	service = e_mail_session_ref_transport_for_message (
-		m->session, message);
-	if (service != NULL)
-		provider = camel_service_get_provider (service);
+	item->service = e_mail_session_ref_transport_for_message (
+		run->m->session, message);
+	if (item->service != NULL)
+		item->provider = camel_service_get_provider (item->service);
+
+	g_object_unref (message);
+
+	return TRUE;
+}
+
+/* loads the message right before it's sent */
+static gboolean
+mail_send_message_prepare (SendQueueRun *run,
+                           SendItem *item,
+                           GError **error)
+{
+	item->message = camel_folder_get_message_sync (
+		run->m->queue, item->uid, run->cancellable, error);
+	if (!item->message)
+		return FALSE;
+
+	camel_medium_set_header (CAMEL_MEDIUM (item->message), "User-Agent", USER_AGENT);
+
+	return TRUE;
+}
+
+/* sends the message through its transport; returns whether the message
+ * should be stored, it's not when it failed or was silently skipped */
+static gboolean
+mail_send_message_transport (SendQueueRun *run,
+                             SendItem *item,
+                             GError **error)
+{
+	struct _send_queue_msg *m = run->m;
+	GCancellable *cancellable = run->cancellable;
+	CamelService *service = item->service;
+	CamelProvider *provider = item->provider;
+	const CamelInternetAddress *iaddr;
+	CamelAddress *from, *recipients;
+	const gchar *resent_from;
+	gint i;
+	GError *local_error = NULL;
+	gboolean did_connect = FALSE;
+	gboolean success = TRUE;
 
 	if (CAMEL_IS_TRANSPORT (service)) {
 		const gchar *tuid;
 
 		/* Let the dialog know the right account it is using. */
 		tuid = camel_service_get_uid (service);
+
+		g_mutex_lock (&run->lock);
 		report_status (m, CAMEL_FILTER_STATUS_ACTION, 0, tuid);
+		g_mutex_unlock (&run->lock);
 	}
 
 	if (service && !e_mail_session_mark_service_used_sync (m->session, service, cancellable)) {
 		g_warn_if_fail (g_cancellable_set_error_if_cancelled (cancellable, error));
-		g_clear_object (&service);
-		g_clear_object (&message);
-		return;
+		return FALSE;
 	}
 
-	err = g_string_new ("");
-	xev_headers = mail_tool_remove_xevolution_headers (message);
+	item->xev_headers = mail_tool_remove_xevolution_headers (item->message);
 
 	/* Check for email sending */
 	from = (CamelAddress *) camel_internet_address_new ();
 	resent_from = camel_medium_get_header (
-		CAMEL_MEDIUM (message), "Resent-From");
+		CAMEL_MEDIUM (item->message), "Resent-From");
 	if (resent_from != NULL) {
 		camel_address_decode (from, resent_from);
 	} else {
-		iaddr = camel_mime_message_get_from (message);
+		iaddr = camel_mime_message_get_from (item->message);
 		camel_address_copy (from, CAMEL_ADDRESS (iaddr));
 	}
 
@@ -643,7 +716,7 @@ mail_send_message (struct _send_queue_msg *m,
 			type = resent_recipients[i];
 		else
 			type = normal_recipients[i];
-		iaddr = camel_mime_message_get_recipients (message, type);
+		iaddr = camel_mime_message_get_recipients (item->message, type);
 		camel_address_cat (recipients, CAMEL_ADDRESS (iaddr));
 	}
 
@@ -651,6 +724,7 @@ mail_send_message (struct _send_queue_msg *m,
 		if (provider && (provider->flags & CAMEL_PROVIDER_IS_REMOTE) != 0 &&
 		    !camel_session_get_online (CAMEL_SESSION (m->session))) {
 			/* silently ignore */
+			success = FALSE;
 			goto exit;
 		}
 		if (camel_service_get_connection_status (service) != CAMEL_SERVICE_CONNECTED) {
@@ -669,8 +743,10 @@ mail_send_message (struct _send_queue_msg *m,
 				g_object_unref (source);
 			}
 
-			if (!camel_service_connect_sync (service, cancellable, error))
+			if (!camel_service_connect_sync (service, cancellable, &local_error)) {
+				success = FALSE;
 				goto exit;
+			}
 
 			did_connect = TRUE;
 		}
@@ -679,23 +755,72 @@ mail_send_message (struct _send_queue_msg *m,
 		em_utils_expand_groups (CAMEL_INTERNET_ADDRESS (recipients));
 
 		if (!camel_transport_send_to_sync (
-			CAMEL_TRANSPORT (service), message,
-			from, recipients, &sent_message_saved, cancellable, error))
+			CAMEL_TRANSPORT (service), item->message,
+			from, recipients, &item->sent_message_saved,
+			cancellable, &local_error)) {
+			success = FALSE;
 			goto exit;
+		}
+	}
+
+exit:
+	if (did_connect) {
+		/* Disconnect regardless of error or cancellation,
+		 * but be mindful of these conditions when calling
+		 * camel_service_disconnect_sync(). The message is
+		 * sent at this point, thus a failure to disconnect
+		 * cleanly is not reported as a failure to send it. */
+		if (g_cancellable_is_cancelled (cancellable)) {
+			camel_service_disconnect_sync (service, FALSE, NULL, NULL);
+		} else if (local_error != NULL) {
+			camel_service_disconnect_sync (service, FALSE, cancellable, NULL);
+		} else {
+			camel_service_disconnect_sync (service, TRUE, cancellable, NULL);
+		}
 	}
 
+	if (service)
+		e_mail_session_unmark_service_used (m->session, service);
+
+	if (local_error != NULL)
+		g_propagate_error (error, local_error);
+
+	g_object_unref (recipients);
+	g_object_unref (from);
+
+	return success;
+}
+
+/* posts, filters and stores the sent message, then removes it from the queue */
+static void
+mail_send_message_store (SendQueueRun *run,
+                         SendItem *item,
+                         GError **error)
+{
+	struct _send_queue_msg *m = run->m;
+	GCancellable *cancellable = run->cancellable;
+	CamelMimeMessage *message = item->message;
+	CamelProvider *provider = item->provider;
+	CamelMessageInfo *info = NULL;
+	CamelFolder *folder = NULL;
+	GString *err = NULL;
+	guint jj, len;
+	GError *local_error = NULL;
+
+	err = g_string_new ("");
+
 	/* Now check for posting, failures are ignored */
 	info = camel_message_info_new (NULL);
 	camel_message_info_set_size (info, camel_data_wrapper_calculate_size_sync (CAMEL_DATA_WRAPPER (message), cancellable, NULL));
 	camel_message_info_set_flags (info, CAMEL_MESSAGE_SEEN |
 		(camel_mime_message_has_attachment (message) ? CAMEL_MESSAGE_ATTACHMENTS : 0), ~0);
 
-	len = camel_name_value_array_get_length (xev_headers);
+	len = camel_name_value_array_get_length (item->xev_headers);
 	for (jj = 0; jj < len && !local_error; jj++) {
 		const gchar *header_name = NULL, *header_value = NULL;
 		gchar *uri;
 
-		if (!camel_name_value_array_get (xev_headers, jj, &header_name, &header_value) ||
+		if (!camel_name_value_array_get (item->xev_headers, jj, &header_name, &header_value) ||
 		    !header_name ||
 		    g_ascii_strcasecmp (header_name, "X-Evolution-PostTo") != 0)
 			continue;
@@ -718,11 +843,11 @@ mail_send_message (struct _send_queue_msg *m,
 	}
 
 	/* post process */
-	mail_tool_restore_xevolution_headers (message, xev_headers);
+	mail_tool_restore_xevolution_headers (message, item->xev_headers);
 
-	if (local_error == NULL && driver) {
+	if (local_error == NULL && m->driver) {
 		camel_filter_driver_filter_message (
-			driver, message, info, NULL, NULL,
+			m->driver, message, info, NULL, NULL,
 			NULL, "", cancellable, &local_error);
 
 		if (local_error != NULL) {
@@ -748,7 +873,7 @@ mail_send_message (struct _send_queue_msg *m,
 		}
 	}
 
-	if (local_error == NULL && !sent_message_saved && (provider == NULL
+	if (local_error == NULL && !item->sent_message_saved && (provider == NULL
 	    || !(provider->flags & CAMEL_PROVIDER_DISABLE_SENT_FOLDER))) {
 		CamelFolder *local_sent_folder;
 		gboolean use_sent_folder = TRUE;
@@ -855,12 +980,12 @@ mail_send_message (struct _send_queue_msg *m,
 
 	if (local_error == NULL) {
 		camel_folder_set_message_flags (
-			queue, uid, CAMEL_MESSAGE_DELETED |
+			m->queue, item->uid, CAMEL_MESSAGE_DELETED |
 			CAMEL_MESSAGE_SEEN, ~0);
 		/* Sync it to disk, since if it crashes in between,
 		 * we keep sending it again on next start. */
 		/* FIXME Not passing a GCancellable or GError here. */
-		camel_folder_synchronize_sync (queue, FALSE, NULL, NULL);
+		camel_folder_synchronize_sync (m->queue, FALSE, NULL, NULL);
 	}
 
 	if (local_error == NULL && err->len > 0) {
@@ -871,22 +996,6 @@ mail_send_message (struct _send_queue_msg *m,
 	}
 
 exit:
-	if (did_connect) {
-		/* Disconnect regardless of error or cancellation,
-		 * but be mindful of these conditions when calling
-		 * camel_service_disconnect_sync(). */
-		if (g_cancellable_is_cancelled (cancellable)) {
-			camel_service_disconnect_sync (service, FALSE, NULL, NULL);
-		} else if (local_error != NULL) {
-			camel_service_disconnect_sync (service, FALSE, cancellable, NULL);
-		} else {
-			camel_service_disconnect_sync (service, TRUE, cancellable, &local_error);
-		}
-	}
-
-	if (service)
-		e_mail_session_unmark_service_used (m->session, service);
-
 	if (local_error != NULL)
 		g_propagate_error (error, local_error);
 
@@ -897,13 +1006,94 @@ exit:
 	}
 
 	g_clear_object (&info);
-	g_clear_object (&service);
-
-	g_object_unref (recipients);
-	g_object_unref (from);
-	camel_name_value_array_free (xev_headers);
 	g_string_free (err, TRUE);
-	g_object_unref (message);
+}
+
+static void
+send_queue_finish_item (SendItem *item)
+{
+	SendQueueRun *run = item->run;
+
+	g_mutex_lock (&run->lock);
+	g_queue_push_tail (&run->finished_items, item);
+	g_cond_signal (&run->cond);
+	g_mutex_unlock (&run->lock);
+}
+
+static void
+send_queue_store_thread (gpointer data,
+                         gpointer user_data)
+{
+	SendItem *item = data;
+	SendQueueRun *run = user_data;
+
+	mail_send_message_store (run, item, &item->error);
+
+	send_queue_finish_item (item);
+}
+
+/* sends the messages waiting for one transport, one after another */
+static void
+send_queue_send_thread (gpointer data,
+                        gpointer user_data)
+{
+	gchar *transport_uid = data;
+	SendQueueRun *run = user_data;
+	GQueue *pending;
+	SendItem *item;
+
+	g_mutex_lock (&run->lock);
+	pending = g_hash_table_lookup (run->busy_transports, transport_uid);
+	item = pending ? g_queue_pop_head (pending) : NULL;
+	g_mutex_unlock (&run->lock);
+
+	while (item) {
+		if (!g_cancellable_set_error_if_cancelled (run->cancellable, &item->error) &&
+		    mail_send_message_prepare (run, item, &item->error) &&
+		    mail_send_message_transport (run, item, &item->error)) {
+			/* Storing the message to the Sent folder does not block the transport */
+			g_thread_pool_push (run->store_pool, item, NULL);
+		} else {
+			send_queue_finish_item (item);
+		}
+
+		g_mutex_lock (&run->lock);
+		item = g_queue_pop_head (pending);
+		if (!item)
+			g_hash_table_remove (run->busy_transports, transport_uid);
+		g_mutex_unlock (&run->lock);
+	}
+
+	g_free (transport_uid);
+}
+
+/* adds the message to the queue of its transport, in the Outbox order, and
+ * starts sending the messages of that transport, if it's not sending already */
+static void
+send_queue_dispatch_item (SendQueueRun *run,
+                          GThreadPool *send_pool,
+                          SendItem *item)
+{
+	GQueue *pending;
+	const gchar *transport_uid;
+
+	if (g_cancellable_set_error_if_cancelled (run->cancellable, &item->error) ||
+	    !mail_send_message_resolve_transport (run, item, &item->error)) {
+		send_queue_finish_item (item);
+		return;
+	}
+
+	transport_uid = item->service ? camel_service_get_uid (item->service) : "";
+
+	g_mutex_lock (&run->lock);
+	pending = g_hash_table_lookup (run->busy_transports, transport_uid);
+	if (!pending) {
+		pending = g_queue_new ();
+		g_hash_table_insert (run->busy_transports, g_strdup (transport_uid), pending);
+		g_thread_pool_push (send_pool, g_strdup (transport_uid), NULL);
+	}
+	g_queue_push_tail (pending, item);
+	g_mutex_unlock (&run->lock);
 }
 
 /* ** SEND MAIL QUEUE ***************************************************** */
@@ -934,9 +1124,10 @@ send_queue_exec (struct _send_queue_msg *m,
 {
 	CamelFolder *sent_folder;
 	GPtrArray *uids, *send_uids = NULL;
+	GThreadPool *send_pool;
+	SendQueueRun run;
 	gint i, j;
 	time_t delay_send = 0;
-	GError *local_error = NULL;
 
 	d (printf ("sending queue\n"));
 
@@ -987,61 +1178,109 @@ send_queue_exec (struct _send_queue_msg *m,
 	 *     fatal problems, it is also used as a mechanism to accumualte
 	 *     warning messages and present them back to the user. */
 
+	memset (&run, 0, sizeof (SendQueueRun));
+	run.m = m;
+	run.cancellable = cancellable;
+	g_mutex_init (&run.lock);
+	g_cond_init (&run.cond);
+	g_queue_init (&run.finished_items);
+	run.busy_transports = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, (GDestroyNotify) g_queue_free);
+	run.store_pool = g_thread_pool_new (send_queue_store_thread, &run, 1, FALSE, NULL);
+
+	/* Messages of different transports are sent in parallel, while
+	 * the sent messages are stored in a separate thread, thus one slow
+	 * transport or a slow Sent folder does not delay the others. The
+	 * transports are resolved here, in the Outbox order, thus messages
+	 * of one transport are sent in the order they were queued. */
+	send_pool = g_thread_pool_new (send_queue_send_thread, &run, MAX_SENDING_THREADS, FALSE, NULL);
+
+	for (i = 0; i < send_uids->len; i++) {
+		SendItem *item;
+
+		item = g_slice_new0 (SendItem);
+		item->run = &run;
+		item->uid = g_strdup (send_uids->pdata[i]);
+
+		send_queue_dispatch_item (&run, send_pool, item);
+	}
+
+	g_mutex_lock (&run.lock);
+
+	report_status (
+		m, CAMEL_FILTER_STATUS_START, 0,
+		_("Sending message %d of %d"), 1,
+		send_uids->len);
+
+	/* The messages are finished in any order, the failures
+	 * are collected and reported as each message finishes. */
 	for (i = 0, j = 0; i < send_uids->len; i++) {
-		gint pc = (100 * i) / send_uids->len;
+		SendItem *item;
+		gint pc;
 
-		report_status (
-			m, CAMEL_FILTER_STATUS_START, pc,
-			_("Sending message %d of %d"), i + 1,
-			send_uids->len);
+		while (item = g_queue_pop_head (&run.finished_items), !item)
+			g_cond_wait (&run.cond, &run.lock);
+
+		pc = (100 * (i + 1)) / send_uids->len;
 
-		camel_operation_progress (
-			cancellable, (i + 1) * 100 / send_uids->len);
+		if (i + 1 < send_uids->len) {
+			report_status (
+				m, CAMEL_FILTER_STATUS_START, pc,
+				_("Sending message %d of %d"), i + 2,
+				send_uids->len);
+		}
 
-		mail_send_message (
-			m, m->queue, send_uids->pdata[i],
-			m->driver, cancellable, &local_error);
+		camel_operation_progress (cancellable, pc);
 
-		if (local_error != NULL) {
-			if (!g_error_matches (local_error, G_IO_ERROR, G_IO_ERROR_CANCELLED)) {
+		if (item->error != NULL) {
+			if (!g_error_matches (item->error, G_IO_ERROR, G_IO_ERROR_CANCELLED)) {
 				/* merge exceptions into one */
 				if (m->base.error != NULL) {
-					gchar *old_message;
-
-					old_message = g_strdup (
-						m->base.error->message);
-					g_clear_error (&m->base.error);
-					g_set_error (
-						&m->base.error, CAMEL_ERROR,
-						CAMEL_ERROR_GENERIC,
-						"%s\n\n%s", old_message,
-						local_error->message);
-					g_free (old_message);
-
-					g_clear_error (&local_error);
+					if (!g_error_matches (m->base.error, G_IO_ERROR, G_IO_ERROR_CANCELLED)) {
+						gchar *old_message;
+
+						old_message = g_strdup (
+							m->base.error->message);
+						g_clear_error (&m->base.error);
+						g_set_error (
+							&m->base.error, CAMEL_ERROR,
+							CAMEL_ERROR_GENERIC,
+							"%s\n\n%s", old_message,
+							item->error->message);
+						g_free (old_message);
+					}
 				} else {
-					g_propagate_error (&m->base.error, local_error);
-					local_error = NULL;
+					g_propagate_error (&m->base.error, item->error);
+					item->error = NULL;
 				}
 
 				if (!m->failed_uids)
 					m->failed_uids = g_ptr_array_new_with_free_func ((GDestroyNotify) camel_pstring_free);
 
-				g_ptr_array_add (m->failed_uids, (gpointer) camel_pstring_strdup (send_uids->pdata[i]));
-
-				/* keep track of the number of failures */
-				j++;
-			} else {
+				g_ptr_array_add (m->failed_uids, (gpointer) camel_pstring_strdup (item->uid));
+			} else if (!g_error_matches (m->base.error, G_IO_ERROR, G_IO_ERROR_CANCELLED)) {
 				/* transfer the USER_CANCEL error to the
-				 * async op exception and then break */
-				g_propagate_error (&m->base.error, local_error);
-				local_error = NULL;
-				break;
+				 * async op exception */
+				g_clear_error (&m->base.error);
+				g_propagate_error (&m->base.error, item->error);
+				item->error = NULL;
 			}
+
+			/* keep track of the number of failures */
+			j++;
 		}
+
+		send_item_free (item);
 	}
 
-	j += (send_uids->len - i);
+	g_mutex_unlock (&run.lock);
+
+	/* All messages are finished, this only waits for the threads to exit */
+	g_thread_pool_free (send_pool, FALSE, TRUE);
+	g_thread_pool_free (run.store_pool, FALSE, TRUE);
+
+	g_hash_table_destroy (run.busy_transports);
+	g_mutex_clear (&run.lock);
+	g_cond_clear (&run.cond);
 
 	if (j > 0)
 		report_status (
@@ -1267,6 +1506,7 @@ mail_transfer_messages (EMailSession *session,
                         gpointer data)
 {
 	struct _transfer_msg *m;
+	CamelStore *dest_store = NULL;
 
 	g_return_if_fail (CAMEL_IS_FOLDER (source));
 	g_return_if_fail (uids != NULL);
@@ -1282,6 +1522,14 @@ mail_transfer_messages (EMailSession *session,
 	m->done = done;
 	m->data = data;
 
+	mail_msg_set_service (m, CAMEL_SERVICE (camel_folder_get_parent_store (source)));
+
+	/* Order also against the operations of the destination account */
+	if (e_mail_folder_uri_parse (CAMEL_SESSION (session), dest_uri, &dest_store, NULL, NULL)) {
+		mail_msg_set_other_service (m, CAMEL_SERVICE (dest_store));
+		g_object_unref (dest_store);
+	}
+
 	mail_msg_slow_ordered_push (m);
 }
 
@@ -1402,6 +1650,9 @@ mail_sync_folder (CamelFolder *folder,
 	m->data = data;
 	m->done = done;
 
+	mail_msg_set_service (m, CAMEL_SERVICE (camel_folder_get_parent_store (folder)));
+	mail_msg_set_priority (m, MAIL_MSG_PRIORITY_BACKGROUND);
+
 	mail_msg_slow_ordered_push (m);
 }
 
@@ -1483,6 +1734,9 @@ mail_sync_store (CamelStore *store,
 	m->data = data;
 	m->done = done;
 
+	mail_msg_set_service (m, CAMEL_SERVICE (store));
+	mail_msg_set_priority (m, MAIL_MSG_PRIORITY_BACKGROUND);
+
 	mail_msg_slow_ordered_push (m);
 }
 
@@ -1559,6 +1813,8 @@ mail_empty_trash (CamelStore *store)
 	m = mail_msg_new (&empty_trash_info);
 	m->store = g_object_ref (store);
 
+	mail_msg_set_service (m, CAMEL_SERVICE (store));
+
 	mail_msg_slow_ordered_push (m);
 }
 
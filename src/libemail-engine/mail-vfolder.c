@@ -38,6 +38,9 @@
 
 #define d(x)  /* (printf("%s:%s: ",  G_STRLOC, G_STRFUNC), (x))*/
 
+/* Expression and sources the search folder had been set up with last time */
+#define VFOLDER_SETUP_KEY "mail-vfolder-setup-key"
+
 /* Note: Once we completely move mail to EDS, this context wont be available for UI.
  * and vfoldertypes.xml should be moved here really. */
 EMVFolderContext *context;	/* context remains open all time */
@@ -52,6 +55,21 @@ static volatile gint vfolder_shutdown;	/* are we shutting down? */
 
 static void rule_changed (EFilterRule *rule, CamelFolder *folder);
 
+typedef struct _AddUriData {
+	gchar *uri;
+	GList *folders;
+	gboolean remove;
+	guint batch;
+} AddUriData;
+
+/* Source folders to be added to or removed from search folders; guarded
+ * by the vfolder lock. They are processed in batches by a single job, to
+ * not freeze, thaw and notify each search folder once per source folder,
+ * like when an account with many folders is enabled. */
+static GQueue pending_adduris = G_QUEUE_INIT;
+static guint adduri_batch;
+static gboolean adduri_batch_scheduled;
+
 /* ********************************************************************** */
 
 static gboolean
@@ -140,6 +158,8 @@ struct _setup_msg {
 	CamelFolder *folder;
 	gchar *query;
 	GList *sources_uri;
+	gchar *setup_key;
+	gboolean finished;
 };
 
 static gchar *
@@ -158,7 +178,10 @@ vfolder_setup_exec (struct _setup_msg *m,
 	GList *l, *list = NULL;
 	CamelFolder *folder;
 
-	camel_vee_folder_set_expression ((CamelVeeFolder *) m->folder, m->query);
+	/* Changing the expression re-evaluates all the messages,
+	 * thus do it only when it really changed. */
+	if (g_strcmp0 (camel_vee_folder_get_expression ((CamelVeeFolder *) m->folder), m->query) != 0)
+		camel_vee_folder_set_expression ((CamelVeeFolder *) m->folder, m->query);
 
 	for (l = m->sources_uri;
 	     l && !vfolder_shutdown && !g_cancellable_is_cancelled (cancellable);
@@ -192,15 +215,25 @@ vfolder_setup_exec (struct _setup_msg *m,
 		}
 	}
 
-	if (!vfolder_shutdown && !g_cancellable_is_cancelled (cancellable))
+	/* This adds and removes only the folders which differ */
+	if (!vfolder_shutdown && !g_cancellable_is_cancelled (cancellable)) {
 		camel_vee_folder_set_folders ((CamelVeeFolder *) m->folder, list, cancellable);
 
+		m->finished = !g_cancellable_is_cancelled (cancellable);
+	}
+
 	g_list_free_full (list, g_object_unref);
 }
 
 static void
 vfolder_setup_done (struct _setup_msg *m)
 {
+	/* Remember what the folder is set up for only when the setup
+	 * finished, otherwise the next rule change sets it up again. */
+	if (m->finished && !m->base.error) {
+		g_object_set_data_full (G_OBJECT (m->folder), VFOLDER_SETUP_KEY, m->setup_key, g_free);
+		m->setup_key = NULL;
+	}
 }
 
 static void
@@ -212,6 +245,7 @@ vfolder_setup_free (struct _setup_msg *m)
 	g_object_unref (m->folder);
 	g_free (m->query);
 	g_list_free_full (m->sources_uri, g_free);
+	g_free (m->setup_key);
 }
 
 static MailMsgInfo vfolder_setup_info = {
@@ -222,12 +256,13 @@ static MailMsgInfo vfolder_setup_info = {
 	(MailMsgFreeFunc) vfolder_setup_free
 };
 
-/* sources_uri should be camel uri's */
+/* sources_uri should be camel uri's; both sources_uri and setup_key are consumed */
 static gint
 vfolder_setup (CamelSession *session,
                CamelFolder *folder,
                const gchar *query,
-               GList *sources_uri)
+               GList *sources_uri,
+               gchar *setup_key)
 {
 	struct _setup_msg *m;
 	gint id;
@@ -237,9 +272,16 @@ vfolder_setup (CamelSession *session,
 	m->folder = g_object_ref (folder);
 	m->query = g_strdup (query);
 	m->sources_uri = sources_uri;
+	m->setup_key = setup_key;
 
 	camel_folder_freeze (m->folder);
 
+	/* Source folder changes made after this should not be
+	 * processed before it, thus start a new batch for them. */
+	G_LOCK (vfolder);
+	adduri_batch_scheduled = FALSE;
+	G_UNLOCK (vfolder);
+
 	id = m->base.seq;
 	mail_msg_slow_ordered_push (m);
 
@@ -273,11 +315,24 @@ struct _adduri_msg {
 	MailMsg base;
 
 	EMailSession *session;
-	gchar *uri;
-	GList *folders;
-	gint remove;
+	gchar *uri; /* the first in the batch, for the description */
+	guint batch;
+	GSList *processed; /* AddUriData * */
 };
 
+static void
+add_uri_data_free (gpointer ptr)
+{
+	AddUriData *aud = ptr;
+
+	if (aud) {
+		g_list_foreach (aud->folders, (GFunc) camel_folder_thaw, NULL);
+		g_list_free_full (aud->folders, g_object_unref);
+		g_free (aud->uri);
+		g_free (aud);
+	}
+}
+
 static gchar *
 vfolder_adduri_desc (struct _adduri_msg *m)
 {
@@ -309,37 +364,35 @@ vfolder_adduri_desc (struct _adduri_msg *m)
 }
 
 static void
-vfolder_adduri_exec (struct _adduri_msg *m,
-                     GCancellable *cancellable,
-                     GError **error)
+vfolder_adduri_one (EMailSession *session,
+                    AddUriData *aud,
+                    GCancellable *cancellable,
+                    GError **error)
 {
 	CamelFolder *folder = NULL;
 	gboolean cache_has_info;
 
-	if (vfolder_shutdown)
-		return;
-
 	cache_has_info = vfolder_cache_has_folder_info (
-		m->session, m->uri[0] == '*' ? m->uri + 1 : m->uri);
+		session, aud->uri[0] == '*' ? aud->uri + 1 : aud->uri);
 
-	if (!m->remove && !cache_has_info) {
+	if (!aud->remove && !cache_has_info) {
 		g_warning (
 			"Folder '%s' disappeared while I was "
-			"adding/removing it to/from my vfolder", m->uri);
+			"adding/removing it to/from my vfolder", aud->uri);
 		return;
 	}
 
-	if (m->uri[0] == '*') {
+	if (aud->uri[0] == '*') {
 		GList *uris, *iter;
 
-		uris = vfolder_get_include_subfolders_uris (m->session, m->uri, cancellable);
+		uris = vfolder_get_include_subfolders_uris (session, aud->uri, cancellable);
 		for (iter = uris; iter; iter = iter->next) {
 			const gchar *fi_uri = iter->data;
 
 			folder = e_mail_session_uri_to_folder_sync (
-				m->session, fi_uri, 0, cancellable, NULL);
+				session, fi_uri, 0, cancellable, NULL);
 			if (folder != NULL) {
-				vfolder_add_remove_one (m->folders, m->remove, folder, cancellable);
+				vfolder_add_remove_one (aud->folders, aud->remove, folder, cancellable);
 				g_object_unref (folder);
 			}
 		}
@@ -349,15 +402,63 @@ vfolder_adduri_exec (struct _adduri_msg *m,
 		/* always pick fresh folders - they are
 		 * from CamelStore's folders bag anyway */
 		folder = e_mail_session_uri_to_folder_sync (
-			m->session, m->uri, 0, cancellable, error);
+			session, aud->uri, 0, cancellable, error);
 
 		if (folder != NULL) {
-			vfolder_add_remove_one (m->folders, m->remove, folder, cancellable);
+			vfolder_add_remove_one (aud->folders, aud->remove, folder, cancellable);
 			g_object_unref (folder);
 		}
 	}
 }
 
+static void
+vfolder_adduri_exec (struct _adduri_msg *m,
+                     GCancellable *cancellable,
+                     GError **error)
+{
+	AddUriData *aud;
+
+	while (!vfolder_shutdown && !g_cancellable_is_cancelled (cancellable)) {
+		GError *local_error = NULL;
+
+		G_LOCK (vfolder);
+		aud = g_queue_peek_head (&pending_adduris);
+		if (aud && aud->batch == m->batch) {
+			g_queue_pop_head (&pending_adduris);
+		} else {
+			aud = NULL;
+			if (m->batch == adduri_batch)
+				adduri_batch_scheduled = FALSE;
+		}
+		G_UNLOCK (vfolder);
+
+		if (!aud)
+			return;
+
+		/* Freed, and the search folders thawed, together at the end */
+		m->processed = g_slist_prepend (m->processed, aud);
+
+		vfolder_adduri_one (m->session, aud, cancellable, &local_error);
+
+		if (local_error) {
+			if (error && !*error)
+				g_propagate_error (error, local_error);
+			else
+				g_clear_error (&local_error);
+		}
+	}
+
+	/* Cancelled; drop the rest of the batch, nothing else would process it */
+	G_LOCK (vfolder);
+	while ((aud = g_queue_peek_head (&pending_adduris)) != NULL && aud->batch == m->batch) {
+		g_queue_pop_head (&pending_adduris);
+		m->processed = g_slist_prepend (m->processed, aud);
+	}
+	if (m->batch == adduri_batch)
+		adduri_batch_scheduled = FALSE;
+	G_UNLOCK (vfolder);
+}
+
 static void
 vfolder_adduri_done (struct _adduri_msg *m)
 {
@@ -367,8 +468,7 @@ static void
 vfolder_adduri_free (struct _adduri_msg *m)
 {
 	g_object_unref (m->session);
-	g_list_foreach (m->folders, (GFunc) camel_folder_thaw, NULL);
-	g_list_free_full (m->folders, g_object_unref);
+	g_slist_free_full (m->processed, add_uri_data_free);
 	g_free (m->uri);
 }
 
@@ -381,27 +481,42 @@ static MailMsgInfo vfolder_adduri_info = {
 };
 
 /* uri should be a camel uri */
-static gint
+static void
 vfolder_adduri (EMailSession *session,
                 const gchar *uri,
                 GList *folders,
                 gint remove)
 {
-	struct _adduri_msg *m;
-	gint id;
+	AddUriData *aud;
+	struct _adduri_msg *m = NULL;
 
-	m = mail_msg_new (&vfolder_adduri_info);
-	m->session = g_object_ref (session);
-	m->folders = folders;
-	m->uri = g_strdup (uri);
-	m->remove = remove;
+	aud = g_new0 (AddUriData, 1);
+	aud->uri = g_strdup (uri);
+	aud->folders = folders;
+	aud->remove = remove;
 
-	g_list_foreach (m->folders, (GFunc) camel_folder_freeze, NULL);
+	g_list_foreach (aud->folders, (GFunc) camel_folder_freeze, NULL);
 
-	id = m->base.seq;
-	mail_msg_slow_ordered_push (m);
+	G_LOCK (vfolder);
 
-	return id;
+	/* Join the batch, if its job did not finish yet */
+	if (!adduri_batch_scheduled) {
+		adduri_batch++;
+		adduri_batch_scheduled = TRUE;
+
+		m = mail_msg_new (&vfolder_adduri_info);
+		m->session = g_object_ref (session);
+		m->uri = g_strdup (uri);
+		m->batch = adduri_batch;
+	}
+
+	aud->batch = adduri_batch;
+	g_queue_push_tail (&pending_adduris, aud);
+
+	G_UNLOCK (vfolder);
+
+	if (m)
+		mail_msg_slow_ordered_push (m);
 }
 
 /* ********************************************************************** */
@@ -807,6 +922,27 @@ rule_add_sources (EMailSession *session,
 	*sources_urip = sources_uri;
 }
 
+static gchar *
+vfolder_build_setup_key (const gchar *query,
+                         GList *sources_uri)
+{
+	GString *key;
+	GList *sorted, *link;
+
+	key = g_string_new (query);
+
+	sorted = g_list_sort (g_list_copy (sources_uri), (GCompareFunc) g_strcmp0);
+
+	for (link = sorted; link; link = g_list_next (link)) {
+		g_string_append_c (key, '\n');
+		g_string_append (key, link->data);
+	}
+
+	g_list_free (sorted);
+
+	return g_string_free (key, FALSE);
+}
+
 static void
 rule_changed (EFilterRule *rule,
               CamelFolder *folder)
@@ -818,6 +954,7 @@ rule_changed (EFilterRule *rule,
 	GList *sources_uri = NULL;
 	GString *query;
 	const gchar *full_name;
+	gchar *setup_key;
 
 	full_name = camel_folder_get_full_name (folder);
 	store = camel_folder_get_parent_store (folder);
@@ -913,7 +1050,16 @@ rule_changed (EFilterRule *rule,
 	query = g_string_new ("");
 	e_filter_rule_build_code (rule, query);
 
-	vfolder_setup (session, folder, query->str, sources_uri);
+	setup_key = vfolder_build_setup_key (query->str, sources_uri);
+
+	/* The rule can change without changing the expression or the sources,
+	 * like with the auto-update option, when there's nothing to set up. */
+	if (g_strcmp0 (g_object_get_data (G_OBJECT (folder), VFOLDER_SETUP_KEY), setup_key) == 0) {
+		g_list_free_full (sources_uri, g_free);
+		g_free (setup_key);
+	} else {
+		vfolder_setup (session, folder, query->str, sources_uri, setup_key);
+	}
 
 	g_string_free (query, TRUE);
 
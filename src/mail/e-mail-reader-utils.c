@@ -551,6 +551,9 @@ e_mail_reader_expunge_folder_name (EMailReader *reader,
 	g_object_unref (activity);
 }
 
+/* How many messages are marked as deleted at once when emptying a Junk folder */
+#define EMPTY_JUNK_BATCH_SIZE 500
+
 static void
 mail_reader_empty_junk_thread (EAlertSinkThreadJobData *job_data,
 			       gpointer user_data,
@@ -561,7 +564,7 @@ mail_reader_empty_junk_thread (EAlertSinkThreadJobData *job_data,
 	CamelFolder *folder;
 	CamelFolderSummary *summary;
 	GPtrArray *uids;
-	guint ii;
+	guint ii, jj;
 
 	g_return_if_fail (async_context != NULL);
 
@@ -570,31 +573,42 @@ mail_reader_empty_junk_thread (EAlertSinkThreadJobData *job_data,
 	g_return_if_fail (CAMEL_IS_FOLDER (folder));
 	g_return_if_fail ((camel_folder_get_flags (folder) & CAMEL_FOLDER_IS_JUNK) != 0);
 
-	camel_folder_freeze (folder);
-
 	summary = camel_folder_get_folder_summary (folder);
 	if (summary)
 		camel_folder_summary_prepare_fetch_all (summary, NULL);
 
 	uids = camel_folder_get_uids (folder);
-	if (uids) {
-		for (ii = 0; ii < uids->len; ii++) {
-			CamelMessageInfo *nfo;
-
-			nfo = camel_folder_get_message_info (folder, uids->pdata[ii]);
-			if (nfo) {
-				camel_message_info_set_flags (nfo, CAMEL_MESSAGE_DELETED, CAMEL_MESSAGE_DELETED);
-				g_object_unref (nfo);
-			}
+	if (!uids)
+		return;
+
+	/* The messages are marked and saved in batches, with the folder frozen
+	 * only for one batch, thus the message list is updated as it goes and
+	 * the operation can be cancelled in the middle.  Messages already marked
+	 * by an interrupted run do not change, thus running it again continues
+	 * where it stopped. */
+	for (ii = 0; ii < uids->len; ii += EMPTY_JUNK_BATCH_SIZE) {
+		guint batch_end = MIN (ii + EMPTY_JUNK_BATCH_SIZE, uids->len);
+		gboolean changed = FALSE;
+
+		if (g_cancellable_set_error_if_cancelled (cancellable, error))
+			break;
+
+		camel_folder_freeze (folder);
+
+		for (jj = ii; jj < batch_end; jj++) {
+			if (camel_folder_set_message_flags (folder, uids->pdata[jj], CAMEL_MESSAGE_DELETED, CAMEL_MESSAGE_DELETED))
+				changed = TRUE;
 		}
 
-		if (uids->len > 0)
-			camel_folder_synchronize_sync (folder, FALSE, cancellable, error);
+		camel_folder_thaw (folder);
 
-		camel_folder_free_uids (folder, uids);
+		if (changed && !camel_folder_synchronize_sync (folder, FALSE, cancellable, error))
+			break;
+
+		camel_operation_progress (cancellable, 100 * batch_end / uids->len);
 	}
 
-	camel_folder_thaw (folder);
+	camel_folder_free_uids (folder, uids);
 }
 
 void
@@ -1016,6 +1030,129 @@ e_mail_reader_unsubscribe_folder_name (EMailReader *reader,
 	g_object_unref (activity);
 }
 
+/* Selections with at least this many messages are changed in a dedicated thread */
+#define MARK_IN_THREAD_THRESHOLD 500
+
+/* How many messages are changed between progress updates and cancellation checks */
+#define MARK_BATCH_SIZE 1000
+
+typedef struct {
+	CamelFolder *folder;
+	GPtrArray *uids;
+	guint32 mask;
+	guint32 set;
+	gchar **user_flags;
+	gboolean user_flags_set;
+} MarkMessagesData;
+
+static void
+mark_messages_data_free (gpointer ptr)
+{
+	MarkMessagesData *mmd = ptr;
+
+	if (mmd) {
+		g_clear_object (&mmd->folder);
+		g_ptr_array_unref (mmd->uids);
+		g_strfreev (mmd->user_flags);
+		g_slice_free (MarkMessagesData, mmd);
+	}
+}
+
+/* Camel has no call to change the flags of several messages at once, thus
+ * each message is changed separately; the folder is frozen meanwhile, thus
+ * the change is notified only once, on thaw. */
+static void
+mail_reader_mark_messages_apply (MarkMessagesData *mmd,
+				 guint from_index,
+				 guint to_index)
+{
+	guint ii, jj;
+
+	for (ii = from_index; ii < to_index; ii++) {
+		const gchar *uid = mmd->uids->pdata[ii];
+
+		if (mmd->mask)
+			camel_folder_set_message_flags (mmd->folder, uid, mmd->mask, mmd->set);
+
+		for (jj = 0; mmd->user_flags && mmd->user_flags[jj]; jj++)
+			camel_folder_set_message_user_flag (mmd->folder, uid, mmd->user_flags[jj], mmd->user_flags_set);
+
+		/* The old-style label is cleared once per message, not once per flag */
+		if (mmd->user_flags && mmd->user_flags[0] && !mmd->user_flags_set)
+			camel_folder_set_message_user_tag (mmd->folder, uid, "label", NULL);
+	}
+}
+
+static void
+mail_reader_mark_messages_thread (EAlertSinkThreadJobData *job_data,
+				  gpointer user_data,
+				  GCancellable *cancellable,
+				  GError **error)
+{
+	MarkMessagesData *mmd = user_data;
+	guint ii;
+
+	g_return_if_fail (mmd != NULL);
+
+	/* The folder emits a single "changed" signal with all the messages on thaw */
+	camel_folder_freeze (mmd->folder);
+
+	for (ii = 0; ii < mmd->uids->len; ii += MARK_BATCH_SIZE) {
+		if (g_cancellable_set_error_if_cancelled (cancellable, error))
+			break;
+
+		mail_reader_mark_messages_apply (mmd, ii, MIN (ii + MARK_BATCH_SIZE, mmd->uids->len));
+
+		camel_operation_progress (cancellable, 100 * MIN (ii + MARK_BATCH_SIZE, mmd->uids->len) / mmd->uids->len);
+	}
+
+	camel_folder_thaw (mmd->folder);
+}
+
+/* Takes ownership of the @uids and the @user_flags */
+static void
+mail_reader_mark_messages (EMailReader *reader,
+			   CamelFolder *folder,
+			   GPtrArray *uids,
+			   guint32 mask,
+			   guint32 set,
+			   gchar **user_flags,
+			   gboolean user_flags_set)
+{
+	MarkMessagesData *mmd;
+
+	mmd = g_slice_new0 (MarkMessagesData);
+	mmd->folder = g_object_ref (folder);
+	mmd->uids = uids;
+	mmd->mask = mask;
+	mmd->set = set;
+	mmd->user_flags = user_flags;
+	mmd->user_flags_set = user_flags_set;
+
+	if (uids->len >= MARK_IN_THREAD_THRESHOLD) {
+		EAlertSink *alert_sink;
+		EActivity *activity;
+
+		alert_sink = e_mail_reader_get_alert_sink (reader);
+
+		activity = e_alert_sink_submit_thread_job (alert_sink,
+			_("Changing flags of messages"), "mail:failed-mark-messages",
+			camel_folder_get_full_name (folder), mail_reader_mark_messages_thread,
+			mmd, mark_messages_data_free);
+
+		if (activity)
+			e_shell_backend_add_activity (E_SHELL_BACKEND (e_mail_reader_get_backend (reader)), activity);
+
+		g_clear_object (&activity);
+	} else {
+		camel_folder_freeze (folder);
+		mail_reader_mark_messages_apply (mmd, 0, uids->len);
+		camel_folder_thaw (folder);
+
+		mark_messages_data_free (mmd);
+	}
+}
+
 guint
 e_mail_reader_mark_selected (EMailReader *reader,
                              guint32 mask,
@@ -1031,13 +1168,8 @@ e_mail_reader_mark_selected (EMailReader *reader,
 	if (folder != NULL) {
 		GPtrArray *uids;
 
-		camel_folder_freeze (folder);
-
 		uids = e_mail_reader_get_selected_uids_with_collapsed_threads (reader);
-
-		for (ii = 0; ii < uids->len; ii++)
-			camel_folder_set_message_flags (
-				folder, uids->pdata[ii], mask, set);
+		ii = uids->len;
 
 		/* This function is called on user interaction, thus make sure the message list
 		   will scroll to the selected message, which can eventually change due to
@@ -1049,9 +1181,11 @@ e_mail_reader_mark_selected (EMailReader *reader,
 				e_tree_show_cursor_after_reflow (E_TREE (message_list));
 		}
 
-		g_ptr_array_unref (uids);
-
-		camel_folder_thaw (folder);
+		/* Large selections are changed in a thread, to not block the UI */
+		if (uids->len > 0)
+			mail_reader_mark_messages (reader, folder, uids, mask, set, NULL, FALSE);
+		else
+			g_ptr_array_unref (uids);
 
 		g_object_unref (folder);
 	}
@@ -1059,6 +1193,43 @@ e_mail_reader_mark_selected (EMailReader *reader,
 	return ii;
 }
 
+/**
+ * e_mail_reader_set_selected_labels:
+ * @reader: an #EMailReader
+ * @tags: (array zero-terminated=1): label tags to set or unset
+ * @set: whether to set or unset the @tags
+ *
+ * Sets or unsets all the label @tags on the selected messages. When
+ * unsetting, also the old-style "label" user tag is removed. Large
+ * selections are changed in a dedicated thread.
+ *
+ * Since: 3.30
+ **/
+void
+e_mail_reader_set_selected_labels (EMailReader *reader,
+				   const gchar * const *tags,
+				   gboolean set)
+{
+	CamelFolder *folder;
+	GPtrArray *uids;
+
+	g_return_if_fail (E_IS_MAIL_READER (reader));
+	g_return_if_fail (tags != NULL);
+
+	folder = e_mail_reader_ref_folder (reader);
+	if (!folder)
+		return;
+
+	uids = e_mail_reader_get_selected_uids (reader);
+
+	if (uids->len > 0 && *tags)
+		mail_reader_mark_messages (reader, folder, uids, 0, 0, g_strdupv ((gchar **) tags), set);
+	else
+		g_ptr_array_unref (uids);
+
+	g_object_unref (folder);
+}
+
 static guint
 summary_msgid_hash (gconstpointer key)
 {
@@ -59,6 +59,10 @@ void		e_mail_reader_unsubscribe_folder_name
 guint		e_mail_reader_mark_selected	(EMailReader *reader,
 						 guint32 mask,
 						 guint32 set);
+void		e_mail_reader_set_selected_labels
+						(EMailReader *reader,
+						 const gchar * const *tags,
+						 gboolean set);
 typedef enum {
 	E_IGNORE_THREAD_WHOLE_SET,
 	E_IGNORE_THREAD_WHOLE_UNSET,
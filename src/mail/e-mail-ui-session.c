@@ -75,6 +75,10 @@ struct _EMailUISessionPrivate {
 
 	GSList *address_cache; /* data is AddressCacheData struct */
 	GMutex address_cache_mutex;
+
+	/* Used only from the main thread */
+	GHashTable *filter_rules; /* gchar *source ~> GPtrArray { FilterRuleCode * } */
+	gchar *filter_rules_stamp; /* state of the files the rules were built from */
 };
 
 enum {
@@ -220,19 +224,148 @@ session_folder_can_filter_junk (CamelFolder *folder)
 	return (camel_folder_get_flags (folder) & CAMEL_FOLDER_FILTER_JUNK) != 0;
 }
 
+typedef struct _FilterRuleCode {
+	gchar *name;
+	gchar *search;
+	gchar *action;
+} FilterRuleCode;
+
+static void
+filter_rule_code_free (gpointer ptr)
+{
+	FilterRuleCode *frc = ptr;
+
+	if (frc) {
+		g_free (frc->name);
+		g_free (frc->search);
+		g_free (frc->action);
+		g_slice_free (FilterRuleCode, frc);
+	}
+}
+
+static void
+mail_ui_session_append_file_stamp (GString *stamp,
+                                   const gchar *filename)
+{
+	GFile *file;
+	GFileInfo *info;
+
+	file = g_file_new_for_path (filename);
+	info = g_file_query_info (
+		file,
+		G_FILE_ATTRIBUTE_STANDARD_SIZE ","
+		G_FILE_ATTRIBUTE_TIME_MODIFIED ","
+		G_FILE_ATTRIBUTE_TIME_MODIFIED_USEC,
+		G_FILE_QUERY_INFO_NONE, NULL, NULL);
+
+	if (info) {
+		g_string_append_printf (
+			stamp, "%" G_GUINT64_FORMAT ".%u:%" G_GOFFSET_FORMAT ";",
+			g_file_info_get_attribute_uint64 (info, G_FILE_ATTRIBUTE_TIME_MODIFIED),
+			g_file_info_get_attribute_uint32 (info, G_FILE_ATTRIBUTE_TIME_MODIFIED_USEC),
+			g_file_info_get_size (info));
+		g_object_unref (info);
+	} else {
+		g_string_append (stamp, "-;");
+	}
+
+	g_object_unref (file);
+}
+
+/* Returns the generated code of the enabled rules for the filter source @type,
+ * in the order they are defined. The code of all the rules is built at once
+ * and reused until any of the filter files changes. */
+static GPtrArray *
+mail_ui_session_get_filter_rules (EMailUISession *session,
+                                  const gchar *type)
+{
+	EMailUISessionPrivate *priv = session->priv;
+	const gchar *config_dir;
+	gchar *user, *system;
+	GString *stamp;
+
+	config_dir = mail_session_get_config_dir ();
+	user = g_build_filename (config_dir, "filters.xml", NULL);
+	system = g_build_filename (EVOLUTION_PRIVDATADIR, "filtertypes.xml", NULL);
+
+	stamp = g_string_new ("");
+	mail_ui_session_append_file_stamp (stamp, system);
+	mail_ui_session_append_file_stamp (stamp, user);
+
+	if (!priv->filter_rules || g_strcmp0 (stamp->str, priv->filter_rules_stamp) != 0) {
+		ERuleContext *fc;
+		EFilterRule *rule = NULL;
+		GString *fsearch, *faction;
+
+		if (priv->filter_rules)
+			g_hash_table_remove_all (priv->filter_rules);
+		else
+			priv->filter_rules = g_hash_table_new_full (
+				g_str_hash, g_str_equal,
+				g_free, (GDestroyNotify) g_ptr_array_unref);
+
+		g_free (priv->filter_rules_stamp);
+		priv->filter_rules_stamp = g_string_free (stamp, FALSE);
+		stamp = NULL;
+
+		fc = (ERuleContext *) em_filter_context_new (E_MAIL_SESSION (session));
+		e_rule_context_load (fc, system, user);
+
+		fsearch = g_string_new ("");
+		faction = g_string_new ("");
+
+		while ((rule = e_rule_context_next_rule (fc, rule, NULL))) {
+			FilterRuleCode *frc;
+			GPtrArray *rules;
+
+			/* skip disabled rules */
+			if (!rule->enabled || !rule->source)
+				continue;
+
+			g_string_truncate (fsearch, 0);
+			g_string_truncate (faction, 0);
+
+			e_filter_rule_build_code (rule, fsearch);
+			em_filter_rule_build_action (
+				EM_FILTER_RULE (rule), faction);
+
+			frc = g_slice_new0 (FilterRuleCode);
+			frc->name = g_strdup (rule->name);
+			frc->search = g_strdup (fsearch->str);
+			frc->action = g_strdup (faction->str);
+
+			rules = g_hash_table_lookup (priv->filter_rules, rule->source);
+			if (!rules) {
+				rules = g_ptr_array_new_with_free_func (filter_rule_code_free);
+				g_hash_table_insert (priv->filter_rules, g_strdup (rule->source), rules);
+			}
+
+			g_ptr_array_add (rules, frc);
+		}
+
+		g_string_free (fsearch, TRUE);
+		g_string_free (faction, TRUE);
+
+		g_object_unref (fc);
+	}
+
+	if (stamp)
+		g_string_free (stamp, TRUE);
+
+	g_free (system);
+	g_free (user);
+
+	return g_hash_table_lookup (priv->filter_rules, type);
+}
+
 static CamelFilterDriver *
 main_get_filter_driver (CamelSession *session,
 			const gchar *type,
 			CamelFolder *for_folder,
 			GError **error)
 {
-	EMailSession *ms = E_MAIL_SESSION (session);
 	CamelFilterDriver *driver;
-	EFilterRule *rule = NULL;
-	const gchar *config_dir;
-	gchar *user, *system;
 	GSettings *settings;
-	ERuleContext *fc;
 	EMailUISessionPrivate *priv;
 	gboolean add_junk_test;
 
@@ -240,14 +373,6 @@ main_get_filter_driver (CamelSession *session,
 
 	settings = e_util_ref_settings ("org.gnome.evolution.mail");
 
-	config_dir = mail_session_get_config_dir ();
-	user = g_build_filename (config_dir, "filters.xml", NULL);
-	system = g_build_filename (EVOLUTION_PRIVDATADIR, "filtertypes.xml", NULL);
-	fc = (ERuleContext *) em_filter_context_new (ms);
-	e_rule_context_load (fc, system, user);
-	g_free (system);
-	g_free (user);
-
 	driver = camel_filter_driver_new (session);
 	camel_filter_driver_set_folder_func (driver, get_folder, session);
 
@@ -291,37 +416,24 @@ main_get_filter_driver (CamelSession *session,
 	}
 
 	if (strcmp (type, E_FILTER_SOURCE_JUNKTEST) != 0) {
-		GString *fsearch, *faction;
-
-		fsearch = g_string_new ("");
-		faction = g_string_new ("");
+		GPtrArray *rules;
+		guint ii;
 
 		if (!strcmp (type, E_FILTER_SOURCE_DEMAND))
 			type = E_FILTER_SOURCE_INCOMING;
 
-		/* add the user-defined rules next */
-		while ((rule = e_rule_context_next_rule (fc, rule, type))) {
-			g_string_truncate (fsearch, 0);
-			g_string_truncate (faction, 0);
+		rules = mail_ui_session_get_filter_rules (E_MAIL_UI_SESSION (session), type);
 
-			/* skip disabled rules */
-			if (!rule->enabled)
-				continue;
+		/* add the user-defined rules next */
+		for (ii = 0; rules && ii < rules->len; ii++) {
+			FilterRuleCode *frc = g_ptr_array_index (rules, ii);
 
-			e_filter_rule_build_code (rule, fsearch);
-			em_filter_rule_build_action (
-				EM_FILTER_RULE (rule), faction);
 			camel_filter_driver_add_rule (
-				driver, rule->name,
-				fsearch->str, faction->str);
+				driver, frc->name,
+				frc->search, frc->action);
 		}
-
-		g_string_free (fsearch, TRUE);
-		g_string_free (faction, TRUE);
 	}
 
-	g_object_unref (fc);
-
 	g_object_unref (settings);
 
 	return driver;
@@ -453,6 +565,10 @@ mail_ui_session_finalize (GObject *object)
 
 	g_mutex_clear (&priv->address_cache_mutex);
 
+	if (priv->filter_rules)
+		g_hash_table_destroy (priv->filter_rules);
+	g_free (priv->filter_rules_stamp);
+
 	/* Chain up to parent's method. */
 	G_OBJECT_CLASS (e_mail_ui_session_parent_class)->finalize (object);
 }
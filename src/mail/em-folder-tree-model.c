@@ -64,6 +64,9 @@ struct _EMFolderTreeModelPrivate {
 	/* CamelStore -> StoreInfo */
 	GHashTable *store_index;
 	GMutex store_index_lock;
+
+	/* Sorting is suspended while applying a batch of unread counts. */
+	gboolean unread_batch_running;
 };
 
 typedef struct _FolderUnreadInfo {
@@ -786,6 +789,36 @@ em_folder_tree_model_class_init (EMFolderTreeModelClass *class)
 		G_TYPE_POINTER);
 }
 
+static void
+folder_tree_model_unread_batch_started (EMFolderTreeModel *model)
+{
+	if (model->priv->unread_batch_running)
+		return;
+
+	model->priv->unread_batch_running = TRUE;
+
+	/* Every row change in a sorted store re-sorts its siblings;
+	 * the whole batch is sorted once when it's finished instead. */
+	gtk_tree_sortable_set_sort_column_id (
+		GTK_TREE_SORTABLE (model),
+		GTK_TREE_SORTABLE_UNSORTED_SORT_COLUMN_ID,
+		GTK_SORT_ASCENDING);
+}
+
+static void
+folder_tree_model_unread_batch_finished (EMFolderTreeModel *model)
+{
+	if (!model->priv->unread_batch_running)
+		return;
+
+	model->priv->unread_batch_running = FALSE;
+
+	gtk_tree_sortable_set_sort_column_id (
+		GTK_TREE_SORTABLE (model),
+		GTK_TREE_SORTABLE_DEFAULT_SORT_COLUMN_ID,
+		GTK_SORT_ASCENDING);
+}
+
 static void
 folder_tree_model_set_unread_count (EMFolderTreeModel *model,
                                     CamelStore *store,
@@ -1075,6 +1108,16 @@ em_folder_tree_model_set_session (EMFolderTreeModel *model,
 			folder_cache, "folder-unread-updated",
 			G_CALLBACK (folder_tree_model_set_unread_count),
 			model);
+
+		g_signal_connect_swapped (
+			folder_cache, "folder-unread-batch-started",
+			G_CALLBACK (folder_tree_model_unread_batch_started),
+			model);
+
+		g_signal_connect_swapped (
+			folder_cache, "folder-unread-batch-finished",
+			G_CALLBACK (folder_tree_model_unread_batch_finished),
+			model);
 	}
 
 	g_object_notify (G_OBJECT (model), "session");
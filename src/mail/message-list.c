@@ -173,6 +173,8 @@ struct _RegenData {
 	gchar *select_uid;
 	gboolean select_all;
 	gboolean select_use_fallback;
+
+	ETraceOp *trace_op; /* set only when tracing is enabled */
 };
 
 enum {
@@ -556,6 +558,10 @@ regen_data_unref (RegenData *regen_data)
 		g_mutex_clear (&regen_data->select_lock);
 		g_free (regen_data->select_uid);
 
+		/* Also closes operations which never ran; the op is NULL,
+		 * thus this is a no-op, when tracing is disabled */
+		e_trace_op_finish (regen_data->trace_op);
+
 		g_slice_free (RegenData, regen_data);
 	}
 }
@@ -6058,6 +6064,8 @@ message_list_regen_thread (GSimpleAsyncResult *simple,
 	if (g_cancellable_is_cancelled (cancellable))
 		return;
 
+	e_trace_op_start (regen_data->trace_op);
+
 	/* Just for convenience. */
 	folder = g_object_ref (regen_data->folder);
 
@@ -6209,6 +6217,9 @@ exit:
 		camel_folder_free_uids (folder, uids);
 
 	g_object_unref (folder);
+
+	e_trace_op_finish (regen_data->trace_op);
+	regen_data->trace_op = NULL;
 }
 
 static void
@@ -6547,6 +6558,15 @@ message_list_regen_idle_cb (gpointer user_data)
 	if (g_cancellable_is_cancelled (cancellable)) {
 		g_simple_async_result_complete (simple);
 	} else {
+		if (e_trace_is_enabled () && regen_data->folder) {
+			gchar *name;
+
+			name = g_strdup_printf ("message_list_regen_thread: %s",
+				camel_folder_get_full_name (regen_data->folder));
+			regen_data->trace_op = e_trace_op_new ("message-list", name);
+			g_free (name);
+		}
+
 		g_simple_async_result_run_in_thread (
 			simple,
 			message_list_regen_thread,
@@ -20,6 +20,8 @@
 #include "e-autosave-utils.h"
 
 #include <errno.h>
+#include <fcntl.h>
+#include <string.h>
 #include <glib/gstdio.h>
 #include <camel/camel.h>
 
@@ -29,8 +31,18 @@
 #define SNAPSHOT_FILE_PREFIX	".evolution-composer.autosave"
 #define SNAPSHOT_FILE_SEED	SNAPSHOT_FILE_PREFIX "-XXXXXX"
 
+/* Attachments are saved only once, each into its own file in a directory
+ * next to the snapshot file, and the snapshot file itself holds only
+ * the headers and the body, with the list of the attachment files in
+ * the SNAPSHOT_PARTS_HEADER. */
+#define SNAPSHOT_PARTS_KEY	"e-composer-snapshot-parts"
+#define SNAPSHOT_PARTS_SUFFIX	".parts"
+#define SNAPSHOT_PARTS_HEADER	"X-Evolution-Autosave-Parts"
+
 typedef struct _LoadContext LoadContext;
 typedef struct _SaveContext SaveContext;
+typedef struct _SnapshotParts SnapshotParts;
+typedef struct _SavedPart SavedPart;
 
 struct _LoadContext {
 	EMsgComposer *composer;
@@ -38,7 +50,25 @@ struct _LoadContext {
 
 struct _SaveContext {
 	GCancellable *cancellable;
-	GOutputStream *output_stream;
+	GFile *snapshot_file;
+	SnapshotParts *parts;
+};
+
+/* What had been saved by the previous snapshot of a composer */
+struct _SnapshotParts {
+	GMutex lock;
+	GHashTable *saved; /* CamelMimePart * ~> SavedPart * */
+	gchar *name_prefix;
+	guint next_index;
+	gchar *checksum;
+};
+
+/* One attachment file in the parts directory. The attachment part can be
+ * changed in place, like when it's renamed in the attachment dialog, thus
+ * the file is valid only while the part's headers match the digest. */
+struct _SavedPart {
+	gchar *basename;
+	gchar *headers_digest;
 };
 
 static void
@@ -56,16 +86,118 @@ save_context_free (SaveContext *context)
 	if (context->cancellable != NULL)
 		g_object_unref (context->cancellable);
 
-	if (context->output_stream != NULL)
-		g_object_unref (context->output_stream);
+	if (context->snapshot_file != NULL)
+		g_object_unref (context->snapshot_file);
 
 	g_slice_free (SaveContext, context);
 }
 
+static SavedPart *
+saved_part_new (const gchar *basename,
+		const gchar *headers_digest)
+{
+	SavedPart *saved;
+
+	saved = g_slice_new0 (SavedPart);
+	saved->basename = g_strdup (basename);
+	saved->headers_digest = g_strdup (headers_digest);
+
+	return saved;
+}
+
+static void
+saved_part_free (gpointer ptr)
+{
+	SavedPart *saved = ptr;
+
+	if (!saved)
+		return;
+
+	g_free (saved->basename);
+	g_free (saved->headers_digest);
+	g_slice_free (SavedPart, saved);
+}
+
+static void
+snapshot_parts_free (SnapshotParts *parts)
+{
+	if (!parts)
+		return;
+
+	g_hash_table_destroy (parts->saved);
+	g_mutex_clear (&parts->lock);
+	g_free (parts->name_prefix);
+	g_free (parts->checksum);
+	g_slice_free (SnapshotParts, parts);
+}
+
+static SnapshotParts *
+snapshot_parts_ref_for_composer (EMsgComposer *composer)
+{
+	SnapshotParts *parts;
+
+	parts = g_object_get_data (G_OBJECT (composer), SNAPSHOT_PARTS_KEY);
+	if (!parts) {
+		parts = g_slice_new0 (SnapshotParts);
+		g_mutex_init (&parts->lock);
+		parts->saved = g_hash_table_new_full (g_direct_hash, g_direct_equal, g_object_unref, saved_part_free);
+		/* To not clash with files of a recovered snapshot */
+		parts->name_prefix = g_strdup_printf ("part-%" G_GINT64_FORMAT, g_get_real_time ());
+
+		g_object_set_data_full (
+			G_OBJECT (composer),
+			SNAPSHOT_PARTS_KEY, parts,
+			(GDestroyNotify) snapshot_parts_free);
+	}
+
+	return parts;
+}
+
+static gchar *
+snapshot_parts_dup_dirname (GFile *snapshot_file)
+{
+	gchar *path, *dirname;
+
+	path = g_file_get_path (snapshot_file);
+	if (!path)
+		return NULL;
+
+	dirname = g_strconcat (path, SNAPSHOT_PARTS_SUFFIX, NULL);
+
+	g_free (path);
+
+	return dirname;
+}
+
+/* Removes files from the parts directory, which are not in the 'keep' */
+static void
+snapshot_parts_prune_dir (const gchar *dirname,
+			  GHashTable *keep)
+{
+	GDir *dir;
+	const gchar *basename;
+
+	dir = g_dir_open (dirname, 0, NULL);
+	if (!dir)
+		return;
+
+	while ((basename = g_dir_read_name (dir)) != NULL) {
+		if (!keep || !g_hash_table_contains (keep, basename)) {
+			gchar *filename;
+
+			filename = g_build_filename (dirname, basename, NULL);
+			g_unlink (filename);
+			g_free (filename);
+		}
+	}
+
+	g_dir_close (dir);
+}
+
 static void
 delete_snapshot_file (GFile *snapshot_file)
 {
-	g_file_delete (snapshot_file, NULL, NULL);
+	e_composer_delete_snapshot_file (snapshot_file);
 	g_object_unref (snapshot_file);
 }
 
@@ -151,6 +283,71 @@ autosave_composer_created_cb (GObject *source_object,
 	g_free (ccd);
 }
 
+/* Adds the attachments saved separately back to the 'message'. The files
+ * are read synchronously, but this is done only when recovering a snapshot. */
+static void
+load_snapshot_attach_parts (GFile *snapshot_file,
+			    CamelMimeMessage *message)
+{
+	CamelDataWrapper *content;
+	const gchar *header;
+	gchar *dirname;
+	gchar **names;
+	gint ii;
+
+	header = camel_medium_get_header (CAMEL_MEDIUM (message), SNAPSHOT_PARTS_HEADER);
+	if (!header)
+		return;
+
+	content = camel_medium_get_content (CAMEL_MEDIUM (message));
+	dirname = snapshot_parts_dup_dirname (snapshot_file);
+
+	if (!CAMEL_IS_MULTIPART (content) || !dirname) {
+		camel_medium_remove_header (CAMEL_MEDIUM (message), SNAPSHOT_PARTS_HEADER);
+		g_free (dirname);
+		return;
+	}
+
+	names = g_strsplit (header, " ", -1);
+
+	for (ii = 0; names[ii]; ii++) {
+		CamelMimePart *part;
+		CamelStream *stream;
+		gchar *filename;
+		GError *local_error = NULL;
+
+		g_strstrip (names[ii]);
+
+		if (!*names[ii])
+			continue;
+
+		filename = g_build_filename (dirname, names[ii], NULL);
+		stream = camel_stream_fs_new_with_name (filename, O_RDONLY, 0, &local_error);
+
+		if (stream) {
+			part = camel_mime_part_new ();
+
+			if (camel_data_wrapper_construct_from_stream_sync (CAMEL_DATA_WRAPPER (part), stream, NULL, &local_error))
+				camel_multipart_add_part (CAMEL_MULTIPART (content), part);
+
+			g_object_unref (part);
+			g_object_unref (stream);
+		}
+
+		if (local_error) {
+			g_warning ("%s: Failed to read '%s': %s", G_STRFUNC, filename, local_error->message);
+			g_clear_error (&local_error);
+		}
+
+		g_free (filename);
+	}
+
+	camel_medium_remove_header (CAMEL_MEDIUM (message), SNAPSHOT_PARTS_HEADER);
+
+	g_strfreev (names);
+	g_free (dirname);
+}
+
 static void
 load_snapshot_loaded_cb (GFile *snapshot_file,
                          GAsyncResult *result,
@@ -197,6 +394,8 @@ load_snapshot_loaded_cb (GFile *snapshot_file,
 		return;
 	}
 
+	load_snapshot_attach_parts (snapshot_file, message);
+
 	/* g_async_result_get_source_object() returns a new reference. */
 	object = g_async_result_get_source_object (G_ASYNC_RESULT (simple));
 
@@ -235,28 +434,362 @@ save_snapshot_splice_cb (CamelDataWrapper *data_wrapper,
 	g_object_unref (simple);
 }
 
+/* Adds the headers and the content of the 'part' to the 'checksum',
+ * except of the headers, which change with every message build. */
+static gboolean
+save_snapshot_checksum_part (GChecksum *checksum,
+			     CamelMimePart *part,
+			     GCancellable *cancellable,
+			     GError **error)
+{
+	CamelNameValueArray *headers;
+	CamelDataWrapper *content;
+	gboolean success = TRUE;
+	guint ii, len;
+
+	content = camel_medium_get_content (CAMEL_MEDIUM (part));
+
+	headers = camel_medium_dup_headers (CAMEL_MEDIUM (part));
+	len = camel_name_value_array_get_length (headers);
+
+	for (ii = 0; ii < len; ii++) {
+		const gchar *name = NULL, *value = NULL;
+
+		if (!camel_name_value_array_get (headers, ii, &name, &value) || !name)
+			continue;
+
+		/* The multipart boundary is random */
+		if (g_ascii_strcasecmp (name, "Date") == 0 ||
+		    g_ascii_strcasecmp (name, "Message-ID") == 0 ||
+		    (CAMEL_IS_MULTIPART (content) && g_ascii_strcasecmp (name, "Content-Type") == 0))
+			continue;
+
+		g_checksum_update (checksum, (const guchar *) name, -1);
+		g_checksum_update (checksum, (const guchar *) (value ? value : ""), -1);
+	}
+
+	camel_name_value_array_free (headers);
+
+	if (CAMEL_IS_MULTIPART (content)) {
+		CamelMultipart *multipart = CAMEL_MULTIPART (content);
+		gchar *mime_type;
+
+		mime_type = camel_data_wrapper_get_mime_type (content);
+		g_checksum_update (checksum, (const guchar *) (mime_type ? mime_type : ""), -1);
+		g_free (mime_type);
+
+		len = camel_multipart_get_number (multipart);
+
+		for (ii = 0; ii < len && success; ii++) {
+			success = save_snapshot_checksum_part (checksum,
+				camel_multipart_get_part (multipart, ii), cancellable, error);
+		}
+	} else if (CAMEL_IS_MIME_PART (content)) {
+		success = save_snapshot_checksum_part (checksum, CAMEL_MIME_PART (content), cancellable, error);
+	} else if (content) {
+		CamelStream *stream;
+		GByteArray *bytes;
+
+		bytes = g_byte_array_new ();
+		stream = camel_stream_mem_new ();
+		camel_stream_mem_set_byte_array (CAMEL_STREAM_MEM (stream), bytes);
+
+		success = camel_data_wrapper_write_to_stream_sync (content, stream, cancellable, error) >= 0;
+		if (success)
+			g_checksum_update (checksum, bytes->data, bytes->len);
+
+		g_object_unref (stream);
+		g_byte_array_free (bytes, TRUE);
+	}
+
+	return success;
+}
+
+static gboolean
+save_snapshot_write_part (CamelMimePart *part,
+			  const gchar *filename,
+			  GCancellable *cancellable,
+			  GError **error)
+{
+	CamelStream *stream;
+	gboolean success;
+
+	stream = camel_stream_fs_new_with_name (filename, O_WRONLY | O_CREAT | O_TRUNC, 0600, error);
+	if (!stream)
+		return FALSE;
+
+	success = camel_data_wrapper_write_to_stream_sync (CAMEL_DATA_WRAPPER (part), stream, cancellable, error) >= 0 &&
+		camel_stream_flush (stream, cancellable, error) == 0 &&
+		camel_stream_close (stream, cancellable, error) == 0;
+
+	g_object_unref (stream);
+
+	if (!success)
+		g_unlink (filename);
+
+	return success;
+}
+
+static gchar *
+save_snapshot_dup_headers_digest (CamelMimePart *part)
+{
+	CamelNameValueArray *headers;
+	GChecksum *checksum;
+	gchar *digest;
+	guint ii, len;
+
+	checksum = g_checksum_new (G_CHECKSUM_SHA256);
+
+	headers = camel_medium_dup_headers (CAMEL_MEDIUM (part));
+	len = camel_name_value_array_get_length (headers);
+
+	for (ii = 0; ii < len; ii++) {
+		const gchar *name = NULL, *value = NULL;
+
+		if (!camel_name_value_array_get (headers, ii, &name, &value) || !name)
+			continue;
+
+		/* Including the terminating NUL-s, to separate the strings */
+		g_checksum_update (checksum, (const guchar *) name, strlen (name) + 1);
+		g_checksum_update (checksum, (const guchar *) (value ? value : ""), value ? strlen (value) + 1 : 1);
+	}
+
+	camel_name_value_array_free (headers);
+
+	digest = g_strdup (g_checksum_get_string (checksum));
+
+	g_checksum_free (checksum);
+
+	return digest;
+}
+
+/* Moves the attachments of the 'message' into the parts directory, unless
+ * they had been saved there by an earlier snapshot and their headers did
+ * not change since then. The attachments are
+ * the parts after the first one in the top-level multipart/mixed, as built
+ * by the composer. Returns the current attachments with their files, as
+ * CamelMimePart * ~> SavedPart *, or NULL, when the message has no attachments. */
+static GHashTable *
+save_snapshot_detach_parts (SaveContext *context,
+			    CamelMimeMessage *message,
+			    gboolean *out_changed,
+			    GCancellable *cancellable,
+			    GError **error)
+{
+	SnapshotParts *parts = context->parts;
+	CamelDataWrapper *content;
+	CamelMultipart *multipart;
+	GHashTable *current;
+	GHashTableIter iter;
+	gpointer key, value;
+	GString *header;
+	gchar *dirname;
+	gint ii;
+
+	content = camel_medium_get_content (CAMEL_MEDIUM (message));
+
+	if (!CAMEL_IS_MULTIPART (content) ||
+	    !camel_content_type_is (camel_data_wrapper_get_mime_type_field (content), "multipart", "mixed") ||
+	    camel_multipart_get_number (CAMEL_MULTIPART (content)) < 2) {
+		if (g_hash_table_size (parts->saved) > 0) {
+			g_hash_table_remove_all (parts->saved);
+			*out_changed = TRUE;
+		}
+
+		return NULL;
+	}
+
+	errno = 0;
+	dirname = snapshot_parts_dup_dirname (context->snapshot_file);
+	if (!dirname || g_mkdir_with_parents (dirname, 0700) == -1) {
+		g_set_error (
+			error, G_FILE_ERROR,
+			g_file_error_from_errno (errno),
+			"%s", g_strerror (errno));
+		g_free (dirname);
+		return NULL;
+	}
+
+	multipart = CAMEL_MULTIPART (content);
+	current = g_hash_table_new_full (g_direct_hash, g_direct_equal, g_object_unref, saved_part_free);
+	header = g_string_new ("");
+
+	for (ii = camel_multipart_get_number (multipart) - 1; ii >= 1; ii--) {
+		CamelMimePart *part = camel_multipart_get_part (multipart, ii);
+		SavedPart *saved;
+		gchar *headers_digest;
+		gchar *basename;
+
+		headers_digest = save_snapshot_dup_headers_digest (part);
+		saved = g_hash_table_lookup (parts->saved, part);
+
+		/* A part with changed headers is saved into a new file, the old
+		 * file is removed once the snapshot does not reference it */
+		if (saved && g_strcmp0 (saved->headers_digest, headers_digest) == 0) {
+			basename = g_strdup (saved->basename);
+		} else {
+			gchar *filename;
+
+			basename = g_strdup_printf ("%s-%u", parts->name_prefix, parts->next_index++);
+			filename = g_build_filename (dirname, basename, NULL);
+
+			if (!save_snapshot_write_part (part, filename, cancellable, error)) {
+				g_hash_table_destroy (current);
+				g_string_free (header, TRUE);
+				g_free (headers_digest);
+				g_free (basename);
+				g_free (filename);
+				g_free (dirname);
+				return NULL;
+			}
+
+			g_free (filename);
+
+			*out_changed = TRUE;
+		}
+
+		if (header->len)
+			g_string_prepend_c (header, ' ');
+		g_string_prepend (header, basename);
+
+		g_hash_table_insert (current, g_object_ref (part), saved_part_new (basename, headers_digest));
+
+		g_free (headers_digest);
+		g_free (basename);
+
+		camel_multipart_remove_part_at (multipart, ii);
+	}
+
+	camel_medium_set_header (CAMEL_MEDIUM (message), SNAPSHOT_PARTS_HEADER, header->str);
+
+	/* Forget the parts which were removed from the composer */
+	g_hash_table_iter_init (&iter, parts->saved);
+	while (g_hash_table_iter_next (&iter, &key, &value)) {
+		if (!g_hash_table_contains (current, key)) {
+			g_hash_table_iter_remove (&iter);
+			*out_changed = TRUE;
+		}
+	}
+
+	/* Remember the current parts, with their current files */
+	g_hash_table_iter_init (&iter, current);
+	while (g_hash_table_iter_next (&iter, &key, &value)) {
+		SavedPart *saved = value;
+
+		g_hash_table_replace (parts->saved, g_object_ref (key),
+			saved_part_new (saved->basename, saved->headers_digest));
+	}
+
+	g_string_free (header, TRUE);
+	g_free (dirname);
+
+	return current;
+}
+
 static void
-write_message_to_stream_thread (GTask *task,
-				gpointer source_object,
-				gpointer task_data,
-				GCancellable *cancellable)
+save_snapshot_thread (GTask *task,
+		      gpointer source_object,
+		      gpointer task_data,
+		      GCancellable *cancellable)
 {
-	GOutputStream *output_stream;
-	gssize bytes_written;
+	CamelMimeMessage *message = source_object;
+	SaveContext *context = task_data;
+	SnapshotParts *parts = context->parts;
+	GHashTable *current_parts;
+	GChecksum *checksum;
+	gboolean changed = FALSE;
+	gboolean success;
 	GError *local_error = NULL;
 
-	output_stream = task_data;
+	g_mutex_lock (&parts->lock);
+
+	current_parts = save_snapshot_detach_parts (context, message, &changed, cancellable, &local_error);
+
+	if (local_error) {
+		g_clear_pointer (&parts->checksum, g_free);
+		g_mutex_unlock (&parts->lock);
+		g_task_return_error (task, local_error);
+		return;
+	}
+
+	/* These change with each build of the message */
+	camel_medium_remove_header (CAMEL_MEDIUM (message), "Date");
+	camel_medium_remove_header (CAMEL_MEDIUM (message), "Message-ID");
+
+	checksum = g_checksum_new (G_CHECKSUM_SHA256);
+	success = save_snapshot_checksum_part (checksum, CAMEL_MIME_PART (message), cancellable, &local_error);
+
+	/* Skip the write when nothing changed since the previous snapshot */
+	if (success && (changed || g_strcmp0 (parts->checksum, g_checksum_get_string (checksum)) != 0)) {
+		CamelStream *stream;
+		GByteArray *bytes;
+
+		bytes = g_byte_array_new ();
+		stream = camel_stream_mem_new ();
+		camel_stream_mem_set_byte_array (CAMEL_STREAM_MEM (stream), bytes);
+
+		success = camel_data_wrapper_write_to_stream_sync (
+			CAMEL_DATA_WRAPPER (message), stream, cancellable, &local_error) >= 0 &&
+			g_file_replace_contents (
+				context->snapshot_file, (const gchar *) bytes->data, bytes->len,
+				NULL, FALSE, G_FILE_CREATE_PRIVATE, NULL,
+				cancellable, &local_error);
 
-	bytes_written = camel_data_wrapper_decode_to_output_stream_sync (
-		CAMEL_DATA_WRAPPER (source_object),
-		output_stream, cancellable, &local_error);
+		g_object_unref (stream);
+		g_byte_array_free (bytes, TRUE);
 
-	g_output_stream_close (output_stream, cancellable, local_error ? NULL : &local_error);
+		g_free (parts->checksum);
+		parts->checksum = success ? g_strdup (g_checksum_get_string (checksum)) : NULL;
+
+		/* Only after the snapshot file does not reference them anymore */
+		if (success) {
+			gchar *dirname;
+
+			dirname = snapshot_parts_dup_dirname (context->snapshot_file);
+			if (dirname) {
+				GHashTable *keep = NULL;
+
+				if (current_parts) {
+					GHashTableIter iter;
+					gpointer value;
+
+					keep = g_hash_table_new (g_str_hash, g_str_equal);
+
+					g_hash_table_iter_init (&iter, current_parts);
+					while (g_hash_table_iter_next (&iter, NULL, &value)) {
+						SavedPart *saved = value;
+
+						g_hash_table_add (keep, saved->basename);
+					}
+				}
+
+				snapshot_parts_prune_dir (dirname, keep);
+
+				if (!keep)
+					g_rmdir (dirname);
+				else
+					g_hash_table_destroy (keep);
+
+				g_free (dirname);
+			}
+		}
+	}
+
+	/* Make sure the next snapshot is written */
+	if (!success)
+		g_clear_pointer (&parts->checksum, g_free);
+
+	g_checksum_free (checksum);
+
+	if (current_parts)
+		g_hash_table_destroy (current_parts);
+
+	g_mutex_unlock (&parts->lock);
 
 	if (local_error != NULL) {
 		g_task_return_error (task, local_error);
 	} else {
-		g_task_return_int (task, bytes_written);
+		g_task_return_int (task, 0);
 	}
 }
 
@@ -287,53 +820,15 @@ save_snapshot_get_message_cb (EMsgComposer *composer,
 
 	task = g_task_new (message, context->cancellable, (GAsyncReadyCallback) save_snapshot_splice_cb, simple);
 
-	g_task_set_task_data (task, g_object_ref (context->output_stream), g_object_unref);
+	/* The 'simple' owns the 'context' and it is freed only after the task finishes */
+	g_task_set_task_data (task, context, NULL);
 
-	g_task_run_in_thread (task, write_message_to_stream_thread);
+	g_task_run_in_thread (task, save_snapshot_thread);
 
 	g_object_unref (task);
 	g_object_unref (message);
 }
 
-static void
-save_snapshot_replace_cb (GFile *snapshot_file,
-                          GAsyncResult *result,
-                          GSimpleAsyncResult *simple)
-{
-	GObject *object;
-	SaveContext *context;
-	GFileOutputStream *output_stream;
-	GError *local_error = NULL;
-
-	context = g_simple_async_result_get_op_res_gpointer (simple);
-
-	/* Output stream might be NULL, so don't use cast macro. */
-	output_stream = g_file_replace_finish (
-		snapshot_file, result, &local_error);
-	context->output_stream = (GOutputStream *) output_stream;
-
-	if (local_error != NULL) {
-		g_warn_if_fail (output_stream == NULL);
-		g_simple_async_result_take_error (simple, local_error);
-		g_simple_async_result_complete (simple);
-		g_object_unref (simple);
-		return;
-	}
-
-	g_return_if_fail (G_IS_OUTPUT_STREAM (output_stream));
-
-	/* g_async_result_get_source_object() returns a new reference. */
-	object = g_async_result_get_source_object (G_ASYNC_RESULT (simple));
-
-	/* Extract a MIME message from the composer. */
-	e_msg_composer_get_message_draft (
-		E_MSG_COMPOSER (object), G_PRIORITY_DEFAULT,
-		context->cancellable, (GAsyncReadyCallback)
-		save_snapshot_get_message_cb, simple);
-
-	g_object_unref (object);
-}
-
 static EMsgComposer *
 composer_registry_lookup (GQueue *registry,
                           const gchar *basename)
@@ -387,7 +882,8 @@ e_composer_find_orphans (GQueue *registry,
 		struct stat st;
 
 		/* Is this a snapshot file? */
-		if (!g_str_has_prefix (basename, SNAPSHOT_FILE_PREFIX))
+		if (!g_str_has_prefix (basename, SNAPSHOT_FILE_PREFIX) ||
+		    g_str_has_suffix (basename, SNAPSHOT_PARTS_SUFFIX))
 			continue;
 
 		/* Is this an orphaned snapshot file? */
@@ -524,11 +1020,14 @@ e_composer_save_snapshot (EMsgComposer *composer,
 
 	g_return_if_fail (G_IS_FILE (snapshot_file));
 
-	g_file_replace_async (
-		snapshot_file, NULL, FALSE,
-		G_FILE_CREATE_PRIVATE, G_PRIORITY_DEFAULT,
+	context->snapshot_file = g_object_ref (snapshot_file);
+	context->parts = snapshot_parts_ref_for_composer (composer);
+
+	/* Extract a MIME message from the composer. */
+	e_msg_composer_get_message_draft (
+		composer, G_PRIORITY_DEFAULT,
 		context->cancellable, (GAsyncReadyCallback)
-		save_snapshot_replace_cb, simple);
+		save_snapshot_get_message_cb, simple);
 }
 
 gboolean
@@ -584,3 +1083,20 @@ e_composer_allow_snapshot_file_delete (EMsgComposer *composer)
 			snapshot_file, (GDestroyNotify) delete_snapshot_file);
 	}
 }
+
+void
+e_composer_delete_snapshot_file (GFile *snapshot_file)
+{
+	gchar *dirname;
+
+	g_return_if_fail (G_IS_FILE (snapshot_file));
+
+	g_file_delete (snapshot_file, NULL, NULL);
+
+	dirname = snapshot_parts_dup_dirname (snapshot_file);
+	if (dirname) {
+		snapshot_parts_prune_dir (dirname, NULL);
+		g_rmdir (dirname);
+		g_free (dirname);
+	}
+}
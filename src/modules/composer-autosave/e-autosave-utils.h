@@ -45,6 +45,7 @@ void		e_composer_prevent_snapshot_file_delete
 						(EMsgComposer *composer);
 void		e_composer_allow_snapshot_file_delete
 						(EMsgComposer *composer);
+void		e_composer_delete_snapshot_file	(GFile *snapshot_file);
 
 G_END_DECLS
 
@@ -214,7 +214,7 @@ composer_autosave_msg_composer_before_destroy_cb (EMsgComposer *composer,
 				e_msg_composer_get_shell (composer), autosave->priv->malfunction_snapshot_file, NULL,
 				composer_autosave_recovered_cb, NULL);
 		} else {
-			g_file_delete (autosave->priv->malfunction_snapshot_file, NULL, NULL);
+			e_composer_delete_snapshot_file (autosave->priv->malfunction_snapshot_file);
 		}
 	}
 }
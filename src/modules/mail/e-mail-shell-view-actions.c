@@ -1177,37 +1177,18 @@ action_mail_label_cb (GtkToggleAction *action,
 	EMailShellContent *mail_shell_content;
 	EMailReader *reader;
 	EMailView *mail_view;
-	CamelFolder *folder;
-	GPtrArray *uids;
-	const gchar *tag;
-	gint ii;
+	const gchar *tags[2];
 
-	tag = g_object_get_data (G_OBJECT (action), "tag");
-	g_return_if_fail (tag != NULL);
+	tags[0] = g_object_get_data (G_OBJECT (action), "tag");
+	tags[1] = NULL;
+	g_return_if_fail (tags[0] != NULL);
 
 	mail_shell_content = mail_shell_view->priv->mail_shell_content;
 	mail_view = e_mail_shell_content_get_mail_view (mail_shell_content);
 
 	reader = E_MAIL_READER (mail_view);
-	folder = e_mail_reader_ref_folder (reader);
-	uids = e_mail_reader_get_selected_uids (reader);
-
-	camel_folder_freeze (folder);
-	for (ii = 0; ii < uids->len; ii++) {
-		if (gtk_toggle_action_get_active (action))
-			camel_folder_set_message_user_flag (
-				folder, uids->pdata[ii], tag, TRUE);
-		else {
-			camel_folder_set_message_user_flag (
-				folder, uids->pdata[ii], tag, FALSE);
-			camel_folder_set_message_user_tag (
-				folder, uids->pdata[ii], "label", NULL);
-		}
-	}
-	camel_folder_thaw (folder);
 
-	g_clear_object (&folder);
-	g_ptr_array_unref (uids);
+	e_mail_reader_set_selected_labels (reader, tags, gtk_toggle_action_get_active (action));
 }
 
 static void
@@ -1224,16 +1205,14 @@ action_mail_label_new_cb (GtkAction *action,
 	EMailSession *session;
 	EMailReader *reader;
 	EMailView *mail_view;
-	CamelFolder *folder;
 	GtkTreeModel *model;
 	GtkTreeIter iter;
 	GtkWidget *dialog;
-	GPtrArray *uids;
 	GdkColor label_color;
 	const gchar *label_name;
+	const gchar *tags[2];
 	gchar *label_tag;
 	gint n_children;
-	guint ii;
 
 	shell_view = E_SHELL_VIEW (mail_shell_view);
 	shell_window = e_shell_view_get_shell_window (shell_view);
@@ -1272,15 +1251,11 @@ action_mail_label_new_cb (GtkAction *action,
 	mail_view = e_mail_shell_content_get_mail_view (mail_shell_content);
 
 	reader = E_MAIL_READER (mail_view);
-	folder = e_mail_reader_ref_folder (reader);
-	uids = e_mail_reader_get_selected_uids (reader);
 
-	for (ii = 0; ii < uids->len; ii++)
-		camel_folder_set_message_user_flag (
-			folder, uids->pdata[ii], label_tag, TRUE);
+	tags[0] = label_tag;
+	tags[1] = NULL;
 
-	g_clear_object (&folder);
-	g_ptr_array_unref (uids);
+	e_mail_reader_set_selected_labels (reader, tags, TRUE);
 
 	g_free (label_tag);
 
@@ -1300,11 +1275,9 @@ action_mail_label_none_cb (GtkAction *action,
 	EMailLabelListStore *label_store;
 	EMailReader *reader;
 	EMailView *mail_view;
-	CamelFolder *folder;
 	GtkTreeIter iter;
-	GPtrArray *uids;
+	GPtrArray *tags;
 	gboolean valid;
-	guint ii;
 
 	shell_view = E_SHELL_VIEW (mail_shell_view);
 	shell_backend = e_shell_view_get_shell_backend (shell_view);
@@ -1318,32 +1291,24 @@ action_mail_label_none_cb (GtkAction *action,
 	mail_view = e_mail_shell_content_get_mail_view (mail_shell_content);
 
 	reader = E_MAIL_READER (mail_view);
-	folder = e_mail_reader_ref_folder (reader);
-	uids = e_mail_reader_get_selected_uids (reader);
+	tags = g_ptr_array_new_with_free_func (g_free);
 
 	valid = gtk_tree_model_get_iter_first (
 		GTK_TREE_MODEL (label_store), &iter);
 
 	while (valid) {
-		gchar *tag;
-
-		tag = e_mail_label_list_store_get_tag (label_store, &iter);
-
-		for (ii = 0; ii < uids->len; ii++) {
-			camel_folder_set_message_user_flag (
-				folder, uids->pdata[ii], tag, FALSE);
-			camel_folder_set_message_user_tag (
-				folder, uids->pdata[ii], "label", NULL);
-		}
-
-		g_free (tag);
+		g_ptr_array_add (tags, e_mail_label_list_store_get_tag (label_store, &iter));
 
 		valid = gtk_tree_model_iter_next (
 			GTK_TREE_MODEL (label_store), &iter);
 	}
 
-	g_clear_object (&folder);
-	g_ptr_array_unref (uids);
+	g_ptr_array_add (tags, NULL);
+
+	/* Unsets all the labels on each message in one pass */
+	e_mail_reader_set_selected_labels (reader, (const gchar * const *) tags->pdata, FALSE);
+
+	g_ptr_array_unref (tags);
 }
 
 static void
@@ -181,6 +181,7 @@ mail_shell_view_setup_search_results_folder (CamelFolder *folder,
 	msg->stores_list = stores;
 
 	id = msg->base.seq;
+	mail_msg_set_priority (msg, MAIL_MSG_PRIORITY_INTERACTIVE);
 	mail_msg_slow_ordered_push (msg);
 
 	return id;
@@ -295,6 +296,7 @@ mail_shell_view_setup_search_results_folder_and_subfolders (CamelFolder *vfolder
 	msg->root_folder = g_object_ref (root_folder);
 
 	id = msg->base.seq;
+	mail_msg_set_priority (msg, MAIL_MSG_PRIORITY_INTERACTIVE);
 	mail_msg_slow_ordered_push (msg);
 
 	return id;
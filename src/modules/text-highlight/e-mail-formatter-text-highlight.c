@@ -43,10 +43,23 @@ struct _TextHighlightClosure {
 	gboolean wrote_anything;
 	CamelStream *read_stream;
 	GOutputStream *output_stream;
+	GByteArray *highlighted;
 	GCancellable *cancellable;
 	GError *error;
 };
 
+/* The highlighted HTML is remembered for recently formatted parts, keyed by
+ * a checksum of the 'highlight' arguments and of the part content, thus
+ * re-rendering a message or returning to it does not run the 'highlight'
+ * again. The cache is shared by all formatters and bounded by its total size. */
+#define TEXT_HIGHLIGHT_CACHE_MAX_SIZE	(8 * 1024 * 1024)
+#define TEXT_HIGHLIGHT_CACHE_MAX_ITEM	(TEXT_HIGHLIGHT_CACHE_MAX_SIZE / 4)
+
+static GMutex text_highlight_cache_lock;
+static GHashTable *text_highlight_cache = NULL; /* gchar *checksum ~> GBytes *html */
+static GQueue text_highlight_cache_lru = G_QUEUE_INIT; /* gchar *checksum, the most recent first */
+static gsize text_highlight_cache_size = 0;
+
 GType e_mail_formatter_text_highlight_get_type (void);
 
 G_DEFINE_DYNAMIC_TYPE (
@@ -130,6 +143,168 @@ get_syntax (EMailPart *part,
 	return syntax;
 }
 
+static gchar *
+text_highlight_cache_compute_key (const gchar **argv,
+				  GBytes *content)
+{
+	GChecksum *checksum;
+	gconstpointer data;
+	gsize data_len = 0;
+	gchar *key;
+	gint ii;
+
+	checksum = g_checksum_new (G_CHECKSUM_SHA256);
+
+	for (ii = 0; argv[ii]; ii++) {
+		/* Including the nul-terminator, to separate the arguments */
+		g_checksum_update (checksum, (const guchar *) argv[ii], strlen (argv[ii]) + 1);
+	}
+
+	data = g_bytes_get_data (content, &data_len);
+	if (data && data_len)
+		g_checksum_update (checksum, data, data_len);
+
+	key = g_strdup (g_checksum_get_string (checksum));
+
+	g_checksum_free (checksum);
+
+	return key;
+}
+
+static GBytes *
+text_highlight_cache_lookup (const gchar *key)
+{
+	GBytes *html = NULL;
+	GList *link;
+
+	g_mutex_lock (&text_highlight_cache_lock);
+
+	if (text_highlight_cache) {
+		html = g_hash_table_lookup (text_highlight_cache, key);
+
+		if (html) {
+			g_bytes_ref (html);
+
+			link = g_queue_find_custom (&text_highlight_cache_lru, key, (GCompareFunc) g_strcmp0);
+			if (link && link != text_highlight_cache_lru.head) {
+				gpointer data = link->data;
+
+				g_queue_delete_link (&text_highlight_cache_lru, link);
+				g_queue_push_head (&text_highlight_cache_lru, data);
+			}
+		}
+	}
+
+	g_mutex_unlock (&text_highlight_cache_lock);
+
+	return html;
+}
+
+static void
+text_highlight_cache_add (const gchar *key,
+			  GBytes *html)
+{
+	gsize size = g_bytes_get_size (html);
+
+	if (size > TEXT_HIGHLIGHT_CACHE_MAX_ITEM)
+		return;
+
+	g_mutex_lock (&text_highlight_cache_lock);
+
+	if (!text_highlight_cache)
+		text_highlight_cache = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, (GDestroyNotify) g_bytes_unref);
+
+	if (!g_hash_table_contains (text_highlight_cache, key)) {
+		gchar *key_copy = g_strdup (key);
+
+		while (text_highlight_cache_size + size > TEXT_HIGHLIGHT_CACHE_MAX_SIZE &&
+		       !g_queue_is_empty (&text_highlight_cache_lru)) {
+			gchar *oldest = g_queue_pop_tail (&text_highlight_cache_lru);
+			GBytes *oldest_html = g_hash_table_lookup (text_highlight_cache, oldest);
+
+			if (oldest_html)
+				text_highlight_cache_size -= g_bytes_get_size (oldest_html);
+
+			/* This frees also the 'oldest' */
+			g_hash_table_remove (text_highlight_cache, oldest);
+		}
+
+		/* The key is shared between the hash table and the queue */
+		g_hash_table_insert (text_highlight_cache, key_copy, g_bytes_ref (html));
+		g_queue_push_head (&text_highlight_cache_lru, key_copy);
+		text_highlight_cache_size += size;
+	}
+
+	g_mutex_unlock (&text_highlight_cache_lock);
+}
+
+static void
+text_highlight_cache_clear (void)
+{
+	g_mutex_lock (&text_highlight_cache_lock);
+
+	g_queue_clear (&text_highlight_cache_lru);
+	g_clear_pointer (&text_highlight_cache, g_hash_table_destroy);
+	text_highlight_cache_size = 0;
+
+	g_mutex_unlock (&text_highlight_cache_lock);
+}
+
+/* Decodes the content of the 'data_wrapper' into memory and converts it
+ * to UTF-8 charset, if needed, which the 'highlight' expects; it can cope
+ * with non-UTF-8 letters, thus no need for a content UTF-8-validation. */
+static GBytes *
+text_highlight_decode_content (CamelDataWrapper *data_wrapper,
+			       GCancellable *cancellable,
+			       GError **error)
+{
+	CamelContentType *content_type;
+	CamelStream *mem_stream, *write_stream;
+	GByteArray *byte_array;
+	gboolean success;
+
+	byte_array = g_byte_array_new ();
+	mem_stream = camel_stream_mem_new ();
+	camel_stream_mem_set_byte_array (CAMEL_STREAM_MEM (mem_stream), byte_array);
+
+	write_stream = g_object_ref (mem_stream);
+
+	content_type = camel_data_wrapper_get_mime_type_field (data_wrapper);
+	if (content_type) {
+		const gchar *charset = camel_content_type_param (content_type, "charset");
+
+		if (charset && g_ascii_strcasecmp (charset, "utf-8") != 0) {
+			CamelMimeFilter *filter;
+
+			filter = camel_mime_filter_charset_new (charset, "UTF-8");
+			if (filter != NULL) {
+				CamelStream *filtered = camel_stream_filter_new (write_stream);
+
+				if (filtered) {
+					camel_stream_filter_add (CAMEL_STREAM_FILTER (filtered), filter);
+					g_object_unref (write_stream);
+					write_stream = filtered;
+				}
+
+				g_object_unref (filter);
+			}
+		}
+	}
+
+	success = camel_data_wrapper_decode_to_stream_sync (data_wrapper, write_stream, cancellable, error) >= 0 &&
+		camel_stream_flush (write_stream, cancellable, error) == 0;
+
+	g_object_unref (write_stream);
+	g_object_unref (mem_stream);
+
+	if (!success) {
+		g_byte_array_free (byte_array, TRUE);
+		return NULL;
+	}
+
+	return g_byte_array_free_to_bytes (byte_array);
+}
+
 static gpointer
 text_hightlight_read_data_thread (gpointer user_data)
 {
@@ -152,6 +327,13 @@ text_hightlight_read_data_thread (gpointer user_data)
 
 		closure->wrote_anything = closure->wrote_anything || read > 0;
 
+		if (closure->highlighted) {
+			if (closure->highlighted->len + read > TEXT_HIGHLIGHT_CACHE_MAX_ITEM)
+				g_clear_pointer (&closure->highlighted, g_byte_array_unref);
+			else
+				g_byte_array_append (closure->highlighted, (const guint8 *) buffer, read);
+		}
+
 		if (!g_output_stream_write_all (closure->output_stream, buffer, read, &wrote, closure->cancellable, &closure->error) ||
 		    (gssize) wrote != read || closure->error)
 			break;
@@ -162,23 +344,31 @@ text_hightlight_read_data_thread (gpointer user_data)
 	return NULL;
 }
 
+/* Writes the 'content' to the 'highlight' and its output to the 'output_stream'.
+ * The output is also returned in the 'out_highlighted', when it's not too large
+ * to be cached. */
 static gboolean
 text_highlight_feed_data (GOutputStream *output_stream,
-                          CamelDataWrapper *data_wrapper,
+                          GBytes *content,
                           gint pipe_stdin,
                           gint pipe_stdout,
+                          GBytes **out_highlighted,
                           GCancellable *cancellable,
                           GError **error)
 {
 	TextHighlightClosure closure;
-	CamelContentType *content_type;
 	CamelStream *write_stream;
+	gconstpointer data;
+	gsize data_len = 0;
 	gboolean success = TRUE;
 	GThread *thread;
 
+	*out_highlighted = NULL;
+
 	closure.wrote_anything = FALSE;
 	closure.read_stream = camel_stream_fs_new_with_fd (pipe_stdout);
 	closure.output_stream = output_stream;
+	closure.highlighted = g_byte_array_new ();
 	closure.cancellable = cancellable;
 	closure.error = NULL;
 
@@ -186,31 +376,9 @@ text_highlight_feed_data (GOutputStream *output_stream,
 
 	thread = g_thread_new (NULL, text_hightlight_read_data_thread, &closure);
 
-	content_type = camel_data_wrapper_get_mime_type_field (data_wrapper);
-	if (content_type) {
-		const gchar *charset = camel_content_type_param (content_type, "charset");
-
-		/* Convert to UTF-8 charset, if needed, which the 'highlight' expects;
-		   it can cope with non-UTF-8 letters, thus no need for a content UTF-8-validation */
-		if (charset && g_ascii_strcasecmp (charset, "utf-8") != 0) {
-			CamelMimeFilter *filter;
-
-			filter = camel_mime_filter_charset_new (charset, "UTF-8");
-			if (filter != NULL) {
-				CamelStream *filtered = camel_stream_filter_new (write_stream);
-
-				if (filtered) {
-					camel_stream_filter_add (CAMEL_STREAM_FILTER (filtered), filter);
-					g_object_unref (write_stream);
-					write_stream = filtered;
-				}
-
-				g_object_unref (filter);
-			}
-		}
-	}
+	data = g_bytes_get_data (content, &data_len);
 
-	if (camel_data_wrapper_decode_to_stream_sync (data_wrapper, write_stream, cancellable, error) < 0) {
+	if (data_len > 0 && camel_stream_write (write_stream, data, data_len, cancellable, error) < 0) {
 		g_cancellable_cancel (cancellable);
 		success = FALSE;
 	} else {
@@ -229,9 +397,19 @@ text_highlight_feed_data (GOutputStream *output_stream,
 		else
 			g_clear_error (&closure.error);
 
+		if (closure.highlighted)
+			g_byte_array_unref (closure.highlighted);
+
 		return FALSE;
 	}
 
+	if (closure.highlighted) {
+		if (success && closure.wrote_anything)
+			*out_highlighted = g_byte_array_free_to_bytes (closure.highlighted);
+		else
+			g_byte_array_unref (closure.highlighted);
+	}
+
 	return success && closure.wrote_anything;
 }
 
@@ -271,6 +449,8 @@ emfe_text_highlight_format (EMailFormatterExtension *extension,
 		gint pipe_stdin, pipe_stdout;
 		GPid pid;
 		CamelDataWrapper *dw;
+		GBytes *content, *highlighted;
+		gchar *cache_key;
 		gchar *font_family, *font_size, *syntax, *theme;
 		PangoFontDescription *fd;
 		GSettings *settings;
@@ -371,16 +551,31 @@ emfe_text_highlight_format (EMailFormatterExtension *extension,
 		g_free (syntax);
 		g_free (theme);
 
-		success = g_spawn_async_with_pipes (
-			NULL, (gchar **) argv, NULL, 0, NULL, NULL,
-			&pid, &pipe_stdin, &pipe_stdout, NULL, NULL);
+		content = text_highlight_decode_content (dw, cancellable, NULL);
+		cache_key = content ? text_highlight_cache_compute_key (argv, content) : NULL;
+		highlighted = cache_key ? text_highlight_cache_lookup (cache_key) : NULL;
+
+		if (highlighted) {
+			success = g_output_stream_write_all (
+				stream,
+				g_bytes_get_data (highlighted, NULL),
+				g_bytes_get_size (highlighted),
+				NULL, cancellable, NULL);
+		} else if (content) {
+			success = g_spawn_async_with_pipes (
+				NULL, (gchar **) argv, NULL, 0, NULL, NULL,
+				&pid, &pipe_stdin, &pipe_stdout, NULL, NULL);
+		} else {
+			success = FALSE;
+		}
 
-		if (success) {
+		if (success && !highlighted) {
 			GError *local_error = NULL;
 
 			success = text_highlight_feed_data (
-				stream, dw,
+				stream, content,
 				pipe_stdin, pipe_stdout,
+				&highlighted,
 				cancellable, &local_error);
 
 			if (g_error_matches (
@@ -397,8 +592,17 @@ emfe_text_highlight_format (EMailFormatterExtension *extension,
 			g_clear_error (&local_error);
 
 			g_spawn_close_pid (pid);
+
+			if (success && highlighted)
+				text_highlight_cache_add (cache_key, highlighted);
 		}
 
+		if (highlighted)
+			g_bytes_unref (highlighted);
+		if (content)
+			g_bytes_unref (content);
+		g_free (cache_key);
+
 		if (!success) {
 			/* We can't call e_mail_formatter_format_as on text/plain,
 			 * because text-highlight is registered as an handler for
@@ -504,6 +708,7 @@ e_mail_formatter_text_highlight_class_init (EMailFormatterExtensionClass *class)
 static void
 e_mail_formatter_text_highlight_class_finalize (EMailFormatterExtensionClass *class)
 {
+	text_highlight_cache_clear ();
 }
 
 static void
@@ -2296,6 +2296,10 @@ webkit_editor_set_spell_checking_languages (EContentEditor *editor,
 	wk_editor = E_WEBKIT_EDITOR (editor);
 	web_context = webkit_web_view_get_context (WEBKIT_WEB_VIEW (wk_editor));
 	webkit_web_context_set_spell_checking_languages (web_context, (const gchar * const *) languages);
+
+	if (wk_editor->priv->spell_check_enabled && wk_editor->priv->web_extension)
+		webkit_editor_call_simple_extension_function (
+			wk_editor, "DOMSpellCheckLanguagesChanged");
 }
 
 static void
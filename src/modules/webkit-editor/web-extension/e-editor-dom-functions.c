@@ -34,6 +34,9 @@
 #define HTML_KEY_CODE_DELETE 46
 #define HTML_KEY_CODE_TABULATOR 9
 
+/* Number of remembered spell checked blocks, after which the list is cleared */
+#define MAX_SPELL_CHECKED_BLOCKS 4096
+
 /* ******************** Tests ******************** */
 
 static gchar *
@@ -648,6 +651,125 @@ perform_spell_check (WebKitDOMDOMSelection *dom_selection,
 	g_clear_object (&actual);
 }
 
+/* Returns the child of the @body, which contains the @node, or NULL */
+static WebKitDOMNode *
+get_top_level_block (WebKitDOMNode *node,
+                     WebKitDOMNode *body)
+{
+	WebKitDOMNode *parent;
+
+	while (node && (parent = webkit_dom_node_get_parent_node (node)) != body)
+		node = parent;
+
+	return node;
+}
+
+/* Remembers the current content of the @block and returns whether
+ * it changed since the last time it had been spell checked. */
+static gboolean
+spell_check_block_changed (GHashTable *checked_blocks,
+                           WebKitDOMNode *block)
+{
+	gpointer stored_hash;
+	gchar *content;
+	guint hash;
+
+	if (WEBKIT_DOM_IS_ELEMENT (block))
+		content = webkit_dom_element_get_outer_html (WEBKIT_DOM_ELEMENT (block));
+	else
+		content = webkit_dom_node_get_text_content (block);
+
+	hash = g_str_hash (content ? content : "");
+	g_free (content);
+
+	if (g_hash_table_lookup_extended (checked_blocks, block, NULL, &stored_hash) &&
+	    GPOINTER_TO_UINT (stored_hash) == hash)
+		return FALSE;
+
+	g_hash_table_insert (checked_blocks, g_object_ref (block), GUINT_TO_POINTER (hash));
+
+	return TRUE;
+}
+
+static void
+spell_check_blocks_run (WebKitDOMDocument *document,
+                        WebKitDOMDOMSelection *dom_selection,
+                        WebKitDOMNode *first,
+                        WebKitDOMNode *last)
+{
+	WebKitDOMRange *end_range, *actual;
+	WebKitDOMText *text;
+
+	/* Insert some text after the last block */
+	text = webkit_dom_document_create_text_node (document, "-x-evo-end");
+	webkit_dom_node_insert_before (
+		webkit_dom_node_get_parent_node (last),
+		WEBKIT_DOM_NODE (text),
+		webkit_dom_node_get_next_sibling (last),
+		NULL);
+
+	/* Create range that's pointing on the end of this text */
+	end_range = webkit_dom_document_create_range (document);
+	webkit_dom_range_select_node_contents (
+		end_range, WEBKIT_DOM_NODE (text), NULL);
+	webkit_dom_range_collapse (end_range, FALSE, NULL);
+
+	/* Move on the beginning of the first block */
+	actual = webkit_dom_document_create_range (document);
+	webkit_dom_range_select_node_contents (actual, first, NULL);
+	webkit_dom_range_collapse (actual, TRUE, NULL);
+	webkit_dom_dom_selection_remove_all_ranges (dom_selection);
+	webkit_dom_dom_selection_add_range (dom_selection, actual);
+	g_clear_object (&actual);
+
+	actual = webkit_dom_dom_selection_get_range_at (dom_selection, 0, NULL);
+	perform_spell_check (dom_selection, actual, end_range);
+
+	g_clear_object (&end_range);
+	g_clear_object (&actual);
+
+	/* Remove the text that we inserted after the last block */
+	remove_node (WEBKIT_DOM_NODE (text));
+}
+
+/* Spell checks only those top-level blocks between the @first and the @last
+ * (inclusive), which changed since the last check. Consecutive changed blocks
+ * are checked in one run. */
+static void
+spell_check_changed_blocks (EEditorPage *editor_page,
+                            WebKitDOMDOMSelection *dom_selection,
+                            WebKitDOMNode *first,
+                            WebKitDOMNode *last)
+{
+	WebKitDOMDocument *document;
+	WebKitDOMNode *node, *run_first = NULL, *run_last = NULL;
+	GHashTable *checked_blocks;
+
+	document = e_editor_page_get_document (editor_page);
+	checked_blocks = e_editor_page_get_spell_checked_blocks (editor_page);
+
+	/* Forget also the blocks, which are not part of the document anymore */
+	if (g_hash_table_size (checked_blocks) > MAX_SPELL_CHECKED_BLOCKS)
+		g_hash_table_remove_all (checked_blocks);
+
+	for (node = first; node; node = webkit_dom_node_get_next_sibling (node)) {
+		if (spell_check_block_changed (checked_blocks, node)) {
+			if (!run_first)
+				run_first = node;
+			run_last = node;
+		} else if (run_first) {
+			spell_check_blocks_run (document, dom_selection, run_first, run_last);
+			run_first = NULL;
+		}
+
+		if (node == last)
+			break;
+	}
+
+	if (run_first)
+		spell_check_blocks_run (document, dom_selection, run_first, run_last);
+}
+
 void
 e_editor_dom_force_spell_check_for_current_paragraph (EEditorPage *editor_page)
 {
@@ -795,34 +917,46 @@ refresh_spell_check (EEditorPage *editor_page,
 	 * when we are moving with caret */
 	e_editor_page_block_selection_changed (editor_page);
 
-	/* Append some text on the end of the body */
-	text = webkit_dom_document_create_text_node (document, "-x-evo-end");
-	webkit_dom_node_append_child (
-		WEBKIT_DOM_NODE (body), WEBKIT_DOM_NODE (text), NULL);
-
-	/* Create range that's pointing on the end of this text */
-	end_range = webkit_dom_document_create_range (document);
-	webkit_dom_range_select_node_contents (
-		end_range, WEBKIT_DOM_NODE (text), NULL);
-	webkit_dom_range_collapse (end_range, FALSE, NULL);
-
 	dom_window = webkit_dom_document_get_default_view (document);
 	dom_selection = webkit_dom_dom_window_get_selection (dom_window);
 
-	/* Move on the beginning of the document */
-	webkit_dom_dom_selection_modify (
-		dom_selection, "move", "backward", "documentboundary");
+	if (enable_spell_check) {
+		/* Check only what changed since the last check */
+		spell_check_changed_blocks (
+			editor_page,
+			dom_selection,
+			webkit_dom_node_get_first_child (WEBKIT_DOM_NODE (body)),
+			webkit_dom_node_get_last_child (WEBKIT_DOM_NODE (body)));
+	} else {
+		g_hash_table_remove_all (e_editor_page_get_spell_checked_blocks (editor_page));
 
-	actual = webkit_dom_dom_selection_get_range_at (dom_selection, 0, NULL);
-	perform_spell_check (dom_selection, actual, end_range);
+		/* Append some text on the end of the body */
+		text = webkit_dom_document_create_text_node (document, "-x-evo-end");
+		webkit_dom_node_append_child (
+			WEBKIT_DOM_NODE (body), WEBKIT_DOM_NODE (text), NULL);
+
+		/* Create range that's pointing on the end of this text */
+		end_range = webkit_dom_document_create_range (document);
+		webkit_dom_range_select_node_contents (
+			end_range, WEBKIT_DOM_NODE (text), NULL);
+		webkit_dom_range_collapse (end_range, FALSE, NULL);
+
+		/* Move on the beginning of the document */
+		webkit_dom_dom_selection_modify (
+			dom_selection, "move", "backward", "documentboundary");
+
+		actual = webkit_dom_dom_selection_get_range_at (dom_selection, 0, NULL);
+		perform_spell_check (dom_selection, actual, end_range);
+
+		g_clear_object (&end_range);
+		g_clear_object (&actual);
+
+		/* Remove the text that we inserted on the end of the body */
+		remove_node (WEBKIT_DOM_NODE (text));
+	}
 
 	g_clear_object (&dom_selection);
 	g_clear_object (&dom_window);
-	g_clear_object (&end_range);
-	g_clear_object (&actual);
-
-	/* Remove the text that we inserted on the end of the body */
-	remove_node (WEBKIT_DOM_NODE (text));
 
 	e_editor_dom_selection_restore (editor_page);
 	/* Unblock the callbacks */
@@ -845,8 +979,8 @@ e_editor_dom_force_spell_check_in_viewport (EEditorPage *editor_page)
 	WebKitDOMDOMWindow *dom_window = NULL;
 	WebKitDOMElement *last_element;
 	WebKitDOMHTMLElement *body;
-	WebKitDOMRange *end_range = NULL, *actual = NULL;
-	WebKitDOMText *text;
+	WebKitDOMNode *first = NULL, *last = NULL;
+	WebKitDOMRange *actual = NULL;
 	glong viewport_height;
 
 	g_return_if_fail (E_IS_EDITOR_PAGE (editor_page));
@@ -872,8 +1006,13 @@ e_editor_dom_force_spell_check_in_viewport (EEditorPage *editor_page)
 	if (!actual)
 		goto out;
 
-	/* Append some text on the end of the body */
-	text = webkit_dom_document_create_text_node (document, "-x-evo-end");
+	first = get_top_level_block (
+		webkit_dom_range_get_start_container (actual, NULL),
+		WEBKIT_DOM_NODE (body));
+	if (!first)
+		first = webkit_dom_node_get_first_child (WEBKIT_DOM_NODE (body));
+
+	g_clear_object (&actual);
 
 	dom_window = webkit_dom_document_get_default_view (document);
 	dom_selection = webkit_dom_dom_window_get_selection (dom_window);
@@ -882,33 +1021,16 @@ e_editor_dom_force_spell_check_in_viewport (EEditorPage *editor_page)
 	viewport_height = webkit_dom_dom_window_get_inner_height (dom_window);
 	last_element = webkit_dom_document_element_from_point (document, 10, viewport_height - 10);
 	if (last_element && !WEBKIT_DOM_IS_HTML_HTML_ELEMENT (last_element) &&
-	    !WEBKIT_DOM_IS_HTML_BODY_ELEMENT (last_element)) {
-		WebKitDOMElement *parent;
-
-		parent = get_parent_block_element (WEBKIT_DOM_NODE (last_element));
-		webkit_dom_node_append_child (
-			WEBKIT_DOM_NODE (parent ? parent : last_element), WEBKIT_DOM_NODE (text), NULL);
-	} else
-		webkit_dom_node_append_child (
-			WEBKIT_DOM_NODE (body), WEBKIT_DOM_NODE (text), NULL);
-
-	/* Create range that's pointing on the end of viewport */
-	end_range = webkit_dom_document_create_range (document);
-	webkit_dom_range_select_node_contents (
-		end_range, WEBKIT_DOM_NODE (text), NULL);
-	webkit_dom_range_collapse (end_range, FALSE, NULL);
+	    !WEBKIT_DOM_IS_HTML_BODY_ELEMENT (last_element))
+		last = get_top_level_block (WEBKIT_DOM_NODE (last_element), WEBKIT_DOM_NODE (body));
+	if (!last)
+		last = webkit_dom_node_get_last_child (WEBKIT_DOM_NODE (body));
 
-	webkit_dom_dom_selection_remove_all_ranges (dom_selection);
-	webkit_dom_dom_selection_add_range (dom_selection, actual);
-	perform_spell_check (dom_selection, actual, end_range);
+	/* Check only the blocks in the viewport, which changed since the last check */
+	spell_check_changed_blocks (editor_page, dom_selection, first, last);
 
 	g_clear_object (&dom_selection);
 	g_clear_object (&dom_window);
-	g_clear_object (&end_range);
-	g_clear_object (&actual);
-
-	/* Remove the text that we inserted on the end of the body */
-	remove_node (WEBKIT_DOM_NODE (text));
 
  out:
 	e_editor_dom_selection_restore (editor_page);
@@ -925,6 +1047,18 @@ e_editor_dom_force_spell_check (EEditorPage *editor_page)
 		refresh_spell_check (editor_page, TRUE);
 }
 
+void
+e_editor_dom_spell_check_languages_changed (EEditorPage *editor_page)
+{
+	g_return_if_fail (E_IS_EDITOR_PAGE (editor_page));
+
+	/* Everything has to be checked again with the new languages; the blocks
+	 * outside of the viewport are checked once they are scrolled into it. */
+	g_hash_table_remove_all (e_editor_page_get_spell_checked_blocks (editor_page));
+
+	e_editor_dom_force_spell_check_in_viewport (editor_page);
+}
+
 gboolean
 e_editor_dom_node_is_citation_node (WebKitDOMNode *node)
 {
@@ -82,6 +82,8 @@ void		e_editor_dom_force_spell_check_for_current_paragraph
 void		e_editor_dom_force_spell_check_in_viewport
 						(EEditorPage *editor_page);
 void		e_editor_dom_force_spell_check	(EEditorPage *editor_page);
+void		e_editor_dom_spell_check_languages_changed
+						(EEditorPage *editor_page);
 void		e_editor_dom_turn_spell_check_off
 						(EEditorPage *editor_page);
 void		e_editor_dom_embed_style_sheet	(EEditorPage *editor_page,
@@ -67,6 +67,7 @@ struct _EEditorPagePrivate {
 	gboolean processing_keypress_event;
 
 	GHashTable *inline_images;
+	GHashTable *spell_checked_blocks; /* WebKitDOMNode * ~> hash of its content */
 
 	WebKitDOMNode *node_under_mouse_click;
 
@@ -86,6 +87,7 @@ web_page_document_loaded_cb (WebKitWebPage *web_page,
 	editor_page->priv->body_input_event_removed = TRUE;
 
 	e_editor_undo_redo_manager_clean_history (editor_page->priv->undo_redo_manager);
+	g_hash_table_remove_all (editor_page->priv->spell_checked_blocks);
 	e_editor_dom_process_content_after_load (editor_page);
 }
 
@@ -205,6 +207,7 @@ e_editor_page_dispose (GObject *object)
 	g_clear_object (&editor_page->priv->spell_checker);
 
 	g_hash_table_remove_all (editor_page->priv->inline_images);
+	g_hash_table_remove_all (editor_page->priv->spell_checked_blocks);
 
 	/* Chain up to parent's method. */
 	G_OBJECT_CLASS (e_editor_page_parent_class)->dispose (object);
@@ -216,6 +219,7 @@ e_editor_page_finalize (GObject *object)
 	EEditorPage *editor_page = E_EDITOR_PAGE (object);
 
 	g_hash_table_destroy (editor_page->priv->inline_images);
+	g_hash_table_destroy (editor_page->priv->spell_checked_blocks);
 
 	/* Chain up to parent's method. */
 	G_OBJECT_CLASS (e_editor_page_parent_class)->finalize (object);
@@ -262,6 +266,7 @@ e_editor_page_init (EEditorPage *editor_page)
 	editor_page->priv->mail_settings = e_util_ref_settings ("org.gnome.evolution.mail");
 	editor_page->priv->word_wrap_length = g_settings_get_int (editor_page->priv->mail_settings, "composer-word-wrap-length");
 	editor_page->priv->inline_images = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_free);
+	editor_page->priv->spell_checked_blocks = g_hash_table_new_full (g_direct_hash, g_direct_equal, g_object_unref, NULL);
 	editor_page->priv->spell_checker = e_spell_checker_new ();
 }
 
@@ -719,6 +724,14 @@ e_editor_page_get_inline_images (EEditorPage *editor_page)
 	return editor_page->priv->inline_images;
 }
 
+GHashTable *
+e_editor_page_get_spell_checked_blocks (EEditorPage *editor_page)
+{
+	g_return_val_if_fail (E_IS_EDITOR_PAGE (editor_page), NULL);
+
+	return editor_page->priv->spell_checked_blocks;
+}
+
 void
 e_editor_page_add_new_inline_image_into_list (EEditorPage *editor_page,
                                               const gchar *cid_src,
@@ -163,6 +163,8 @@ void		e_editor_page_set_convert_in_situ
 						 gint16 top_signature);
 GHashTable *	e_editor_page_get_inline_images
 						(EEditorPage *editor_page);
+GHashTable *	e_editor_page_get_spell_checked_blocks
+						(EEditorPage *editor_page);
 void		e_editor_page_add_new_inline_image_into_list
 						(EEditorPage *editor_page,
 						 const gchar *cid_src,
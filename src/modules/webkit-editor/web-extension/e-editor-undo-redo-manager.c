@@ -18,6 +18,8 @@
 
 #include "evolution-config.h"
 
+#include <string.h>
+
 #include <webkitdom/webkitdom.h>
 
 #include "web-extensions/e-dom-utils.h"
@@ -37,6 +39,10 @@ struct _EEditorUndoRedoManagerPrivate {
 
 	GList *history;
 	guint history_size;
+
+	/* EEditorHistoryEvent * ~> estimated size in bytes */
+	GHashTable *history_costs;
+	gsize history_cost;
 };
 
 enum {
@@ -82,7 +88,9 @@ const gchar* event_type_string[] = {
 	"HISTORY_UNQUOTE"
 };
 
-#define HISTORY_SIZE_LIMIT 30
+/* The oldest events are dropped once the whole history
+ * is estimated to take more memory than this. */
+#define HISTORY_COST_LIMIT (4 * 1024 * 1024)
 
 G_DEFINE_TYPE (EEditorUndoRedoManager, e_editor_undo_redo_manager, G_TYPE_OBJECT)
 
@@ -1379,6 +1387,280 @@ undo_redo_link_dialog (EEditorPage *editor_page,
 		e_editor_dom_selection_restore (editor_page);
 }
 
+static gboolean
+node_is_selection_marker (WebKitDOMNode *node)
+{
+	return WEBKIT_DOM_IS_ELEMENT (node) && (
+		element_has_id (WEBKIT_DOM_ELEMENT (node), "-x-evo-selection-start-marker") ||
+		element_has_id (WEBKIT_DOM_ELEMENT (node), "-x-evo-selection-end-marker"));
+}
+
+/* The selection markers can be saved into the document while a change is
+ * applied, thus the child indexes of the change do not count them. */
+static WebKitDOMNode *
+get_next_child_node (WebKitDOMNode *child)
+{
+	while (child && node_is_selection_marker (child))
+		child = webkit_dom_node_get_next_sibling (child);
+
+	return child;
+}
+
+static guint
+count_child_nodes (WebKitDOMNode *node)
+{
+	WebKitDOMNode *child;
+	guint count = 0;
+
+	for (child = get_next_child_node (webkit_dom_node_get_first_child (node));
+	     child;
+	     child = get_next_child_node (webkit_dom_node_get_next_sibling (child)))
+		count++;
+
+	return count;
+}
+
+static WebKitDOMNode *
+get_nth_child_node (WebKitDOMNode *node,
+                    guint index)
+{
+	WebKitDOMNode *child;
+
+	child = get_next_child_node (webkit_dom_node_get_first_child (node));
+	while (child && index-- > 0)
+		child = get_next_child_node (webkit_dom_node_get_next_sibling (child));
+
+	return child;
+}
+
+static gboolean
+node_contains_selection_marker (WebKitDOMNode *node)
+{
+	if (node_is_selection_marker (node))
+		return TRUE;
+
+	return WEBKIT_DOM_IS_ELEMENT (node) && webkit_dom_element_query_selector (
+		WEBKIT_DOM_ELEMENT (node),
+		"#-x-evo-selection-start-marker, #-x-evo-selection-end-marker", NULL);
+}
+
+static gboolean
+node_has_selection_marker_child (WebKitDOMNode *node)
+{
+	WebKitDOMNode *child;
+
+	for (child = webkit_dom_node_get_first_child (node); child; child = webkit_dom_node_get_next_sibling (child)) {
+		if (node_is_selection_marker (child))
+			return TRUE;
+	}
+
+	return FALSE;
+}
+
+static gboolean
+dom_change_nodes_equal (WebKitDOMNode *from,
+                        WebKitDOMNode *to)
+{
+	/* The nodes with the selection markers are never reused, because
+	 * the markers can be elsewhere when the change is applied. */
+	return !node_contains_selection_marker (from) &&
+		!node_contains_selection_marker (to) &&
+		webkit_dom_node_is_equal_node (from, to);
+}
+
+static gboolean
+dom_change_elements_shallow_equal (WebKitDOMNode *from,
+                                   WebKitDOMNode *to)
+{
+	WebKitDOMNode *from_clone, *to_clone;
+
+	if (!WEBKIT_DOM_IS_ELEMENT (from) || !WEBKIT_DOM_IS_ELEMENT (to))
+		return FALSE;
+
+	from_clone = webkit_dom_node_clone_node_with_error (from, FALSE, NULL);
+	to_clone = webkit_dom_node_clone_node_with_error (to, FALSE, NULL);
+
+	return webkit_dom_node_is_equal_node (from_clone, to_clone);
+}
+
+static WebKitDOMNode *
+dom_change_extract_children (WebKitDOMNode *node,
+                             guint first,
+                             guint count)
+{
+	WebKitDOMNode *part, *child;
+
+	part = g_object_ref (webkit_dom_node_clone_node_with_error (node, FALSE, NULL));
+
+	child = get_nth_child_node (node, first);
+	while (child && count-- > 0) {
+		webkit_dom_node_append_child (
+			part, webkit_dom_node_clone_node_with_error (child, TRUE, NULL), NULL);
+		child = webkit_dom_node_get_next_sibling (child);
+	}
+
+	return part;
+}
+
+/* Replaces the deep copies of the changed node in the @change with
+ * the smallest subtree that differs between them, so the history
+ * keeps and applies only what the edit really touched. */
+static void
+compact_dom_change (EEditorDOMChange *change)
+{
+	WebKitDOMNode *from, *to;
+	GArray *path;
+
+	if (change->path || !change->from || !change->to)
+		return;
+
+	from = change->from;
+	to = change->to;
+
+	if (!WEBKIT_DOM_IS_ELEMENT (from) || !WEBKIT_DOM_IS_ELEMENT (to) ||
+	    node_has_selection_marker_child (from) || node_has_selection_marker_child (to))
+		return;
+
+	path = g_array_new (FALSE, FALSE, sizeof (guint));
+
+	while (TRUE) {
+		WebKitDOMNode *from_child, *to_child;
+		guint n_from, n_to, prefix = 0, suffix = 0;
+
+		n_from = count_child_nodes (from);
+		n_to = count_child_nodes (to);
+
+		from_child = webkit_dom_node_get_first_child (from);
+		to_child = webkit_dom_node_get_first_child (to);
+		while (from_child && to_child && dom_change_nodes_equal (from_child, to_child)) {
+			from_child = webkit_dom_node_get_next_sibling (from_child);
+			to_child = webkit_dom_node_get_next_sibling (to_child);
+			prefix++;
+		}
+
+		if (prefix < n_from && prefix < n_to) {
+			WebKitDOMNode *from_last, *to_last;
+
+			from_last = webkit_dom_node_get_last_child (from);
+			to_last = webkit_dom_node_get_last_child (to);
+			while (prefix + suffix < n_from && prefix + suffix < n_to &&
+			       dom_change_nodes_equal (from_last, to_last)) {
+				from_last = webkit_dom_node_get_previous_sibling (from_last);
+				to_last = webkit_dom_node_get_previous_sibling (to_last);
+				suffix++;
+			}
+		}
+
+		/* Only one child changed, but not its own attributes,
+		 * thus look for the change inside of it. */
+		if (n_from - prefix - suffix == 1 && n_to - prefix - suffix == 1 &&
+		    dom_change_elements_shallow_equal (from_child, to_child) &&
+		    !node_has_selection_marker_child (from_child) &&
+		    !node_has_selection_marker_child (to_child)) {
+			g_array_append_val (path, prefix);
+			from = from_child;
+			to = to_child;
+			continue;
+		}
+
+		from = dom_change_extract_children (from, prefix, n_from - prefix - suffix);
+		to = dom_change_extract_children (to, prefix, n_to - prefix - suffix);
+
+		g_clear_object (&change->from);
+		g_clear_object (&change->to);
+
+		change->from = from;
+		change->to = to;
+		change->path = path;
+		change->prefix = prefix;
+		change->suffix = suffix;
+		break;
+	}
+}
+
+static void
+copy_element_attributes (WebKitDOMElement *target,
+                         WebKitDOMElement *source)
+{
+	WebKitDOMNamedNodeMap *attributes;
+	gint length, ii;
+
+	attributes = webkit_dom_element_get_attributes (target);
+	length = webkit_dom_named_node_map_get_length (attributes);
+	for (ii = length - 1; ii >= 0; ii--)
+		webkit_dom_element_remove_attribute_node (
+			target,
+			WEBKIT_DOM_ATTR (webkit_dom_named_node_map_item (attributes, ii)),
+			NULL);
+	g_clear_object (&attributes);
+
+	attributes = webkit_dom_element_get_attributes (source);
+	length = webkit_dom_named_node_map_get_length (attributes);
+	for (ii = 0; ii < length; ii++) {
+		gchar *name, *value;
+		WebKitDOMNode *node = webkit_dom_named_node_map_item (attributes, ii);
+
+		name = webkit_dom_attr_get_name (WEBKIT_DOM_ATTR (node));
+		value = webkit_dom_node_get_node_value (node);
+
+		webkit_dom_element_set_attribute (target, name, value, NULL);
+
+		g_free (name);
+		g_free (value);
+	}
+	g_clear_object (&attributes);
+}
+
+/* Changes the @node to the state before (@undo is TRUE) or after
+ * the @change. A compacted change touches only the changed children. */
+static void
+apply_dom_change (WebKitDOMNode *node,
+                  EEditorDOMChange *change,
+                  gboolean undo)
+{
+	WebKitDOMNode *stored, *child, *part;
+	guint ii, n_children;
+
+	stored = undo ? change->from : change->to;
+
+	if (!change->path) {
+		webkit_dom_node_replace_child (
+			webkit_dom_node_get_parent_node (node),
+			webkit_dom_node_clone_node_with_error (stored, TRUE, NULL),
+			node,
+			NULL);
+		return;
+	}
+
+	for (ii = 0; ii < change->path->len && node; ii++)
+		node = get_nth_child_node (node, g_array_index (change->path, guint, ii));
+
+	if (!node || !WEBKIT_DOM_IS_ELEMENT (node))
+		return;
+
+	copy_element_attributes (WEBKIT_DOM_ELEMENT (node), WEBKIT_DOM_ELEMENT (stored));
+
+	n_children = count_child_nodes (node);
+	child = get_nth_child_node (node, change->prefix);
+	for (ii = change->prefix; child && ii + change->suffix < n_children; ii++) {
+		WebKitDOMNode *next_sibling;
+
+		next_sibling = get_next_child_node (webkit_dom_node_get_next_sibling (child));
+		remove_node (child);
+		child = next_sibling;
+	}
+
+	/* Here the 'child' is the first unchanged child after the change;
+	 * selection markers from the changed range stay before the new parts */
+	for (part = webkit_dom_node_get_first_child (stored); part; part = webkit_dom_node_get_next_sibling (part)) {
+		webkit_dom_node_insert_before (
+			node,
+			webkit_dom_node_clone_node_with_error (part, TRUE, NULL),
+			child,
+			NULL);
+	}
+}
+
 static void
 undo_redo_table_dialog (EEditorPage *editor_page,
                         EEditorHistoryEvent *event,
@@ -1418,20 +1700,12 @@ undo_redo_table_dialog (EEditorPage *editor_page,
 		if (!event->data.dom.from)
 			remove_node (WEBKIT_DOM_NODE (table));
 		else
-			webkit_dom_node_replace_child (
-				webkit_dom_node_get_parent_node (WEBKIT_DOM_NODE (table)),
-				webkit_dom_node_clone_node_with_error (event->data.dom.from, TRUE, NULL),
-				WEBKIT_DOM_NODE (table),
-				NULL);
+			apply_dom_change (WEBKIT_DOM_NODE (table), &event->data.dom, TRUE);
 	} else {
 		if (!event->data.dom.to)
 			remove_node (WEBKIT_DOM_NODE (table));
 		else
-			webkit_dom_node_replace_child (
-				webkit_dom_node_get_parent_node (WEBKIT_DOM_NODE (table)),
-				webkit_dom_node_clone_node_with_error (event->data.dom.to, TRUE, NULL),
-				WEBKIT_DOM_NODE (table),
-				NULL);
+			apply_dom_change (WEBKIT_DOM_NODE (table), &event->data.dom, FALSE);
 	}
 
 	if (undo)
@@ -1480,11 +1754,7 @@ undo_redo_table_input (EEditorPage *editor_page,
 	if (!WEBKIT_DOM_IS_HTML_TABLE_CELL_ELEMENT (element))
 		return;
 
-	webkit_dom_node_replace_child (
-		webkit_dom_node_get_parent_node (WEBKIT_DOM_NODE (element)),
-		webkit_dom_node_clone_node_with_error (undo ? event->data.dom.from : event->data.dom.to, TRUE, NULL),
-		WEBKIT_DOM_NODE (element),
-		NULL);
+	apply_dom_change (WEBKIT_DOM_NODE (element), &event->data.dom, undo);
 
 	e_editor_dom_selection_restore (editor_page);
 }
@@ -2216,6 +2486,91 @@ e_editor_undo_redo_manager_set_operation_in_progress (EEditorUndoRedoManager *ma
 	manager->priv->operation_in_progress = value;
 }
 
+static gsize
+estimate_node_cost (WebKitDOMNode *node)
+{
+	gchar *text;
+	gsize cost;
+
+	if (!node)
+		return 0;
+
+	/* Rough, but proportional to what the node holds */
+	text = webkit_dom_node_get_text_content (node);
+	cost = 256 + (text ? strlen (text) * 2 : 0);
+	g_free (text);
+
+	return cost;
+}
+
+static gsize
+estimate_history_event_cost (EEditorHistoryEvent *event)
+{
+	gsize cost = sizeof (EEditorHistoryEvent);
+
+	switch (event->type) {
+		case HISTORY_INPUT:
+		case HISTORY_DELETE:
+		case HISTORY_CITATION_SPLIT:
+		case HISTORY_IMAGE:
+		case HISTORY_SMILEY:
+		case HISTORY_REMOVE_LINK:
+			cost += estimate_node_cost (WEBKIT_DOM_NODE (event->data.fragment));
+			break;
+		case HISTORY_FONT_COLOR:
+		case HISTORY_PASTE:
+		case HISTORY_PASTE_AS_TEXT:
+		case HISTORY_PASTE_QUOTED:
+		case HISTORY_INSERT_HTML:
+		case HISTORY_REPLACE:
+		case HISTORY_REPLACE_ALL:
+			if (event->data.string.from)
+				cost += strlen (event->data.string.from);
+			if (event->data.string.to)
+				cost += strlen (event->data.string.to);
+			break;
+		case HISTORY_HRULE_DIALOG:
+		case HISTORY_IMAGE_DIALOG:
+		case HISTORY_CELL_DIALOG:
+		case HISTORY_TABLE_DIALOG:
+		case HISTORY_TABLE_INPUT:
+		case HISTORY_PAGE_DIALOG:
+		case HISTORY_UNQUOTE:
+		case HISTORY_LINK_DIALOG:
+			cost += estimate_node_cost (event->data.dom.from);
+			cost += estimate_node_cost (event->data.dom.to);
+			break;
+		default:
+			break;
+	}
+
+	return cost;
+}
+
+/* Called for the current event once it cannot be changed anymore */
+static void
+finish_history_event (EEditorUndoRedoManager *manager,
+                      EEditorHistoryEvent *event)
+{
+	gsize cost;
+
+	switch (event->type) {
+		case HISTORY_TABLE_DIALOG:
+		case HISTORY_TABLE_INPUT:
+			compact_dom_change (&event->data.dom);
+			break;
+		default:
+			break;
+	}
+
+	manager->priv->history_cost -= GPOINTER_TO_SIZE (g_hash_table_lookup (manager->priv->history_costs, event));
+
+	cost = estimate_history_event_cost (event);
+	g_hash_table_insert (manager->priv->history_costs, event, GSIZE_TO_POINTER (cost));
+
+	manager->priv->history_cost += cost;
+}
+
 static void
 free_history_event (EEditorHistoryEvent *event)
 {
@@ -2256,6 +2611,8 @@ free_history_event (EEditorHistoryEvent *event)
 				g_clear_object (&event->data.dom.from);
 			if (event->data.dom.to != NULL)
 				g_clear_object (&event->data.dom.to);
+			if (event->data.dom.path != NULL)
+				g_array_free (event->data.dom.path, TRUE);
 			break;
 		default:
 			break;
@@ -2268,6 +2625,9 @@ static void
 remove_history_event (EEditorUndoRedoManager *manager,
                       GList *item)
 {
+	manager->priv->history_cost -= GPOINTER_TO_SIZE (g_hash_table_lookup (manager->priv->history_costs, item->data));
+	g_hash_table_remove (manager->priv->history_costs, item->data);
+
 	free_history_event (item->data);
 	manager->priv->history = g_list_delete_link (manager->priv->history, item);
 	manager->priv->history_size--;
@@ -2307,21 +2667,28 @@ e_editor_undo_redo_manager_insert_history_event (EEditorUndoRedoManager *manager
 
 	remove_forward_redo_history_events_if_needed (manager);
 
-	if (manager->priv->history_size >= HISTORY_SIZE_LIMIT) {
+	if (manager->priv->history)
+		finish_history_event (manager, manager->priv->history->data);
+
+	manager->priv->history = g_list_prepend (manager->priv->history, event);
+	manager->priv->history_size++;
+
+	finish_history_event (manager, event);
+
+	/* Keep the start of the history and the new event */
+	while (manager->priv->history_cost > HISTORY_COST_LIMIT && manager->priv->history_size > 2) {
 		EEditorHistoryEvent *prev_event;
 		GList *item;
 
 		remove_history_event (manager, g_list_last (manager->priv->history)->prev);
 		while ((item = g_list_last (manager->priv->history)) && (item = item->prev) &&
+		       item != manager->priv->history &&
 		       (prev_event = item->data) && prev_event->type == HISTORY_AND) {
 			remove_history_event (manager, g_list_last (manager->priv->history)->prev);
 			remove_history_event (manager, g_list_last (manager->priv->history)->prev);
 		}
 	}
 
-	manager->priv->history = g_list_prepend (manager->priv->history, event);
-	manager->priv->history_size++;
-
 	if (camel_debug ("webkit:undo"))
 		print_history (manager);
 
@@ -2830,6 +3197,8 @@ e_editor_undo_redo_manager_clean_history (EEditorUndoRedoManager *manager)
 		manager->priv->history = NULL;
 	}
 
+	g_hash_table_remove_all (manager->priv->history_costs);
+	manager->priv->history_cost = 0;
 	manager->priv->history_size = 0;
 	editor_page = editor_undo_redo_manager_ref_editor_page (manager);
 	g_return_if_fail (editor_page != NULL);
@@ -2866,12 +3235,28 @@ editor_undo_redo_manager_dispose (GObject *object)
 		priv->history = NULL;
 	}
 
+	g_hash_table_remove_all (priv->history_costs);
+	priv->history_cost = 0;
+
 	g_weak_ref_set (&priv->editor_page, NULL);
 
 	/* Chain up to parent's dispose() method. */
 	G_OBJECT_CLASS (e_editor_undo_redo_manager_parent_class)->dispose (object);
 }
 
+static void
+editor_undo_redo_manager_finalize (GObject *object)
+{
+	EEditorUndoRedoManagerPrivate *priv;
+
+	priv = E_EDITOR_UNDO_REDO_MANAGER_GET_PRIVATE (object);
+
+	g_hash_table_destroy (priv->history_costs);
+
+	/* Chain up to parent's finalize() method. */
+	G_OBJECT_CLASS (e_editor_undo_redo_manager_parent_class)->finalize (object);
+}
+
 static void
 editor_undo_redo_manager_get_property (GObject *object,
                                        guint property_id,
@@ -2921,6 +3306,7 @@ e_editor_undo_redo_manager_class_init (EEditorUndoRedoManagerClass *class)
 
 	object_class = G_OBJECT_CLASS (class);
 	object_class->dispose = editor_undo_redo_manager_dispose;
+	object_class->finalize = editor_undo_redo_manager_finalize;
 	object_class->get_property = editor_undo_redo_manager_get_property;
 	object_class->set_property = editor_undo_redo_manager_set_property;
 
@@ -2979,4 +3365,6 @@ e_editor_undo_redo_manager_init (EEditorUndoRedoManager *manager)
 	manager->priv->operation_in_progress = FALSE;
 	manager->priv->history = NULL;
 	manager->priv->history_size = 0;
+	manager->priv->history_costs = g_hash_table_new (g_direct_hash, g_direct_equal);
+	manager->priv->history_cost = 0;
 }
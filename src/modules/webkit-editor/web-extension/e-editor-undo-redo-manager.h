@@ -89,6 +89,15 @@ typedef struct {
 typedef struct {
 	WebKitDOMNode *from; /* From what node we are changing. */
 	WebKitDOMNode *to; /* To what node we are changing. */
+
+	/* Set once the change is compacted by the undo/redo manager. Then
+	 * 'from' and 'to' are shallow copies of the element at 'path' (child
+	 * indexes from the changed node) holding only its changed children,
+	 * which are preceded by 'prefix' and followed by 'suffix' unchanged
+	 * children. */
+	GArray *path;
+	guint prefix;
+	guint suffix;
 } EEditorDOMChange;
 
 typedef struct {
@@ -414,6 +414,9 @@ static const gchar *introspection_xml =
 "    <method name='DOMTurnSpellCheckOff'>"
 "      <arg type='t' name='page_id' direction='in'/>"
 "    </method>"
+"    <method name='DOMSpellCheckLanguagesChanged'>"
+"      <arg type='t' name='page_id' direction='in'/>"
+"    </method>"
 "    <method name='DOMScrollToCaret'>"
 "      <arg type='t' name='page_id' direction='in'/>"
 "    </method>"
@@ -1652,6 +1655,15 @@ handle_method_call (GDBusConnection *connection,
 
 		e_editor_dom_turn_spell_check_off (editor_page);
 		g_dbus_method_invocation_return_value (invocation, NULL);
+	} else if (g_strcmp0 (method_name, "DOMSpellCheckLanguagesChanged") == 0) {
+		g_variant_get (parameters, "(t)", &page_id);
+
+		editor_page = get_editor_page_or_return_dbus_error (invocation, extension, page_id);
+		if (!editor_page)
+			goto error;
+
+		e_editor_dom_spell_check_languages_changed (editor_page);
+		g_dbus_method_invocation_return_value (invocation, NULL);
 	} else if (g_strcmp0 (method_name, "DOMQuoteAndInsertTextIntoSelection") == 0) {
 		gboolean is_html = FALSE;
 		const gchar *text;
@@ -48,12 +48,15 @@ struct bbdb_stuff {
 
 /* Static forward declarations */
 static gboolean bbdb_timeout (gpointer data);
-static void bbdb_do_it (EBookClient *client, const gchar *name, const gchar *email);
+static void bbdb_do_them (EBookClient *client, GSList *todos);
 static void add_email_to_contact (EContact *contact, const gchar *email);
 static void enable_toggled_cb (GtkWidget *widget, gpointer data);
 static void source_changed_cb (ESourceComboBox *source_combo_box, struct bbdb_stuff *stuff);
 static GtkWidget *bbdb_create_config_widget (void);
 
+/* How many recipients are looked up with one address book query */
+#define BBDB_QUERY_BATCH_SIZE 50
+
 /* How often check, in minutes. Read only on plugin enable. Use <= 0 to disable polling. */
 static gint
 get_check_interval (void)
@@ -141,16 +144,18 @@ todo_queue_clear (void)
 	G_UNLOCK (todo);
 }
 
-static todo_struct *
-todo_queue_pop (void)
+/* Takes all the queued recipients, in the order they were queued */
+static GSList *
+todo_queue_pop_all (void)
 {
-	todo_struct *td;
+	GSList *todos = NULL;
 
 	G_LOCK (todo);
-	td = g_queue_pop_head (&todo);
+	while (!g_queue_is_empty (&todo))
+		todos = g_slist_prepend (todos, g_queue_pop_tail (&todo));
 	G_UNLOCK (todo);
 
-	return td;
+	return todos;
 }
 
 static gpointer
@@ -163,11 +168,11 @@ todo_queue_process_thread (gpointer data)
 		AUTOMATIC_CONTACTS_ADDRESSBOOK, NULL, &error);
 
 	if (client != NULL) {
-		todo_struct *td;
+		GSList *todos;
 
-		while ((td = todo_queue_pop ()) != NULL) {
-			bbdb_do_it (client, td->name, td->email);
-			free_todo_struct (td);
+		while ((todos = todo_queue_pop_all ()) != NULL) {
+			bbdb_do_them (client, todos);
+			g_slist_free_full (todos, (GDestroyNotify) free_todo_struct);
 		}
 
 		g_object_unref (client);
@@ -290,15 +295,222 @@ bbdb_handle_send (EPlugin *ep,
 	}
 }
 
+typedef struct {
+	gchar *name;
+	const gchar *email;
+} BBDBRecipient;
+
+static void
+bbdb_recipient_free (gpointer ptr)
+{
+	BBDBRecipient *recipient = ptr;
+
+	if (recipient) {
+		g_free (recipient->name);
+		g_slice_free (BBDBRecipient, recipient);
+	}
+}
+
+/* Returns unique recipients with an e-mail address, with
+   the name filled from the e-mail when there is none */
+static GSList *
+bbdb_collect_recipients (GSList *todos)
+{
+	GHashTable *known_emails;
+	GSList *recipients = NULL, *link;
+
+	known_emails = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+
+	for (link = todos; link; link = g_slist_next (link)) {
+		todo_struct *td = link->data;
+		BBDBRecipient *recipient;
+		const gchar *delim;
+		gchar *email_key;
+
+		if (!td->email || !*td->email)
+			continue;
+
+		if ((delim = strchr (td->email, '@')) == NULL)
+			continue;
+
+		email_key = g_utf8_strdown (td->email, -1);
+		if (g_hash_table_contains (known_emails, email_key)) {
+			g_free (email_key);
+			continue;
+		}
+
+		g_hash_table_add (known_emails, email_key);
+
+		recipient = g_slice_new0 (BBDBRecipient);
+		recipient->email = td->email;
+
+		/* don't miss the entry if the mail has only e-mail id and no name */
+		if (!td->name || !*td->name) {
+			recipient->name = g_strndup (td->email, delim - td->email);
+		} else if (g_utf8_strchr (td->name, -1, '\"')) {
+			GString *tmp = g_string_new (td->name);
+			gchar *p;
+
+			while (p = g_utf8_strchr (tmp->str, tmp->len, '\"'), p)
+				tmp = g_string_erase (tmp, p - tmp->str, 1);
+
+			recipient->name = g_string_free (tmp, FALSE);
+		} else {
+			recipient->name = g_strdup (td->name);
+		}
+
+		recipients = g_slist_prepend (recipients, recipient);
+	}
+
+	g_hash_table_destroy (known_emails);
+
+	return g_slist_reverse (recipients);
+}
+
+static gboolean
+bbdb_contact_has_email (EContact *contact,
+                        const gchar *email)
+{
+	GList *emails, *link;
+	gboolean found = FALSE;
+
+	emails = e_contact_get (contact, E_CONTACT_EMAIL);
+
+	for (link = emails; link && !found; link = g_list_next (link)) {
+		found = link->data && e_util_utf8_strstrcase (link->data, email) != NULL;
+	}
+
+	g_list_free_full (emails, g_free);
+
+	return found;
+}
+
+static gchar *
+bbdb_build_recipients_query (GSList *recipients,
+                             gint n_recipients)
+{
+	EBookQuery **queries;
+	EBookQuery *query;
+	GSList *link;
+	gchar *query_string;
+	gint ii = 0;
+
+	queries = g_new0 (EBookQuery *, 2 * n_recipients);
+
+	for (link = recipients; link && ii < 2 * n_recipients; link = g_slist_next (link)) {
+		BBDBRecipient *recipient = link->data;
+
+		queries[ii++] = e_book_query_field_test (E_CONTACT_EMAIL, E_BOOK_QUERY_CONTAINS, recipient->email);
+		queries[ii++] = e_book_query_field_test (E_CONTACT_FULL_NAME, E_BOOK_QUERY_IS, recipient->name);
+	}
+
+	query = e_book_query_or (ii, queries, TRUE);
+	query_string = e_book_query_to_string (query);
+	e_book_query_unref (query);
+	g_free (queries);
+
+	return query_string;
+}
+
+/* Resolves the @precipients against the @client, removing those, which are known
+   to it, or which were added to an existing contact with the same name */
 static void
-bbdb_do_it (EBookClient *client,
-            const gchar *name,
-            const gchar *email)
+bbdb_resolve_recipients_in_book (EBookClient *client,
+                                 GSList **precipients)
 {
-	gchar *query_string, *delim, *temp_name = NULL;
-	GSList *contacts = NULL;
-	gboolean status;
-	EContact *contact;
+	GSList *pending = NULL, *batch_start = *precipients;
+	GSList *modified = NULL;
+	GError *error = NULL;
+
+	while (batch_start) {
+		GSList *contacts = NULL, *link, *batch_end;
+		gchar *query_string;
+		gint n_recipients = 0;
+		gboolean status;
+
+		for (batch_end = batch_start; batch_end && n_recipients < BBDB_QUERY_BATCH_SIZE; batch_end = g_slist_next (batch_end))
+			n_recipients++;
+
+		/* One query for all e-mails and names of the batch, matched locally then */
+		query_string = bbdb_build_recipients_query (batch_start, n_recipients);
+		status = e_book_client_get_contacts_sync (client, query_string, &contacts, NULL, NULL);
+		g_free (query_string);
+
+		for (link = batch_start; link != batch_end; link = g_slist_next (link)) {
+			BBDBRecipient *recipient = link->data;
+			EContact *by_name = NULL;
+			GSList *clink;
+			gint n_by_name = 0;
+			gboolean known = FALSE;
+
+			if (!status) {
+				pending = g_slist_prepend (pending, recipient);
+				continue;
+			}
+
+			/* If any contacts exists with this email address, don't do anything */
+			for (clink = contacts; clink && !known; clink = g_slist_next (clink)) {
+				known = bbdb_contact_has_email (clink->data, recipient->email);
+			}
+
+			if (known) {
+				bbdb_recipient_free (recipient);
+				continue;
+			}
+
+			for (clink = contacts; clink; clink = g_slist_next (clink)) {
+				const gchar *full_name = e_contact_get_const (clink->data, E_CONTACT_FULL_NAME);
+
+				if (full_name && e_util_utf8_strcasecmp (full_name, recipient->name) == 0) {
+					by_name = clink->data;
+					n_by_name++;
+				}
+			}
+
+			if (n_by_name == 0) {
+				pending = g_slist_prepend (pending, recipient);
+				continue;
+			}
+
+			/* If a contact exists with this name, add the email address to it.
+			 * FIXME: If there's more than one contact with this
+			 * name, just give up; we're not smart enough for
+			 * this. */
+			if (n_by_name == 1) {
+				add_email_to_contact (by_name, recipient->email);
+
+				if (!g_slist_find (modified, by_name))
+					modified = g_slist_prepend (modified, g_object_ref (by_name));
+			}
+
+			bbdb_recipient_free (recipient);
+		}
+
+		g_slist_free_full (contacts, g_object_unref);
+
+		batch_start = batch_end;
+	}
+
+	if (modified) {
+		e_book_client_modify_contacts_sync (client, modified, NULL, &error);
+
+		if (error != NULL) {
+			g_warning ("bbdb: Could not modify contacts: %s\n", error->message);
+			g_error_free (error);
+		}
+
+		g_slist_free_full (modified, g_object_unref);
+	}
+
+	g_slist_free (*precipients);
+	*precipients = g_slist_reverse (pending);
+}
+
+static void
+bbdb_do_them (EBookClient *client,
+              GSList *todos)
+{
+	GSList *recipients, *new_contacts = NULL, *link;
 	GError *error = NULL;
 	EShell *shell;
 	ESourceRegistry *registry;
@@ -307,24 +519,17 @@ bbdb_do_it (EBookClient *client,
 	GList *addressbooks;
 	GList *aux_addressbooks;
 	GSettings *settings;
+	GHashTable *new_by_name;
 	EBookClient *client_addressbook;
 	ESourceAutocomplete *autocomplete_extension;
-	gboolean on_autocomplete, has_autocomplete;
+	gboolean on_autocomplete, has_autocomplete, file_under_as_first_last;
 
 	g_return_if_fail (client != NULL);
 
-	if (email == NULL || !strcmp (email, ""))
-		return;
-
-	if ((delim = strchr (email, '@')) == NULL)
+	recipients = bbdb_collect_recipients (todos);
+	if (!recipients)
 		return;
 
-	/* don't miss the entry if the mail has only e-mail id and no name */
-	if (!name || !*name) {
-		temp_name = g_strndup (email, delim - email);
-		name = temp_name;
-	}
-
 	/* Search through all addressbooks */
 	shell = e_shell_get_default ();
 	registry = e_shell_get_registry (shell);
@@ -340,25 +545,19 @@ bbdb_do_it (EBookClient *client,
 
 	addressbooks = g_list_prepend (addressbooks, g_object_ref (dest_source));
 
-	aux_addressbooks = addressbooks;
-	while (aux_addressbooks != NULL) {
-
+	for (aux_addressbooks = addressbooks; aux_addressbooks && recipients; aux_addressbooks = aux_addressbooks->next) {
 		if (g_strcmp0 (e_source_get_uid (dest_source), e_source_get_uid (aux_addressbooks->data)) == 0) {
 			client_addressbook = g_object_ref (client);
 		} else {
 			/* Check only addressbooks with autocompletion enabled */
 			has_autocomplete = e_source_has_extension (aux_addressbooks->data, E_SOURCE_EXTENSION_AUTOCOMPLETE);
-			if (!has_autocomplete) {
-				aux_addressbooks = aux_addressbooks->next;
+			if (!has_autocomplete)
 				continue;
-			}
 
 			autocomplete_extension = e_source_get_extension (aux_addressbooks->data, E_SOURCE_EXTENSION_AUTOCOMPLETE);
 			on_autocomplete = e_source_autocomplete_get_include_me (autocomplete_extension);
-			if (!on_autocomplete) {
-				aux_addressbooks = aux_addressbooks->next;
+			if (!on_autocomplete)
 				continue;
-			}
 
 			client_addressbook = (EBookClient *) e_client_cache_get_client_sync (
 					client_cache, (ESource *) aux_addressbooks->data,
@@ -368,123 +567,80 @@ bbdb_do_it (EBookClient *client,
 			if (error != NULL) {
 				g_warning ("bbdb: Failed to get addressbook client: %s\n", error->message);
 				g_clear_error (&error);
-				aux_addressbooks = aux_addressbooks->next;
 				continue;
 			}
 		}
 
-		/* If any contacts exists with this email address, don't do anything */
-		query_string = g_strdup_printf ("(contains \"email\" \"%s\")", email);
-		status = e_book_client_get_contacts_sync (client_addressbook, query_string, &contacts, NULL, NULL);
-		g_free (query_string);
-		if (contacts != NULL || !status) {
-			g_slist_free_full (contacts, g_object_unref);
-			g_object_unref (client_addressbook);
+		bbdb_resolve_recipients_in_book (client_addressbook, &recipients);
 
-			if (!status) {
-				aux_addressbooks = aux_addressbooks->next;
-				continue;
-			}
-
-			g_free (temp_name);
-			g_list_free_full (addressbooks, g_object_unref);
-
-			return;
-		}
-
-		if (g_utf8_strchr (name, -1, '\"')) {
-			GString *tmp = g_string_new (name);
-			gchar *p;
-
-			while (p = g_utf8_strchr (tmp->str, tmp->len, '\"'), p)
-				tmp = g_string_erase (tmp, p - tmp->str, 1);
-
-			g_free (temp_name);
-			temp_name = g_string_free (tmp, FALSE);
-			name = temp_name;
-		}
+		g_object_unref (client_addressbook);
+	}
 
-		contacts = NULL;
-		/* If a contact exists with this name, add the email address to it. */
-		query_string = g_strdup_printf ("(is \"full_name\" \"%s\")", name);
-		status = e_book_client_get_contacts_sync (client_addressbook, query_string, &contacts, NULL, NULL);
-		g_free (query_string);
-		if (contacts != NULL || !status) {
-			/* FIXME: If there's more than one contact with this
-			 * name, just give up; we're not smart enough for
-			 * this. */
-			if (!status || contacts->next != NULL) {
-				g_slist_free_full (contacts, g_object_unref);
-				g_object_unref (client_addressbook);
+	g_list_free_full (addressbooks, (GDestroyNotify) g_object_unref);
 
-				if (!status) {
-					aux_addressbooks = aux_addressbooks->next;
-					continue;
-				}
+	if (!recipients)
+		return;
 
-				g_free (temp_name);
-				g_list_free_full (addressbooks, g_object_unref);
-				return;
-			}
+	settings = e_util_ref_settings (CONF_SCHEMA);
+	file_under_as_first_last = g_settings_get_boolean (settings, CONF_KEY_FILE_UNDER_AS_FIRST_LAST);
+	g_clear_object (&settings);
 
-			contact = (EContact *) contacts->data;
-			add_email_to_contact (contact, email);
+	new_by_name = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
 
-			e_book_client_modify_contact_sync (
-					client_addressbook, contact, NULL, &error);
+	/* Otherwise, create new contacts, one per name. */
+	for (link = recipients; link; link = g_slist_next (link)) {
+		BBDBRecipient *recipient = link->data;
+		EContact *contact;
+		gchar *name_key;
 
-			if (error != NULL) {
-				g_warning ("bbdb: Could not modify contact: %s\n", error->message);
-				g_error_free (error);
-			}
+		name_key = g_utf8_casefold (recipient->name, -1);
+		contact = g_hash_table_lookup (new_by_name, name_key);
 
-			g_slist_free_full (contacts, (GDestroyNotify) g_object_unref);
-			g_free (temp_name);
-			g_list_free_full (addressbooks, (GDestroyNotify) g_object_unref);
-			g_object_unref (client_addressbook);
-			return;
+		if (contact) {
+			g_free (name_key);
+			add_email_to_contact (contact, recipient->email);
+			continue;
 		}
 
-		g_object_unref(client_addressbook);
-		aux_addressbooks = aux_addressbooks->next;
-	}
+		contact = e_contact_new ();
+		e_contact_set (contact, E_CONTACT_FULL_NAME, (gpointer) recipient->name);
 
-	g_list_free_full (addressbooks, (GDestroyNotify) g_object_unref);
+		if (file_under_as_first_last) {
+			EContactName *cnt_name = e_contact_name_from_string (recipient->name);
 
-	/* Otherwise, create a new contact. */
-	contact = e_contact_new ();
-	e_contact_set (contact, E_CONTACT_FULL_NAME, (gpointer) name);
+			if (cnt_name) {
+				if (cnt_name->family && *cnt_name->family &&
+				    cnt_name->given && *cnt_name->given) {
+					gchar *str;
 
-	settings = e_util_ref_settings (CONF_SCHEMA);
-	if (g_settings_get_boolean (settings, CONF_KEY_FILE_UNDER_AS_FIRST_LAST)) {
-		EContactName *cnt_name = e_contact_name_from_string (name);
-
-		if (cnt_name) {
-			if (cnt_name->family && *cnt_name->family &&
-			    cnt_name->given && *cnt_name->given) {
-				gchar *str;
+					str = g_strconcat (cnt_name->given, " ", cnt_name->family, NULL);
+					e_contact_set (contact, E_CONTACT_FILE_AS, str);
+					g_free (str);
+				}
 
-				str = g_strconcat (cnt_name->given, " ", cnt_name->family, NULL);
-				e_contact_set (contact, E_CONTACT_FILE_AS, str);
-				g_free (str);
+				e_contact_name_free (cnt_name);
 			}
-
-			e_contact_name_free (cnt_name);
 		}
+
+		add_email_to_contact (contact, recipient->email);
+
+		g_hash_table_insert (new_by_name, name_key, contact);
+		new_contacts = g_slist_prepend (new_contacts, contact);
 	}
-	g_clear_object (&settings);
 
-	add_email_to_contact (contact, email);
-	g_free (temp_name);
+	g_hash_table_destroy (new_by_name);
+	g_slist_free_full (recipients, bbdb_recipient_free);
+
+	new_contacts = g_slist_reverse (new_contacts);
 
-	e_book_client_add_contact_sync (client, contact, NULL, NULL, &error);
+	e_book_client_add_contacts_sync (client, new_contacts, NULL, NULL, &error);
 
 	if (error != NULL) {
-		g_warning ("bbdb: Failed to add new contact: %s", error->message);
+		g_warning ("bbdb: Failed to add new contacts: %s", error->message);
 		g_error_free (error);
 	}
 
-	g_object_unref (contact);
+	g_slist_free_full (new_contacts, g_object_unref);
 }
 
 EBookClient *